@@ -0,0 +1,172 @@
+#include "Suite.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+#include <arrow/array.h>
+#include <arrow/table.h>
+
+#include "Core/ArrowUtilities.h"
+#include "Core/Utils.h"
+#include "IO/csv.h"
+#include "Processing.h"
+#include "Sort.h"
+
+using namespace std::literals;
+
+// Inner kernels are not exported, so each is measured through the thinnest public call
+// that is dominated by it:
+//  - FilteredArrayBuilder::addInternal through filter(table, mask),
+//  - ColumnPermuter through permute(column, indices),
+//  - CsvParser::parseField and Parser::as<T> directly.
+
+namespace
+{
+    std::shared_ptr<arrow::Column> splitIntoChunks(const std::shared_ptr<arrow::Column> &column, int chunkCount)
+    {
+        const auto array = column->data()->chunk(0);
+        const auto length = array->length();
+        chunkCount = (int)std::clamp<int64_t>(chunkCount, 1, std::max<int64_t>(length, 1));
+
+        std::vector<std::shared_ptr<arrow::Array>> chunks;
+        for(int i = 0; i < chunkCount; i++)
+        {
+            const auto begin = length * i / chunkCount;
+            const auto end = length * (i + 1) / chunkCount;
+            chunks.push_back(array->Slice(begin, end - begin));
+        }
+        return std::make_shared<arrow::Column>(column->field(), std::make_shared<arrow::ChunkedArray>(chunks, array->type()));
+    }
+
+    int64_t dataBytes(const arrow::Column &column)
+    {
+        int64_t ret = 0;
+        for(auto &chunk : column.data()->chunks())
+        {
+            if(chunk->type_id() == arrow::Type::STRING)
+            {
+                const auto &strings = static_cast<const arrow::StringArray &>(*chunk);
+                ret += strings.value_offset(strings.length()) - strings.value_offset(0);
+                ret += strings.length() * sizeof(int32_t);
+            }
+            else
+            {
+                const auto &type = static_cast<const arrow::FixedWidthType &>(*chunk->type());
+                ret += chunk->length() * type.bit_width() / 8;
+            }
+        }
+        return ret;
+    }
+
+    std::shared_ptr<arrow::Column> generateKernelColumn(DataGenerator &generator, const BenchmarkSettings &settings, arrow::Type::type id, const SweepPoint &point)
+    {
+        const auto column = id == arrow::Type::STRING
+            ? generator.generateStringColumn(point.size, "values", point.nullShare, settings.data.cardinality, settings.data.stringLength)
+            : generator.generateColumn(id, point.size, "values", point.nullShare);
+        return splitIntoChunks(column, point.chunkCount);
+    }
+
+    std::shared_ptr<arrow::Buffer> randomMask(std::mt19937 &generator, int64_t length)
+    {
+        auto [buffer, data] = allocateBuffer<uint8_t>(arrow::BitUtil::BytesForBits(length));
+        std::uniform_int_distribution<int> byteDistribution{0, 255};
+        for(int64_t i = 0; i < buffer->size(); i++)
+            data[i] = (uint8_t)byteDistribution(generator);
+        return buffer;
+    }
+
+    template<typename T>
+    void runParserBenchmark(SuiteRunner &s, const std::string &typeName, const std::vector<std::string> &texts, const std::string &label)
+    {
+        s.run("kernel Parser::as<" + typeName + "> " + label, texts.size(), 0, [&]
+        {
+            int64_t parsedCount = 0;
+            for(auto &text : texts)
+                parsedCount += Parser::as<T>(text).has_value();
+            return parsedCount;
+        });
+    }
+}
+
+std::vector<BenchmarkResult> runKernelSuite(const BenchmarkSettings &settings)
+{
+    SuiteRunner s{settings};
+    DataGenerator generator{settings.seed};
+    std::mt19937 maskGenerator{settings.seed};
+
+    const std::pair<arrow::Type::type, const char *> types[] =
+    {
+        { arrow::Type::INT64, "int64" },
+        { arrow::Type::DOUBLE, "double" },
+        { arrow::Type::STRING, "string" },
+    };
+
+    for(auto &point : sweepGrid(settings.kernelSizes, settings.kernelNullShares, settings.kernelChunkCounts))
+    {
+        const auto label = point.label();
+        for(auto [id, typeName] : types)
+        {
+            const auto column = generateKernelColumn(generator, settings, id, point);
+            const auto bytes = dataBytes(*column);
+
+            const auto table = tableFromColumns({ column });
+            const auto mask = randomMask(maskGenerator, point.size);
+            s.run("kernel filter "s + typeName + " " + label, point.size, bytes, [&]
+            {
+                return filter(table, *mask);
+            });
+
+            Permutation indices(point.size);
+            std::iota(indices.begin(), indices.end(), 0);
+            std::shuffle(indices.begin(), indices.end(), maskGenerator);
+            s.run("kernel permute "s + typeName + " " + label, point.size, bytes, [&]
+            {
+                return permute(column, indices);
+            });
+        }
+    }
+
+    // parsing doesn't care about chunks
+    for(auto &point : sweepGrid(settings.kernelSizes, settings.kernelNullShares, { 1 }))
+    {
+        const auto label = point.label();
+        GeneratedTableSpec spec = settings.data;
+        spec.rowCount = point.size;
+        spec.nullShare = point.nullShare;
+        const auto table = generator.generateTable(spec);
+
+        // Parser unescapes doubled quotes in place, generated data has none of them,
+        // so the same buffer can be parsed repeatedly.
+        auto csvText = FormatCSV{}.writeToString(*table, CsvWriteOptions{});
+        s.run("kernel CsvParser::parseField " + label, point.size * table->num_columns(), csvText.size(), [&]
+        {
+            CsvParser parser{csvText};
+            int64_t fieldCount = 0;
+            while(parser.bufferIterator < parser.bufferEnd)
+            {
+                parser.parseField();
+                ++parser.bufferIterator; // skip the separator
+                ++fieldCount;
+            }
+            return fieldCount;
+        });
+
+        const auto texts = [&] (const char *columnName, auto valueTag)
+        {
+            using T = decltype(valueTag);
+            std::vector<std::string> ret;
+            const auto index = table->schema()->GetFieldIndex(columnName);
+            if(index < 0)
+                return ret;
+            for(auto &value : toVector<std::optional<T>>(*table->column(index)))
+                ret.push_back(value ? std::to_string(*value) : "");
+            return ret;
+        };
+        runParserBenchmark<int64_t>(s, "int64", texts("int0", int64_t{}), label);
+        runParserBenchmark<double>(s, "double", texts("double0", double{}), label);
+        runParserBenchmark<Timestamp>(s, "Timestamp", texts("timestamp0", Timestamp{0}), label);
+    }
+
+    return std::move(s.results);
+}
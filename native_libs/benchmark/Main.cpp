@@ -0,0 +1,144 @@
+// Standalone benchmark of library operations on generated data.
+//
+// Example:
+//   DataframeHelperBenchmarks --rows 1000000 --output results.json
+//   DataframeHelperBenchmarks --rows 1000000 --compare results.json --threshold 0.1
+//
+// With --compare the exit code is 1 if any benchmark regressed beyond the threshold.
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <string>
+
+#include "Report.h"
+#include "Suite.h"
+
+namespace
+{
+    const char *usage = R"(Options:
+  --rows N             rows in generated table (default 1000000)
+  --seed N             random generator seed (default 0)
+  --ints N             count of int64 columns (default 2)
+  --doubles N          count of double columns (default 2)
+  --strings N          count of string columns (default 1)
+  --timestamps N       count of timestamp columns (default 1)
+  --nulls F            share of nulls in all but first column of each type (default 0.1)
+  --cardinality N      distinct values in int and string columns (default 1000)
+  --string-length N    length of generated strings (default 16)
+  --xlsx-rows N        rows used for XLSX benchmarks (default 10000)
+  --warmup N           unmeasured calls before each benchmark (default 1)
+  --iterations N       minimal count of measures per benchmark (default 5)
+  --min-time MS        minimal time spent on each benchmark (default 0)
+  --filter TEXT        run only benchmarks with names containing TEXT
+  --kernels 0|1        also run kernel micro-benchmarks (default 0)
+  --kernel-sizes LIST  comma-separated row counts swept by kernels (default 10000,1000000)
+  --kernel-nulls LIST  comma-separated null shares swept by kernels (default 0,0.2)
+  --kernel-chunks LIST comma-separated chunk counts swept by kernels (default 1,16)
+  --output PATH        write JSON results to PATH (default benchmark-results.json)
+  --compare PATH       compare results against baseline JSON written earlier
+  --threshold F        median slowdown treated as regression (default 0.1)
+)";
+
+    template<typename T, typename Parse>
+    std::vector<T> parseList(const std::string &text, Parse &&parse)
+    {
+        std::vector<T> ret;
+        std::string::size_type start = 0;
+        while(start <= text.size())
+        {
+            const auto end = std::min(text.find(',', start), text.size());
+            ret.push_back(parse(text.substr(start, end - start)));
+            start = end + 1;
+        }
+        return ret;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    BenchmarkSettings settings;
+    std::string outputPath = "benchmark-results.json";
+    std::string baselinePath;
+    double threshold = 0.1;
+
+    const std::map<std::string, std::function<void(const std::string &)>> options
+    {
+        { "--rows",          [&] (auto &v) { settings.data.rowCount = std::stoll(v); } },
+        { "--seed",          [&] (auto &v) { settings.seed = (uint32_t)std::stoul(v); } },
+        { "--ints",          [&] (auto &v) { settings.data.intColumns = std::stoi(v); } },
+        { "--doubles",       [&] (auto &v) { settings.data.doubleColumns = std::stoi(v); } },
+        { "--strings",       [&] (auto &v) { settings.data.stringColumns = std::stoi(v); } },
+        { "--timestamps",    [&] (auto &v) { settings.data.timestampColumns = std::stoi(v); } },
+        { "--nulls",         [&] (auto &v) { settings.data.nullShare = std::stod(v); } },
+        { "--cardinality",   [&] (auto &v) { settings.data.cardinality = std::stoll(v); } },
+        { "--string-length", [&] (auto &v) { settings.data.stringLength = std::stoi(v); } },
+        { "--xlsx-rows",     [&] (auto &v) { settings.xlsxRowLimit = std::stoll(v); } },
+        { "--warmup",        [&] (auto &v) { settings.warmupIterations = std::stoi(v); } },
+        { "--iterations",    [&] (auto &v) { settings.iterations = std::stoll(v); } },
+        { "--min-time",      [&] (auto &v) { settings.minTime = std::chrono::milliseconds{std::stoll(v)}; } },
+        { "--filter",        [&] (auto &v) { settings.nameFilter = v; } },
+        { "--kernels",       [&] (auto &v) { settings.runKernels = std::stoi(v) != 0; } },
+        { "--kernel-sizes",  [&] (auto &v) { settings.kernelSizes = parseList<int64_t>(v, [] (const auto &s) { return std::stoll(s); }); } },
+        { "--kernel-nulls",  [&] (auto &v) { settings.kernelNullShares = parseList<double>(v, [] (const auto &s) { return std::stod(s); }); } },
+        { "--kernel-chunks", [&] (auto &v) { settings.kernelChunkCounts = parseList<int>(v, [] (const auto &s) { return std::stoi(s); }); } },
+        { "--output",        [&] (auto &v) { outputPath = v; } },
+        { "--compare",       [&] (auto &v) { baselinePath = v; } },
+        { "--threshold",     [&] (auto &v) { threshold = std::stod(v); } },
+    };
+
+    for(int i = 1; i < argc; i++)
+    {
+        const std::string option = argv[i];
+        const auto itr = options.find(option);
+        if(itr == options.end() || i + 1 == argc)
+        {
+            std::cerr << (itr == options.end() ? "unknown option " : "missing value for ") << option << "\n" << usage;
+            return 2;
+        }
+
+        try
+        {
+            itr->second(argv[++i]);
+        }
+        catch(std::exception &)
+        {
+            std::cerr << "invalid value " << argv[i] << " for " << option << "\n" << usage;
+            return 2;
+        }
+    }
+
+    try
+    {
+        // read the baseline first, so that we don't spend time on benchmarks only to fail afterwards
+        std::optional<BaselineReport> baseline;
+        if(!baselinePath.empty())
+            baseline = readReport(baselinePath);
+
+        auto results = runSuite(settings);
+        if(settings.runKernels)
+        {
+            auto kernelResults = runKernelSuite(settings);
+            results.insert(results.end(), std::make_move_iterator(kernelResults.begin()), std::make_move_iterator(kernelResults.end()));
+        }
+
+        std::ofstream out{outputPath};
+        if(!out)
+            throw std::runtime_error("cannot open " + outputPath + " for writing");
+        writeReport(out, settings, results);
+        std::cout << "Results written to " << outputPath << std::endl;
+
+        if(baseline)
+            return compareWithBaseline(std::cout, settings, results, *baseline, threshold) ? 1 : 0;
+        return 0;
+    }
+    catch(std::exception &e)
+    {
+        std::cerr << "Benchmark failed: " << e.what() << std::endl;
+        return 2;
+    }
+}
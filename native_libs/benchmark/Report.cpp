@@ -0,0 +1,159 @@
+#include "Report.h"
+
+#include <chrono>
+#include <iomanip>
+
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include "IO/IO.h"
+#include "IO/JSON.h"
+
+namespace
+{
+    template<typename Writer>
+    void writeSettings(Writer &writer, const BenchmarkSettings &settings)
+    {
+        const auto &spec = settings.data;
+        writer.StartObject();
+        writer.Key("seed"); writer.Uint(settings.seed);
+        writer.Key("rowCount"); writer.Int64(spec.rowCount);
+        writer.Key("intColumns"); writer.Int(spec.intColumns);
+        writer.Key("doubleColumns"); writer.Int(spec.doubleColumns);
+        writer.Key("stringColumns"); writer.Int(spec.stringColumns);
+        writer.Key("timestampColumns"); writer.Int(spec.timestampColumns);
+        writer.Key("nullShare"); writer.Double(spec.nullShare);
+        writer.Key("cardinality"); writer.Int64(spec.cardinality);
+        writer.Key("stringLength"); writer.Int(spec.stringLength);
+        writer.Key("xlsxRowLimit"); writer.Int64(settings.xlsxRowLimit);
+        writer.Key("warmupIterations"); writer.Int(settings.warmupIterations);
+        writer.EndObject();
+    }
+}
+
+std::string settingsToJson(const BenchmarkSettings &settings)
+{
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer{buffer};
+    writeSettings(writer, settings);
+    return buffer.GetString();
+}
+
+void writeReport(std::ostream &out, const BenchmarkSettings &settings, const std::vector<BenchmarkResult> &results)
+{
+    rapidjson::StringBuffer buffer;
+    rapidjson::PrettyWriter<rapidjson::StringBuffer> writer{buffer};
+    writer.StartObject();
+    writer.Key("settings");
+    writeSettings(writer, settings);
+
+    writer.Key("benchmarks");
+    writer.StartArray();
+    for(auto &result : results)
+    {
+        writer.StartObject();
+        writer.Key("name"); writer.String(result.name.c_str());
+        if(!result.series)
+        {
+            writer.Key("error"); writer.String(result.error.c_str());
+        }
+        else
+        {
+            const auto &series = *result.series;
+            const auto ms = [] (MeasureSeries::Duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+            writer.Key("iterations"); writer.Int64(series.times.size());
+            writer.Key("bestMs"); writer.Double(ms(series.bestTime()));
+            writer.Key("medianMs"); writer.Double(ms(series.medianTime()));
+            writer.Key("p95Ms"); writer.Double(ms(series.percentileTime(0.95)));
+            writer.Key("madMs"); writer.Double(ms(series.medianAbsoluteDeviation()));
+            if(series.itemsPerIteration)
+            {
+                writer.Key("items"); writer.Int64(series.itemsPerIteration);
+                writer.Key("itemsPerSecond"); writer.Double(series.itemsPerSecond());
+            }
+            if(series.bytesPerIteration)
+            {
+                writer.Key("bytes"); writer.Int64(series.bytesPerIteration);
+                writer.Key("bytesPerSecond"); writer.Double(series.bytesPerSecond());
+            }
+            if(!series.counters.empty())
+            {
+                const auto counters = series.medianCounters();
+                writer.Key("counters");
+                writer.StartObject();
+                writer.Key("cycles"); writer.Int64(counters.cycles);
+                writer.Key("instructions"); writer.Int64(counters.instructions);
+                writer.Key("cacheMisses"); writer.Int64(counters.cacheMisses);
+                writer.Key("branchMisses"); writer.Int64(counters.branchMisses);
+                writer.EndObject();
+            }
+            writer.Key("timesMs");
+            writer.StartArray();
+            for(auto time : series.times)
+                writer.Double(ms(time));
+            writer.EndArray();
+        }
+        writer.EndObject();
+    }
+    writer.EndArray();
+    writer.EndObject();
+
+    out << buffer.GetString() << std::endl;
+}
+
+BaselineReport readReport(std::string_view path)
+{
+    const auto contents = getFileContents(path);
+    const auto doc = parseJSON(contents.c_str());
+    if(!doc.IsObject() || !doc.HasMember("benchmarks") || !doc["benchmarks"].IsArray())
+        throw std::runtime_error("file " + std::string(path) + " is not a benchmark report");
+
+    BaselineReport ret;
+    if(doc.HasMember("settings"))
+        ret.settingsJson = toJsonString(doc["settings"]);
+
+    for(auto &benchmark : doc["benchmarks"].GetArray())
+    {
+        if(benchmark.HasMember("name") && benchmark.HasMember("medianMs"))
+            ret.medianMs[benchmark["name"].GetString()] = benchmark["medianMs"].GetDouble();
+    }
+    return ret;
+}
+
+int compareWithBaseline(std::ostream &out, const BenchmarkSettings &settings, const std::vector<BenchmarkResult> &results, const BaselineReport &baseline, double threshold)
+{
+    if(baseline.settingsJson != settingsToJson(settings))
+        out << "Warning: baseline was measured with different settings: " << baseline.settingsJson << std::endl;
+
+    int regressions = 0;
+    out << std::fixed << std::setprecision(3);
+    for(auto &result : results)
+    {
+        out << std::left << std::setw(24) << result.name << " ";
+        const auto itr = baseline.medianMs.find(result.name);
+        if(!result.series || itr == baseline.medianMs.end())
+        {
+            out << "no comparison" << std::endl;
+            continue;
+        }
+
+        const auto before = itr->second;
+        const auto after = std::chrono::duration<double, std::milli>(result.series->medianTime()).count();
+        const auto change = before > 0 ? after / before - 1 : 0.0;
+        out << before << " ms -> " << after << " ms (" << std::showpos << change * 100 << std::noshowpos << "%)";
+        if(change > threshold)
+        {
+            out << "  REGRESSION";
+            ++regressions;
+        }
+        else if(change < -threshold)
+        {
+            out << "  improvement";
+        }
+        out << std::endl;
+    }
+
+    out << regressions << " regression(s) beyond " << threshold * 100 << "% threshold" << std::endl;
+    return regressions;
+}
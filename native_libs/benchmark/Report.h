@@ -0,0 +1,25 @@
+#pragma once
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Suite.h"
+
+// Writes results as JSON document with "settings" and "benchmarks" members.
+void writeReport(std::ostream &out, const BenchmarkSettings &settings, const std::vector<BenchmarkResult> &results);
+
+struct BaselineReport
+{
+    std::string settingsJson; // as written, used only to warn about comparing different setups
+    std::map<std::string, double> medianMs; // benchmark name => median time
+};
+
+BaselineReport readReport(std::string_view path);
+std::string settingsToJson(const BenchmarkSettings &settings);
+
+// Prints comparison of results against baseline. Returns count of regressions,
+// i.e. benchmarks whose median got slower by more than the given fraction.
+int compareWithBaseline(std::ostream &out, const BenchmarkSettings &settings, const std::vector<BenchmarkResult> &results, const BaselineReport &baseline, double threshold);
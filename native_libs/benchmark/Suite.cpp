@@ -0,0 +1,126 @@
+#include "Suite.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+#include <arrow/table.h>
+
+#include "Analysis.h"
+#include "Core/ArrowUtilities.h"
+#include "IO/csv.h"
+#include "IO/Feather.h"
+#include "IO/XLSX.h"
+#include "Processing.h"
+#include "Sort.h"
+
+using namespace std::literals;
+
+namespace
+{
+    std::shared_ptr<arrow::Column> columnNamed(const arrow::Table &table, const std::string &name)
+    {
+        const auto index = table.schema()->GetFieldIndex(name);
+        if(index < 0)
+            throw std::runtime_error("generated table has no column " + name);
+        return table.column(index);
+    }
+
+    std::shared_ptr<arrow::Table> numericColumns(const arrow::Table &table)
+    {
+        std::vector<std::shared_ptr<arrow::Column>> columns;
+        for(int i = 0; i < table.num_columns(); i++)
+        {
+            const auto id = table.column(i)->type()->id();
+            if(id == arrow::Type::INT64 || id == arrow::Type::DOUBLE)
+                columns.push_back(table.column(i));
+        }
+        return tableFromColumns(columns);
+    }
+
+    // same format as DataGenerator::generateStringColumn uses
+    std::string generatedString(int64_t value, int stringLength)
+    {
+        auto text = std::to_string(value);
+        if((int)text.size() < stringLength)
+            text.insert(0, stringLength - text.size(), 's');
+        return text;
+    }
+}
+
+std::vector<BenchmarkResult> runSuite(const BenchmarkSettings &settings)
+{
+    const auto &spec = settings.data;
+    std::cout << "Generating " << spec.rowCount << " rows with seed " << settings.seed << std::endl;
+    DataGenerator generator{settings.seed};
+    const auto table = generator.generateTable(spec);
+    const auto numericTable = numericColumns(*table);
+    const auto xlsxTable = slice(table, 0, std::min(table->num_rows(), settings.xlsxRowLimit));
+
+    const auto tempDirectory = std::filesystem::temp_directory_path();
+    const auto csvPath = (tempDirectory / "dataframe-benchmark.csv").string();
+    const auto featherPath = (tempDirectory / "dataframe-benchmark.feather").string();
+    const auto xlsxPath = (tempDirectory / "dataframe-benchmark.xlsx").string();
+
+    const auto filterIntQuery = R"({"predicate": "gt", "arguments": [{"column": "int0"}, )" + std::to_string(spec.cardinality / 2) + "]}";
+    const auto filterStringQuery = R"({"predicate": "eq", "arguments": [{"column": "string0"}, ")" + generatedString(0, spec.stringLength) + "\"]}";
+    const auto mapQuery = R"({"operation": "plus", "arguments": [{"column": "double0"}, {"column": "double1"}]})"s;
+
+    SuiteRunner s{settings};
+
+    // I/O
+    s.run("csv write", [&] { FormatCSV{}.write(csvPath, *table); });
+    s.run("csv read", [&] { return FormatCSV{}.read(csvPath); });
+    s.run("feather write", [&] { FormatFeather{}.write(featherPath, *table); });
+    s.run("feather read", [&] { return FormatFeather{}.read(featherPath); });
+    s.run("xlsx write", xlsxTable->num_rows(), 0, [&] { FormatXLSX{}.write(xlsxPath, *xlsxTable); });
+    s.run("xlsx read", xlsxTable->num_rows(), 0, [&] { return FormatXLSX{}.read(xlsxPath); });
+
+    // row-wise processing
+    s.run("filter int", [&] { return filter(table, filterIntQuery.c_str()); });
+    s.run("filter string", [&] { return filter(table, filterStringQuery.c_str()); });
+    s.run("map plus", [&] { return each(table, mapQuery.c_str()); });
+    s.run("drop NA", [&] { return dropNA(table); });
+    s.run("fill NA", [&] { return fillNA(columnNamed(*table, "double1"), 0.0); });
+    s.run("interpolate NA", [&] { return interpolateNA(columnNamed(*table, "double1")); });
+
+    // sorting and grouping
+    s.run("sort int", [&] { return sortTable(table, { columnNamed(*table, "int0") }); });
+    s.run("sort string", [&] { return sortTable(table, { columnNamed(*table, "string0") }); });
+    s.run("sort int, double", [&] { return sortTable(table, { columnNamed(*table, "int0"), { columnNamed(*table, "double0"), SortOrder::Descending } }); });
+    s.run("groupBy int", [&] { return groupBy(table, columnNamed(*table, "int0")); });
+    s.run("aggregate int", [&]
+    {
+        return abominableGroupAggregate(columnNamed(*table, "int0"),
+            {
+                { columnNamed(*table, "double0"), { AggregateFunction::Minimum, AggregateFunction::Maximum, AggregateFunction::Mean, AggregateFunction::Sum } },
+                { columnNamed(*table, "int1"), { AggregateFunction::Median, AggregateFunction::Length } },
+            });
+    });
+    s.run("rolling 10s", [&]
+    {
+        return rollingInterval(columnNamed(*table, "timestamp0"), std::chrono::duration_cast<TimestampDuration>(10s),
+            { { columnNamed(*table, "double0"), { AggregateFunction::Mean } } });
+    });
+
+    // statistics
+    const auto statsColumn = [&] { return columnNamed(*table, "double1"); };
+    s.run("count values", [&] { return countValues(*columnNamed(*table, "int0")); });
+    s.run("min", [&] { return calculateMin(*statsColumn()); });
+    s.run("max", [&] { return calculateMax(*statsColumn()); });
+    s.run("mean", [&] { return calculateMean(*statsColumn()); });
+    s.run("median", [&] { return calculateMedian(*statsColumn()); });
+    s.run("variance", [&] { return calculateVariance(*statsColumn()); });
+    s.run("std", [&] { return calculateStandardDeviation(*statsColumn()); });
+    s.run("sum", [&] { return calculateSum(*statsColumn()); });
+    s.run("quantile 1/3", [&] { return calculateQuantile(*statsColumn(), 1.0 / 3.0); });
+    s.run("correlation", [&] { return calculateCorrelation(*columnNamed(*table, "double0"), *statsColumn()); });
+    s.run("correlation matrix", [&] { return calculateCorrelationMatrix(*numericTable); });
+
+    std::error_code ignored;
+    for(auto &path : { csvPath, featherPath, xlsxPath })
+        std::filesystem::remove(path, ignored);
+
+    return std::move(s.results);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Core/Benchmark.h"
+#include "Fixture.h"
+
+struct BenchmarkSettings
+{
+    GeneratedTableSpec data;
+    uint32_t seed = 0;
+    int warmupIterations = 1;
+    int64_t iterations = 5;
+    std::chrono::milliseconds minTime{0};
+    std::string nameFilter; // if not empty, only benchmarks with names containing it are run
+    int64_t xlsxRowLimit = 10'000; // XLSX is orders of magnitude slower than other formats
+
+    // kernel micro-benchmarks are run for each combination of these
+    bool runKernels = false;
+    std::vector<int64_t> kernelSizes = { 10'000, 1'000'000 };
+    std::vector<double> kernelNullShares = { 0.0, 0.2 };
+    std::vector<int> kernelChunkCounts = { 1, 16 };
+};
+
+struct BenchmarkResult
+{
+    std::string name;
+    std::optional<MeasureSeries> series; // empty if benchmark could not be run
+    std::string error;
+};
+
+class SuiteRunner
+{
+    const BenchmarkSettings &settings;
+
+public:
+    std::vector<BenchmarkResult> results;
+
+    explicit SuiteRunner(const BenchmarkSettings &settings) : settings(settings) {}
+
+    // Measures f unless filtered out by name. Exceptions are recorded as errors.
+    template<typename F>
+    void run(std::string name, int64_t items, int64_t bytes, F &&f)
+    {
+        if(!settings.nameFilter.empty() && name.find(settings.nameFilter) == std::string::npos)
+            return;
+
+        MicroBenchmarkOptions options;
+        options.warmupIterations = settings.warmupIterations;
+        options.iterations = settings.iterations;
+        options.minTime = settings.minTime;
+        options.items = items;
+        options.bytes = bytes;
+
+        BenchmarkResult result{name};
+        try
+        {
+            result.series = microBenchmark(name, options, f);
+            result.series->print(std::cout);
+        }
+        catch(std::exception &e)
+        {
+            std::cout << name << " skipped: " << e.what() << std::endl;
+            result.error = e.what();
+        }
+        results.push_back(std::move(result));
+    }
+
+    template<typename F>
+    void run(std::string name, F &&f)
+    {
+        run(std::move(name), settings.data.rowCount, 0, std::forward<F>(f));
+    }
+};
+
+// Generates dataset described by settings and measures each public operation on it.
+std::vector<BenchmarkResult> runSuite(const BenchmarkSettings &settings);
+
+// Measures inner kernels of filtering, permuting and parsing over the parameter sweep.
+std::vector<BenchmarkResult> runKernelSuite(const BenchmarkSettings &settings);
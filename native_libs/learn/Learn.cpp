@@ -1,12 +1,23 @@
 #include "Learn.h"
+#include <algorithm>
+#include <bitset>
 #include <cmath>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
 #include <arrow/array.h>
 #include <Core/ArrowUtilities.h>
+#include "Metrics.h"
+#include "NativeModels.h"
 #include "SKLearn.h"
 #include <variant.h>
 #include <LifetimeManager.h>
 #include <Analysis.h>
+#include "Core/Cancellation.h"
 #include "Core/Error.h"
+#include "Core/ThreadPool.h"
 #include "Python/PythonInterpreter.h"
 
 COMPILATION_UNIT_USING_NUMPY;
@@ -14,122 +25,326 @@ COMPILATION_UNIT_USING_NUMPY;
 namespace
 {
 
-struct NPArrayBuilder
-{
-    size_t rows, cols;
-    std::vector<double> data;
+// Objects whose last reference was dropped on a thread without the GIL. The interpreter keeps
+// the GIL on the thread that started it, so waiting for it elsewhere would block forever.
+std::mutex pendingReleaseMx;
+std::vector<PyObject *> pendingRelease;
 
-    NPArrayBuilder(size_t _rows, size_t _cols)
-        : rows(_rows), cols(_cols), data(rows * cols)
-    {}
-    void setAt(int64_t row, int64_t col, double d)
-    {
-        data[row*cols+col] = d;
-    }
-    void setAt(int64_t row, int64_t col, int64_t i)
+// Must be called with the GIL held.
+void releasePendingObjects()
+{
+    std::vector<PyObject *> toRelease;
     {
-        //if (row==0) std::cout << (double) i << std::endl;
-        data[row*cols+col] = (double) i;
+        std::unique_lock<std::mutex> lock{ pendingReleaseMx };
+        toRelease.swap(pendingRelease);
     }
-    void setAt(int64_t row, int64_t col, std::string_view)
+    for(auto object : toRelease)
+        Py_DECREF(object);
+}
+
+// Arrow buffer over numpy array's data, keeping the array alive as long as the buffer is used.
+class NumpyBuffer : public arrow::Buffer
+{
+    pybind11::object owner;
+
+public:
+    explicit NumpyBuffer(pybind11::array array)
+        : arrow::Buffer(static_cast<const uint8_t *>(array.data()), array.nbytes())
+        , owner(std::move(array))
+    {}
+    ~NumpyBuffer() override
     {
-        throw std::runtime_error("Cannot use strings with numpy array.");
+        releasePythonObject(owner);
     }
-    void setAt(int64_t row, int64_t col, Timestamp)
+};
+
+// Either wraps the numpy memory or copies it.
+std::shared_ptr<arrow::Buffer> valuesBuffer(pybind11::array array, bool zeroCopy)
+{
+    if(zeroCopy)
+        return std::make_shared<NumpyBuffer>(std::move(array));
+
+    auto [buffer, data] = allocateBuffer<uint8_t>(array.nbytes());
+    std::memcpy(data, array.data(), array.nbytes());
+    return buffer;
+}
+
+// Packs a bit per value, set when isSet(value). Bytes are filled by fixed-length
+// inner loops, so the compiler can vectorize them. Returns count of set bits.
+template<typename T, typename Predicate>
+int64_t packBits(const T *values, int64_t length, uint8_t *outBitmap, Predicate &&isSet)
+{
+    int64_t setCount = 0;
+    const auto fullBytes = length / 8;
+    for(int64_t byteIndex = 0; byteIndex < fullBytes; byteIndex++)
     {
-        throw std::runtime_error("Cannot use timestamps with numpy array.");
+        const auto batch = values + byteIndex * 8;
+        uint8_t byte = 0;
+        for(int i = 0; i < 8; i++)
+            byte |= uint8_t(isSet(batch[i])) << i;
+        outBitmap[byteIndex] = byte;
+        setCount += std::bitset<8>(byte).count();
     }
-    void setNaAt(int64_t row, int64_t col)
+    if(const auto rest = length % 8)
     {
-        data[row*cols+col] = nan(" ");
+        uint8_t byte = 0;
+        for(int i = 0; i < rest; i++)
+            byte |= uint8_t(isSet(values[fullBytes * 8 + i])) << i;
+        outBitmap[fullBytes] = byte;
+        setCount += std::bitset<8>(byte).count();
     }
-    pybind11::array getNPMatrix()
+    return setCount;
+}
+
+// NaNs become nulls. Validity bitmap is omitted when there are no NaNs.
+template<typename T>
+std::shared_ptr<arrow::Array> wrapFloatingPoint(pybind11::array array, std::shared_ptr<arrow::DataType> type, bool zeroCopy)
+{
+    const auto length = array.shape(0);
+    const auto values = static_cast<const T *>(array.data());
+    auto [validity, bitmap] = allocateBuffer<uint8_t>(arrow::BitUtil::BytesForBits(length));
+    const auto nullCount = length - packBits(values, length, bitmap, [] (T value) { return value == value; }); // only NaN is not equal to itself
+    auto data = arrow::ArrayData::Make(type, length, { nullCount ? validity : nullptr, valuesBuffer(std::move(array), zeroCopy) }, nullCount);
+    return arrow::MakeArray(data);
+}
+
+std::shared_ptr<arrow::Array> wrapInteger(pybind11::array array, std::shared_ptr<arrow::DataType> type, bool zeroCopy)
+{
+    const auto length = array.shape(0);
+    auto data = arrow::ArrayData::Make(type, length, { nullptr, valuesBuffer(std::move(array), zeroCopy) }, 0);
+    return arrow::MakeArray(data);
+}
+
+std::shared_ptr<arrow::Array> packBooleans(const pybind11::array &array)
+{
+    const auto length = array.shape(0);
+    auto [buffer, bitmap] = allocateBuffer<uint8_t>(arrow::BitUtil::BytesForBits(length));
+    packBits(static_cast<const uint8_t *>(array.data()), length, bitmap, [] (uint8_t value) { return value != 0; });
+    auto data = arrow::ArrayData::Make(arrow::boolean(), length, { nullptr, buffer }, 0);
+    return arrow::MakeArray(data);
+}
+
+using FortranMatrix = pybind11::array_t<double, pybind11::array::f_style>;
+
+FortranMatrix makeFortranMatrix(int64_t rows, size_t columns)
+{
+    initializeNumpy();
+    return FortranMatrix({(size_t)rows, columns});
+}
+
+} // anonymous namespace
+
+void releasePythonObject(pybind11::object &object)
+{
+    // after the interpreter is finalized (e.g. column released at exit) there is nothing to decref
+    if(!Py_IsInitialized())
     {
-        return pybind11::array_t<double>({rows, cols}, data.data());
+        object.release();
+        return;
     }
-    pybind11::array_t<double> getNPArr()
+
+    if(PyGILState_Check())
     {
-        return pybind11::array_t<double>(rows * cols, data.data());
+        object = pybind11::object{};
+        releasePendingObjects();
+        return;
     }
-    template<typename Iterable>
-    void addColumn(int columnIndex, const Iterable &iterable)
-    {
-        // TODO? perhaps can relax rules and fill with nulls / ignore additional values
-        if(iterable.length() != rows)
-            THROW("failed to add column with index {} to numpy matrix: it has {} rows while expected {}", columnIndex, iterable.length(), rows);
 
-        int64_t rowIndex = 0;
-        iterateOverGeneric(iterable,
-            [&](auto&& elem)
+    std::unique_lock<std::mutex> lock{ pendingReleaseMx };
+    pendingRelease.push_back(object.release().ptr());
+}
+
+// Values are converted chunk by chunk, with whole-chunk loops the compiler can vectorize,
+// and only the null positions are then patched using the validity bitmap.
+void writeAsDoubles(const arrow::Column &column, double *out)
+{
+    for(auto &chunk : column.data()->chunks())
+    {
+        const auto length = chunk->length();
+        visitType(*chunk->type(), [&] (auto id)
+        {
+            constexpr auto type = id.value;
+            if constexpr(type == arrow::Type::STRING)
+                THROW("Cannot use strings with numpy array.");
+            else if constexpr(type == arrow::Type::TIMESTAMP)
+                THROW("Cannot use timestamps with numpy array.");
+            else if constexpr(type == arrow::Type::BOOL)
             {
-                setAt(rowIndex, columnIndex, elem);
-                rowIndex++;
-            },
-            [&]()
+                auto target = out;
+                iterateOver<type>(*chunk,
+                    [&] (bool value) { *target++ = value; },
+                    [&] () { *target++ = std::numeric_limits<double>::quiet_NaN(); });
+            }
+            else
             {
-                setNaAt(rowIndex, columnIndex);
-                rowIndex++;
-            });
+                using T = typename TypeDescription<type>::StorageValueType;
+                const auto values = rawValues<T>(*chunk);
+                if constexpr(std::is_same_v<T, double>)
+                    std::memcpy(out, values, length * sizeof(double));
+                else
+                    for(int64_t i = 0; i < length; i++)
+                        out[i] = static_cast<double>(values[i]);
+
+                if(chunk->null_count() == 0)
+                    return;
+
+                const auto bitmap = chunk->null_bitmap_data();
+                for(int64_t start = 0; start < length; start += 64)
+                {
+                    const auto batchLength = (int)std::min<int64_t>(64, length - start);
+                    const auto allValid = batchLength == 64 ? ~uint64_t(0) : (uint64_t(1) << batchLength) - 1;
+                    for(auto invalid = ~loadBits(bitmap, chunk->offset() + start, batchLength) & allValid; invalid; invalid &= invalid - 1)
+                        out[start + countTrailingZeros(invalid)] = std::numeric_limits<double>::quiet_NaN();
+                }
+            }
+        });
+        out += length;
     }
-};
+}
 
-auto fromC(PyObject *obj)
+// The matrix is Fortran-ordered, so that each column is contiguous and can be written
+// directly into the numpy-owned buffer, independently of the other columns.
+pybind11::array tableToNpMatrix(const arrow::Table& table)
 {
-    return pybind11::reinterpret_borrow<pybind11::object>(obj);
+    const auto rows = table.num_rows();
+    const auto columns = getColumns(table);
+    auto matrix = makeFortranMatrix(rows, columns.size());
+    const auto data = matrix.mutable_data();
+    parallelForEach(columns.size(), [&] (int64_t columnIndex)
+    {
+        const auto &column = *columns[columnIndex];
+        if(column.length() != rows)
+            THROW("failed to add column with index {} to numpy matrix: it has {} rows while expected {}", columnIndex, column.length(), rows);
+        writeAsDoubles(column, data + columnIndex * rows);
+    });
+    return matrix;
 }
 
-auto passToC(pybind11::object obj)
+pybind11::array_t<double> columnToNpArr(const arrow::Column &col)
 {
-    return obj.release().ptr();
+    initializeNumpy();
+    pybind11::array_t<double> ret(col.length());
+    writeAsDoubles(col, ret.mutable_data());
+    return ret;
 }
 
-} // anonymous namespace
-
-pybind11::array tableToNpMatrix(const arrow::Table& table)
+// Arrays that are not contiguous or not in native byte order are first converted by numpy
+// (and then need not be copied again). Booleans are packed into a bitmap.
+std::shared_ptr<arrow::Column> npArrayToColumn(pybind11::array arr, std::string name, bool zeroCopy)
 {
-    NPArrayBuilder builder( table.num_rows(), table.num_columns() );
-    auto cols = getColumns(table);
-    int colIndex = 0;
-    for (auto& col : cols)
+    releasePendingObjects();
+    if(arr.ndim() != 1)
+        THROW("cannot convert numpy array with {} dimensions to a column, expected 1", arr.ndim());
+    if(!arr.dtype().attr("isnative").cast<bool>())
     {
-        builder.addColumn(colIndex++, *col);
+        arr = pybind11::array::ensure(arr.attr("astype")(arr.dtype().attr("newbyteorder")("=")));
+        zeroCopy = true;
     }
-    auto res = builder.getNPMatrix();
-    //PyObject_Print(res, stdout, 0);
-    return res;
+    if(!(arr.flags() & pybind11::array::c_style))
+    {
+        arr = pybind11::array::ensure(arr, pybind11::array::c_style);
+        zeroCopy = true;
+    }
+
+    const auto dtype = arr.dtype();
+    const auto kind = dtype.kind();
+    const auto size = dtype.itemsize();
+    const auto array = [&] () -> std::shared_ptr<arrow::Array>
+    {
+        if(kind == 'f' && size == 8) return wrapFloatingPoint<double>(arr, arrow::float64(), zeroCopy);
+        if(kind == 'f' && size == 4) return wrapFloatingPoint<float>(arr, arrow::float32(), zeroCopy);
+        if(kind == 'i' && size == 8) return wrapInteger(arr, arrow::int64(), zeroCopy);
+        if(kind == 'i' && size == 4) return wrapInteger(arr, arrow::int32(), zeroCopy);
+        if(kind == 'i' && size == 2) return wrapInteger(arr, arrow::int16(), zeroCopy);
+        if(kind == 'i' && size == 1) return wrapInteger(arr, arrow::int8(), zeroCopy);
+        if(kind == 'u' && size == 8) return wrapInteger(arr, arrow::uint64(), zeroCopy);
+        if(kind == 'u' && size == 4) return wrapInteger(arr, arrow::uint32(), zeroCopy);
+        if(kind == 'u' && size == 2) return wrapInteger(arr, arrow::uint16(), zeroCopy);
+        if(kind == 'u' && size == 1) return wrapInteger(arr, arrow::uint8(), zeroCopy);
+        if(kind == 'b' && size == 1) return packBooleans(arr);
+        THROW("cannot convert numpy array of dtype {} to a column", (std::string)pybind11::str(dtype));
+    }();
+    return toColumn(array, name);
 }
 
-pybind11::array_t<double> columnToNpArr(const arrow::Column &col)
+CategoryCodes encodeCategories(const arrow::Column &column)
+{
+    if(column.type()->id() != arrow::Type::STRING)
+        THROW("one-hot encoding needs a string column, {} has type {}", column.name(), column.type()->ToString());
+
+    CategoryCodes ret;
+    ret.codes.reserve(column.length());
+    std::unordered_map<std::string_view, int32_t> codeByCategory; // views point into the column's data
+    iterateOver<arrow::Type::STRING>(column,
+        [&] (std::string_view elem)
+        {
+            auto [itr, inserted] = codeByCategory.try_emplace(elem, (int32_t)ret.categories.size());
+            if(inserted)
+                ret.categories.emplace_back(elem);
+            ret.codes.push_back(itr->second);
+        },
+        [&] () { ret.codes.push_back(-1); });
+    return ret;
+}
+
+std::shared_ptr<arrow::Table> encodeOneHot(const arrow::Column &column)
 {
-    NPArrayBuilder builder( col.length(), 1 );
-    builder.addColumn(0, col);
-    auto res = builder.getNPArr();
-    //PyObject_Print(res, stdout, 0);
-    return res;
+    const auto encoded = encodeCategories(column);
+    const auto rows = (int64_t)encoded.codes.size();
+
+    // zeroed column per category, then a single 1 scattered for each non-null row
+    std::vector<std::shared_ptr<arrow::Buffer>> buffers;
+    std::vector<double *> values;
+    for(size_t i = 0; i < encoded.categories.size(); i++)
+    {
+        auto [buffer, data] = allocateBuffer<double>(rows);
+        std::fill_n(data, rows, 0.0);
+        buffers.push_back(buffer);
+        values.push_back(data);
+    }
+    for(int64_t row = 0; row < rows; row++)
+        if(const auto code = encoded.codes[row]; code >= 0)
+            values[code][row] = 1;
+
+    std::vector<PossiblyChunkedArray> arrays;
+    std::vector<std::string> names;
+    for(size_t i = 0; i < encoded.categories.size(); i++)
+    {
+        arrays.push_back(arrow::MakeArray(arrow::ArrayData::Make(arrow::float64(), rows, { nullptr, buffers[i] }, 0)));
+        names.push_back(column.name() + ": " + encoded.categories[i]);
+    }
+    return tableFromArrays(arrays, names);
 }
 
-std::shared_ptr<arrow::Column> npArrayToColumn(pybind11::array_t<double> arr, std::string name)
+pybind11::object encodeOneHotSparse(const arrow::Column &column)
 {
-    // TODO: check that this is 1-D array
-    // TODO: check that array contains doubles
-    auto size = arr.shape(0);
-    auto data = (const double *) arr.data();
+    initializeNumpy();
+    const auto encoded = encodeCategories(column);
+    const auto rows = (int64_t)encoded.codes.size();
+    const auto nonNullCount = rows - std::count(encoded.codes.begin(), encoded.codes.end(), -1);
 
-    // TODO: check that array is contiguous
-    arrow::DoubleBuilder builder;
-    for(size_t i = 0; i < size; ++i)
+    pybind11::array_t<double> data(nonNullCount);
+    pybind11::array_t<int32_t> indices(nonNullCount);
+    pybind11::array_t<int64_t> rowStarts(rows + 1);
+    std::fill_n(data.mutable_data(), nonNullCount, 1.0);
+    auto indicesData = indices.mutable_data();
+    auto rowStartsData = rowStarts.mutable_data();
+    int64_t written = 0;
+    for(int64_t row = 0; row < rows; row++)
     {
-        auto value = data[i];
-        if(std::isnan(value))
-            builder.AppendNull();
-        else
-            builder.Append(value);
+        rowStartsData[row] = written;
+        if(encoded.codes[row] >= 0)
+            indicesData[written++] = encoded.codes[row];
     }
-    return toColumn(finish(builder), name);
+    rowStartsData[rows] = written;
+
+    const auto csrMatrix = pybind11::module::import("scipy.sparse").attr("csr_matrix");
+    return csrMatrix(pybind11::make_tuple(data, indices, rowStarts), "shape"_a = pybind11::make_tuple(rows, encoded.categories.size()));
 }
 
 void sklearn::fit(pybind11::object model, const arrow::Table &xs, const arrow::Column &y)
 {
+    releasePendingObjects();
     auto xsO = tableToNpMatrix(xs);
     auto yO = columnToNpArr(y);
     sklearn::fit(model, xsO, yO);
@@ -142,20 +357,44 @@ double sklearn::score(pybind11::object model, const arrow::Table &xs, const arro
     return sklearn::score(model, xsO, yO);
 }
 
-std::shared_ptr<arrow::Column> sklearn::predict(pybind11::object model, const arrow::Table &xs)
+// Only a block of rows is exported at a time, so memory used for the features doesn't
+// depend on the table's length. All full blocks are written to the same numpy matrix.
+std::shared_ptr<arrow::Column> sklearn::predict(pybind11::object model, const arrow::Table &xs, int64_t batchRows)
 {
-    auto xsO = tableToNpMatrix(xs);
-    auto yO = sklearn::predict(model, xsO);
-    auto predictedColumn = npArrayToColumn(yO, "Predictions");
-    return predictedColumn;
-}
+    if(batchRows <= 0)
+        THROW("batch must have at least one row, got {}", batchRows);
 
-std::shared_ptr<arrow::Table> sklearn::confusionMatrix(const arrow::Column &ytrue, const arrow::Column &ypred)
-{
-    auto c1 = columnToNpArr(ytrue);
-    auto c2 = columnToNpArr(ypred);
-    auto t1 = sklearn::confusion_matrix(c1, c2);
-    THROW("not implemented");
+    const auto rows = xs.num_rows();
+    const auto columns = getColumns(xs);
+    auto [predictions, predictionsData] = allocateBuffer<double>(rows);
+
+    std::optional<FortranMatrix> fullBatch;
+    for(int64_t from = 0; from < rows; from += batchRows)
+    {
+        checkCancellation();
+        const auto length = std::min(batchRows, rows - from);
+        if(length == batchRows && !fullBatch)
+            fullBatch = makeFortranMatrix(length, columns.size());
+        auto batch = length == batchRows ? *fullBatch : makeFortranMatrix(length, columns.size());
+
+        const auto data = batch.mutable_data();
+        parallelForEach(columns.size(), [&] (int64_t columnIndex)
+        {
+            writeAsDoubles(*columns[columnIndex]->Slice(from, length), data + columnIndex * length);
+        });
+
+        using PredictionsArray = pybind11::array_t<double, pybind11::array::c_style | pybind11::array::forcecast>;
+        const auto predicted = PredictionsArray::ensure(sklearn::predict(model, batch));
+        if(!predicted || predicted.ndim() != 1 || predicted.shape(0) != length)
+            THROW("model was expected to return a single prediction for each of {} rows", length);
+        std::memcpy(predictionsData + from, predicted.data(), length * sizeof(double));
+    }
+
+    // NaN predictions are nulls, as with npArrayToColumn
+    auto [validity, bitmap] = allocateBuffer<uint8_t>(arrow::BitUtil::BytesForBits(rows));
+    const auto nullCount = rows - packBits(predictionsData, rows, bitmap, [] (double value) { return value == value; });
+    auto data = arrow::ArrayData::Make(arrow::float64(), rows, { nullCount ? validity : nullptr, predictions }, nullCount);
+    return toColumn(arrow::MakeArray(data), "Predictions");
 }
 
 extern "C"
@@ -177,43 +416,60 @@ EXPORT void freePyObj(PyObject* o, const char **outError) noexcept
     };
 }
 
-EXPORT PyObject* newLogisticRegression(double C, const char **outError) noexcept
+EXPORT learn::Model* newLogisticRegression(double C, const char **outError) noexcept
 {
     return TRANSLATE_EXCEPTION(outError)
     {
-        return passToC(sklearn::newLogisticRegression(C));
+        return LifetimeManager::instance().addOwnership(std::shared_ptr<learn::Model>(std::make_shared<learn::LogisticRegression>(C)));
     };
 }
 
-EXPORT PyObject* newLinearRegression(const char **outError) noexcept
+EXPORT learn::Model* newLinearRegression(const char **outError) noexcept
 {
     return TRANSLATE_EXCEPTION(outError)
     {
-        return passToC(sklearn::newLinearRegression());
+        return LifetimeManager::instance().addOwnership(std::shared_ptr<learn::Model>(std::make_shared<learn::LinearRegression>()));
     };
 }
 
-EXPORT void fit(PyObject* model, const arrow::Table *xs, const arrow::Column *y, const char **outError) noexcept
+EXPORT learn::Model* newRidgeRegression(double alpha, const char **outError) noexcept
 {
     return TRANSLATE_EXCEPTION(outError)
     {
-        return sklearn::fit(fromC(model), *xs, *y);
+        return LifetimeManager::instance().addOwnership(std::shared_ptr<learn::Model>(std::make_shared<learn::LinearRegression>(alpha)));
     };
 }
 
-EXPORT double score(PyObject* model, const arrow::Table* xs, const arrow::Column* y, const char **outError) noexcept
+EXPORT void fit(learn::Model* model, const arrow::Table *xs, const arrow::Column *y, const char **outError) noexcept
 {
     return TRANSLATE_EXCEPTION(outError)
     {
-        return sklearn::score(fromC(model), *xs, *y);
+        LifetimeManager::instance().accessOwned(model)->fit(*xs, *y);
     };
 }
 
-EXPORT arrow::Column* predict(PyObject* model, const arrow::Table* xs, const char **outError) noexcept
+EXPORT double score(learn::Model* model, const arrow::Table* xs, const arrow::Column* y, const char **outError) noexcept
 {
     return TRANSLATE_EXCEPTION(outError)
     {
-        auto ret = sklearn::predict(fromC(model), *xs);
+        return LifetimeManager::instance().accessOwned(model)->score(*xs, *y);
+    };
+}
+
+EXPORT arrow::Column* predict(learn::Model* model, const arrow::Table* xs, const char **outError) noexcept
+{
+    return TRANSLATE_EXCEPTION(outError)
+    {
+        auto ret = LifetimeManager::instance().accessOwned(model)->predict(*xs);
+        return LifetimeManager::instance().addOwnership(ret);
+    };
+}
+
+EXPORT arrow::Column* predictInBatches(learn::Model* model, const arrow::Table* xs, int64_t batchRows, const char **outError) noexcept
+{
+    return TRANSLATE_EXCEPTION(outError)
+    {
+        auto ret = LifetimeManager::instance().accessOwned(model)->predictInBatches(*xs, batchRows);
         return LifetimeManager::instance().addOwnership(ret);
     };
 }
@@ -222,53 +478,41 @@ EXPORT arrow::Table* confusionMatrix(const arrow::Column* ytrue, const arrow::Co
 {
     return TRANSLATE_EXCEPTION(outError)
     {
-        auto ret = sklearn::confusionMatrix(*ytrue, *ypred);
+        auto ret = learn::confusionMatrixTable(learn::confusionMatrix(*ytrue, *ypred));
+        return LifetimeManager::instance().addOwnership(ret);
+    };
+}
+
+EXPORT double accuracyScore(const arrow::Column* ytrue, const arrow::Column* ypred, const char **outError) noexcept
+{
+    return TRANSLATE_EXCEPTION(outError)
+    {
+        return learn::accuracy(*ytrue, *ypred);
+    };
+}
+
+EXPORT arrow::Table* classificationReport(const arrow::Column* ytrue, const arrow::Column* ypred, const char **outError) noexcept
+{
+    return TRANSLATE_EXCEPTION(outError)
+    {
+        auto ret = learn::classificationMetrics(*ytrue, *ypred);
         return LifetimeManager::instance().addOwnership(ret);
     };
 }
 
+EXPORT double rocAucScore(const arrow::Column* ytrue, const arrow::Column* scores, const char **outError) noexcept
+{
+    return TRANSLATE_EXCEPTION(outError)
+    {
+        return learn::rocAuc(*ytrue, *scores);
+    };
+}
+
 EXPORT arrow::Table* oneHotEncode(const arrow::Column* col, const char **outError) noexcept
 {
     return TRANSLATE_EXCEPTION(outError)
     {
-        std::unordered_map<std::string_view, int> valIndexes;
-        int lastIndex = 0;
-        iterateOver<arrow::Type::STRING>(*col,
-            [&](auto &&elem)
-            {
-                if (valIndexes.find(elem)==valIndexes.end()) 
-                    valIndexes[elem] = lastIndex++;
-            },
-            []() { });
-        std::vector<arrow::DoubleBuilder> builders(valIndexes.size());
-        iterateOver<arrow::Type::STRING>(*col,
-            [&](auto &&elem)
-            {
-                int ind = valIndexes[elem];
-                for (int i = 0; i<builders.size(); i++)
-                {
-                    builders[i].Append(i==ind ? 1 : 0);
-                }
-            },
-            [&]()
-            {
-                for (int i = 0; i<builders.size(); i++)
-                {
-                    builders[i].Append(0);
-                }
-            });
-        std::vector<PossiblyChunkedArray> arrs;
-        for (auto& bldr : builders)
-        {
-            arrs.push_back(finish(bldr));
-        }
-        std::vector<std::string> names(valIndexes.size());
-        for (auto& item : valIndexes)
-        {
-            names[item.second] = col->name()+": "+std::string(item.first);
-        }
-        auto t = tableFromArrays(arrs, names);
-        return LifetimeManager::instance().addOwnership(std::move(t));
+        return LifetimeManager::instance().addOwnership(encodeOneHot(*col));
     };
 }
 
@@ -276,6 +520,7 @@ EXPORT arrow::Table* oneHotEncode(const arrow::Column* col, const char **outErro
 
 sklearn::interpreter& sklearn::interpreter::get()
 {
+    initializeNumpy();
     static sklearn::interpreter ctx;
     return ctx;
 }
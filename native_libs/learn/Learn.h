@@ -1,5 +1,10 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include <Core/Common.h>
 #include "Python/IncludePython.h"
 
@@ -10,27 +15,65 @@ namespace arrow
     class Table;
 }
 
+namespace learn
+{
+    class Model;
+}
+
+// Writes column.length() values of the column as doubles to `out`, nulls are written as NaN.
+EXPORT void writeAsDoubles(const arrow::Column &column, double *out);
+
 EXPORT pybind11::array_t<double> columnToNpArr(const arrow::Column &col);
-EXPORT std::shared_ptr<arrow::Column> npArrayToColumn(pybind11::array_t<double> arr, std::string name);
+// Values are copied, unless zeroCopy is set: then the column shares numpy's memory and
+// keeps the array alive. Python holds the GIL only on the thread that started it, so such
+// column should be released there; if it is released elsewhere, the array is freed on the
+// next call to this function.
+EXPORT std::shared_ptr<arrow::Column> npArrayToColumn(pybind11::array arr, std::string name, bool zeroCopy = false);
 EXPORT pybind11::array tableToNpMatrix(const arrow::Table& table);
 
+// Drops the reference from any thread. Without the GIL, the object is released later,
+// by the next npArrayToColumn or sklearn::fit call.
+EXPORT void releasePythonObject(pybind11::object &object);
+
+// Categories of a string column in order of their first appearance, and category index
+// of each row (-1 for null).
+struct CategoryCodes
+{
+    std::vector<std::string> categories;
+    std::vector<int32_t> codes;
+};
+
+EXPORT CategoryCodes encodeCategories(const arrow::Column &column);
+EXPORT std::shared_ptr<arrow::Table> encodeOneHot(const arrow::Column &column); // double column per category, null rows are all zeros
+// scipy.sparse.csr_matrix of rows x categories, to be given to sklearn estimators directly.
+// Not exported to C, as models behind the C API take only tables.
+EXPORT pybind11::object encodeOneHotSparse(const arrow::Column &column);
+
 namespace sklearn
 {
     EXPORT void fit(pybind11::object model, const arrow::Table &xs, const arrow::Column &y);
     EXPORT double score(pybind11::object model, const arrow::Table &xs, const arrow::Column &y);
-    EXPORT std::shared_ptr<arrow::Column> predict(pybind11::object model, const arrow::Table &xs);
-    EXPORT std::shared_ptr<arrow::Table> confusionMatrix(const arrow::Column &ytrue, const arrow::Column &ypred);
+    constexpr int64_t DefaultPredictBatchRows = 64 * 1024;
+
+    // Features are exported to numpy in blocks of batchRows rows, predictions are collected into a single column.
+    EXPORT std::shared_ptr<arrow::Column> predict(pybind11::object model, const arrow::Table &xs, int64_t batchRows = DefaultPredictBatchRows);
 }
 
 extern "C"
 {
     EXPORT void toNpArr(const arrow::Table* tb, const char **outError) noexcept;
     EXPORT void freePyObj(PyObject* o, const char **outError) noexcept;
-    EXPORT PyObject* newLogisticRegression(double C, const char **outError) noexcept;
-    EXPORT PyObject* newLinearRegression(const char **outError) noexcept;
-    EXPORT void fit(PyObject* model, const arrow::Table *xs, const arrow::Column *y, const char **outError) noexcept;
-    EXPORT double score(PyObject* model, const arrow::Table* xs, const arrow::Column* y, const char **outError) noexcept;
-    EXPORT arrow::Column* predict(PyObject* model, const arrow::Table* xs, const char **outError) noexcept;
+    // models are managed like tables and columns: they are freed with release, not freePyObj
+    EXPORT learn::Model* newLogisticRegression(double C, const char **outError) noexcept;
+    EXPORT learn::Model* newLinearRegression(const char **outError) noexcept;
+    EXPORT learn::Model* newRidgeRegression(double alpha, const char **outError) noexcept;
+    EXPORT void fit(learn::Model* model, const arrow::Table *xs, const arrow::Column *y, const char **outError) noexcept;
+    EXPORT double score(learn::Model* model, const arrow::Table* xs, const arrow::Column* y, const char **outError) noexcept;
+    EXPORT arrow::Column* predict(learn::Model* model, const arrow::Table* xs, const char **outError) noexcept;
+    EXPORT arrow::Column* predictInBatches(learn::Model* model, const arrow::Table* xs, int64_t batchRows, const char **outError) noexcept;
     EXPORT arrow::Table* confusionMatrix(const arrow::Column* ytrue, const arrow::Column* ypred, const char **outError) noexcept;
+    EXPORT double accuracyScore(const arrow::Column* ytrue, const arrow::Column* ypred, const char **outError) noexcept;
+    EXPORT arrow::Table* classificationReport(const arrow::Column* ytrue, const arrow::Column* ypred, const char **outError) noexcept;
+    EXPORT double rocAucScore(const arrow::Column* ytrue, const arrow::Column* scores, const char **outError) noexcept;
     EXPORT arrow::Table* oneHotEncode(const arrow::Column* col, const char **outError) noexcept;
 }
\ No newline at end of file
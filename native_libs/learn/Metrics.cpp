@@ -0,0 +1,233 @@
+#include "Metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+#include <arrow/array.h>
+#include <arrow/table.h>
+
+#include <Core/ArrowUtilities.h>
+#include "Learn.h"
+
+namespace
+{
+    template<typename Key>
+    int32_t codeFor(std::unordered_map<Key, int32_t> &codeByLabel, std::vector<Key> &classes, Key label)
+    {
+        auto [itr, inserted] = codeByLabel.try_emplace(label, (int32_t)classes.size());
+        if(inserted)
+            classes.push_back(label);
+        return itr->second;
+    }
+
+    // Codes were given in order of first appearance, this renumbers them in order of labels.
+    template<typename Key>
+    void sortClasses(std::vector<Key> &classes, std::vector<std::vector<int32_t>> &codes)
+    {
+        std::vector<int32_t> order(classes.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&] (int32_t lhs, int32_t rhs) { return classes[lhs] < classes[rhs]; });
+
+        std::vector<int32_t> newCode(classes.size());
+        std::vector<Key> sorted;
+        sorted.reserve(classes.size());
+        for(size_t i = 0; i < order.size(); i++)
+        {
+            newCode[order[i]] = (int32_t)i;
+            sorted.push_back(classes[order[i]]);
+        }
+        classes = std::move(sorted);
+
+        for(auto &columnCodes : codes)
+            for(auto &code : columnCodes)
+                if(code >= 0)
+                    code = newCode[code];
+    }
+
+    std::string labelText(const learn::LabelCodes &labels, int32_t code)
+    {
+        return visit(overloaded{
+            [&] (const std::vector<double> &classes) { return fmt::format("{}", classes[code]); },
+            [&] (const std::vector<std::string> &classes) { return classes[code]; }
+            }, labels.classes);
+    }
+
+    void validateLengths(const arrow::Column &lhs, const arrow::Column &rhs)
+    {
+        if(lhs.length() != rhs.length())
+            THROW("columns {} and {} have different lengths: {} and {}", lhs.name(), rhs.name(), lhs.length(), rhs.length());
+    }
+}
+
+namespace learn
+{
+    int32_t LabelCodes::classCount() const
+    {
+        return visit([] (auto &&classes) { return (int32_t)classes.size(); }, this->classes);
+    }
+
+    LabelCodes encodeLabels(const std::vector<const arrow::Column *> &columns)
+    {
+        if(columns.empty())
+            THROW("no label column to encode");
+
+        const auto isString = columns.front()->type()->id() == arrow::Type::STRING;
+        for(auto column : columns)
+            if((column->type()->id() == arrow::Type::STRING) != isString)
+                THROW("labels must be either all strings or all numbers, column {} has type {}", column->name(), column->type()->ToString());
+
+        LabelCodes ret;
+        if(isString)
+        {
+            // views point into columns' data, that outlive them
+            std::unordered_map<std::string_view, int32_t> codeByLabel;
+            std::vector<std::string_view> classes;
+            for(auto column : columns)
+            {
+                auto &codes = ret.codes.emplace_back();
+                codes.reserve(column->length());
+                iterateOver<arrow::Type::STRING>(*column,
+                    [&] (std::string_view label) { codes.push_back(codeFor(codeByLabel, classes, label)); },
+                    [&] () { codes.push_back(-1); });
+            }
+            sortClasses(classes, ret.codes);
+            ret.classes = std::vector<std::string>(classes.begin(), classes.end());
+        }
+        else
+        {
+            std::unordered_map<double, int32_t> codeByLabel;
+            std::vector<double> classes;
+            for(auto column : columns)
+            {
+                std::vector<double> values(column->length());
+                writeAsDoubles(*column, values.data());
+
+                auto &codes = ret.codes.emplace_back();
+                codes.reserve(values.size());
+                for(auto value : values)
+                    codes.push_back(std::isnan(value) ? -1 : codeFor(codeByLabel, classes, value == 0 ? 0.0 : value)); // -0.0 hashes differently
+            }
+            sortClasses(classes, ret.codes);
+            ret.classes = std::move(classes);
+        }
+        return ret;
+    }
+
+    ConfusionMatrix confusionMatrix(const arrow::Column &yTrue, const arrow::Column &yPredicted)
+    {
+        validateLengths(yTrue, yPredicted);
+
+        ConfusionMatrix ret;
+        ret.labels = encodeLabels({ &yTrue, &yPredicted });
+        const auto classCount = ret.labels.classCount();
+        ret.counts.assign(classCount * classCount, 0);
+
+        const auto &trueCodes = ret.labels.codes[0];
+        const auto &predictedCodes = ret.labels.codes[1];
+        for(size_t i = 0; i < trueCodes.size(); i++)
+            if(trueCodes[i] >= 0 && predictedCodes[i] >= 0)
+                ret.counts[trueCodes[i] * classCount + predictedCodes[i]]++;
+
+        ret.labels.codes.clear();
+        return ret;
+    }
+
+    std::shared_ptr<arrow::Table> confusionMatrixTable(const ConfusionMatrix &matrix)
+    {
+        const auto classCount = matrix.labels.classCount();
+        std::vector<PossiblyChunkedArray> arrays;
+        std::vector<std::string> names;
+        arrays.push_back(visit([] (auto &&classes) { return toArray(classes); }, matrix.labels.classes));
+        names.push_back("class");
+        for(int32_t predicted = 0; predicted < classCount; predicted++)
+        {
+            std::vector<int64_t> counts(classCount);
+            for(int32_t actual = 0; actual < classCount; actual++)
+                counts[actual] = matrix.at(actual, predicted);
+            arrays.push_back(toArray(counts));
+            names.push_back(labelText(matrix.labels, predicted));
+        }
+        return tableFromArrays(arrays, names);
+    }
+
+    double accuracy(const arrow::Column &yTrue, const arrow::Column &yPredicted)
+    {
+        const auto matrix = confusionMatrix(yTrue, yPredicted);
+        const auto total = std::accumulate(matrix.counts.begin(), matrix.counts.end(), int64_t(0));
+        if(total == 0)
+            THROW("accuracy is undefined without rows having both labels");
+
+        int64_t correct = 0;
+        for(int32_t i = 0; i < matrix.labels.classCount(); i++)
+            correct += matrix.at(i, i);
+        return double(correct) / total;
+    }
+
+    std::shared_ptr<arrow::Table> classificationMetrics(const arrow::Column &yTrue, const arrow::Column &yPredicted)
+    {
+        const auto matrix = confusionMatrix(yTrue, yPredicted);
+        const auto classCount = matrix.labels.classCount();
+        const auto ratio = [] (double numerator, double denominator) { return denominator ? numerator / denominator : 0.0; };
+
+        std::vector<double> precision, recall, f1;
+        std::vector<int64_t> support;
+        for(int32_t i = 0; i < classCount; i++)
+        {
+            int64_t predictedCount = 0, actualCount = 0;
+            for(int32_t j = 0; j < classCount; j++)
+            {
+                predictedCount += matrix.at(j, i);
+                actualCount += matrix.at(i, j);
+            }
+            precision.push_back(ratio(matrix.at(i, i), predictedCount));
+            recall.push_back(ratio(matrix.at(i, i), actualCount));
+            f1.push_back(ratio(2 * precision.back() * recall.back(), precision.back() + recall.back()));
+            support.push_back(actualCount);
+        }
+
+        const auto classes = visit([] (auto &&classes) { return toArray(classes); }, matrix.labels.classes);
+        return tableFromArrays({ classes, toArray(precision), toArray(recall), toArray(f1), toArray(support) }, { "class", "precision", "recall", "f1", "support" });
+    }
+
+    double rocAuc(const arrow::Column &yTrue, const arrow::Column &scores)
+    {
+        validateLengths(yTrue, scores);
+        const auto labels = encodeLabels({ &yTrue });
+        if(labels.classCount() != 2)
+            THROW("ROC AUC needs exactly two classes, got {}", labels.classCount());
+
+        std::vector<double> scoreValues(scores.length());
+        writeAsDoubles(scores, scoreValues.data());
+
+        std::vector<std::pair<double, bool>> scored; // score, is positive
+        scored.reserve(scoreValues.size());
+        const auto &codes = labels.codes[0];
+        for(size_t i = 0; i < codes.size(); i++)
+            if(codes[i] >= 0 && !std::isnan(scoreValues[i]))
+                scored.emplace_back(scoreValues[i], codes[i] == 1);
+        std::sort(scored.begin(), scored.end(), [] (auto &&lhs, auto &&rhs) { return lhs.first < rhs.first; });
+
+        // Mann-Whitney U statistic: sum of positives' ranks, tied scores get their average rank
+        int64_t positiveCount = 0;
+        double positiveRankSum = 0;
+        for(size_t groupStart = 0; groupStart < scored.size(); )
+        {
+            auto groupEnd = groupStart;
+            int64_t positivesInGroup = 0;
+            for(; groupEnd < scored.size() && scored[groupEnd].first == scored[groupStart].first; groupEnd++)
+                positivesInGroup += scored[groupEnd].second;
+
+            const auto averageRank = (groupStart + 1 + groupEnd) / 2.0;
+            positiveRankSum += averageRank * positivesInGroup;
+            positiveCount += positivesInGroup;
+            groupStart = groupEnd;
+        }
+
+        const auto negativeCount = (int64_t)scored.size() - positiveCount;
+        if(positiveCount == 0 || negativeCount == 0)
+            THROW("ROC AUC is undefined when only one class is present");
+        return (positiveRankSum - positiveCount * (positiveCount + 1) / 2.0) / (double(positiveCount) * negativeCount);
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Core/Common.h>
+#include <variant.h>
+
+namespace arrow
+{
+    class Column;
+    class Table;
+}
+
+// Classification metrics computed directly on Arrow columns. Labels are either strings
+// or numbers (of any numeric type, compared as doubles); classes are the labels present
+// in either column, in ascending order. Rows where either column is null are skipped.
+namespace learn
+{
+    struct LabelCodes
+    {
+        variant<std::vector<double>, std::vector<std::string>> classes; // ascending
+        std::vector<std::vector<int32_t>> codes; // for each encoded column, index of row's class (-1 for null)
+
+        int32_t classCount() const;
+    };
+
+    // Classes are assigned codes through a hash table in a single pass over each column.
+    EXPORT LabelCodes encodeLabels(const std::vector<const arrow::Column *> &columns);
+
+    struct ConfusionMatrix
+    {
+        LabelCodes labels; // only classes are kept
+        std::vector<int64_t> counts; // classCount x classCount, row is the true class, column the predicted one
+
+        int64_t at(int32_t trueClass, int32_t predictedClass) const { return counts[trueClass * labels.classCount() + predictedClass]; }
+    };
+
+    EXPORT ConfusionMatrix confusionMatrix(const arrow::Column &yTrue, const arrow::Column &yPredicted);
+
+    // Table with "class" column holding labels and a count column for each predicted class.
+    EXPORT std::shared_ptr<arrow::Table> confusionMatrixTable(const ConfusionMatrix &matrix);
+
+    EXPORT double accuracy(const arrow::Column &yTrue, const arrow::Column &yPredicted);
+
+    // Table with columns: class, precision, recall, f1, support. Metrics with zero denominator are 0.
+    EXPORT std::shared_ptr<arrow::Table> classificationMetrics(const arrow::Column &yTrue, const arrow::Column &yPredicted);
+
+    // Area under ROC curve for binary problem, the greater label is the positive class.
+    // Computed from ranks of scores (with ties getting their average rank), after sorting them once.
+    EXPORT double rocAuc(const arrow::Column &yTrue, const arrow::Column &scores);
+}
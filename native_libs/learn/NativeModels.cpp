@@ -0,0 +1,482 @@
+#include "NativeModels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <numeric>
+#include <set>
+
+#include <arrow/array.h>
+#include <arrow/table.h>
+
+#include <Core/ArrowUtilities.h>
+#include "Core/Error.h"
+#include "Core/ThreadPool.h"
+#include "Learn.h"
+#include "SKLearn.h"
+
+namespace
+{
+    // Feature columns as contiguous doubles. Null-free double columns stored in a single
+    // chunk are used in place, other ones are converted.
+    struct Design
+    {
+        int64_t rows = 0;
+        std::vector<const double *> columns;
+        std::vector<std::vector<double>> converted;
+
+        int featureCount() const { return (int)columns.size(); }
+    };
+
+    std::vector<double> toDoubles(const arrow::Column &column)
+    {
+        std::vector<double> ret(column.length());
+        writeAsDoubles(column, ret.data());
+        if(std::any_of(ret.begin(), ret.end(), [] (double value) { return std::isnan(value); }))
+            THROW("column {} contains nulls, they are not supported by native models", column.name());
+        return ret;
+    }
+
+    Design readDesign(const arrow::Table &xs)
+    {
+        Design ret;
+        ret.rows = xs.num_rows();
+        for(auto &column : getColumns(xs))
+        {
+            const auto &chunks = column->data()->chunks();
+            if(chunks.size() == 1 && column->type()->id() == arrow::Type::DOUBLE && chunks[0]->null_count() == 0)
+                ret.columns.push_back(rawValues<double>(*chunks[0]));
+            else
+            {
+                ret.converted.push_back(toDoubles(*column));
+                ret.columns.push_back(ret.converted.back().data());
+            }
+        }
+        return ret;
+    }
+
+    std::vector<double> readTarget(const arrow::Column &y, const Design &x)
+    {
+        if(y.length() != x.rows)
+            THROW("target column has {} rows while features have {}", y.length(), x.rows);
+        if(x.rows == 0)
+            THROW("cannot fit model to empty data");
+        return toDoubles(y);
+    }
+
+    // Symmetric system, row-major.
+    struct NormalEquations
+    {
+        int size;
+        std::vector<double> gram;
+        std::vector<double> rhs;
+
+        explicit NormalEquations(int size)
+            : size(size), gram(size * size), rhs(size)
+        {}
+
+        double &at(int row, int column) { return gram[row * size + column]; }
+    };
+
+    // Accumulates X^T W X and X^T W t, where X is the design with a column of ones appended
+    // (so the last row and column stand for the intercept). Each block of rows is processed
+    // by one task into its own sums, with contiguous loops over the block for each pair of columns.
+    //
+    // rowTerms(from, to, linearPredictor, outWeights, outTargets) gives weights and targets for
+    // rows [from, to); linearPredictor holds X * beta for them (zeros if beta is empty).
+    template<typename RowTermsF>
+    NormalEquations accumulateNormalEquations(const Design &x, const std::vector<double> &beta, RowTermsF &&rowTerms)
+    {
+        const auto size = x.featureCount() + 1;
+        NormalEquations ret(size);
+        std::mutex mx;
+        parallelFor(0, x.rows, [&] (int64_t from, int64_t to)
+        {
+            const auto n = to - from;
+            std::vector<double> ones(n, 1.0), linearPredictor(n, 0.0), weights(n), targets(n), weighted(n);
+            auto columns = transformToVector(x.columns, [&] (const double *column) { return column + from; });
+            columns.push_back(ones.data());
+
+            if(!beta.empty())
+                for(int a = 0; a < size; a++)
+                    for(int64_t i = 0; i < n; i++)
+                        linearPredictor[i] += beta[a] * columns[a][i];
+
+            rowTerms(from, to, linearPredictor.data(), weights.data(), targets.data());
+
+            NormalEquations local(size);
+            for(int a = 0; a < size; a++)
+            {
+                for(int64_t i = 0; i < n; i++)
+                    weighted[i] = weights[i] * columns[a][i];
+
+                double rhs = 0;
+                for(int64_t i = 0; i < n; i++)
+                    rhs += weighted[i] * targets[i];
+                local.rhs[a] = rhs;
+
+                for(int b = a; b < size; b++)
+                {
+                    double sum = 0;
+                    for(int64_t i = 0; i < n; i++)
+                        sum += weighted[i] * columns[b][i];
+                    local.at(a, b) = sum;
+                }
+            }
+
+            std::lock_guard<std::mutex> lock{mx};
+            for(size_t i = 0; i < ret.gram.size(); i++)
+                ret.gram[i] += local.gram[i];
+            for(int i = 0; i < size; i++)
+                ret.rhs[i] += local.rhs[i];
+        });
+
+        for(int a = 0; a < size; a++)
+            for(int b = 0; b < a; b++)
+                ret.at(a, b) = ret.at(b, a);
+        return ret;
+    }
+
+    // Solves A x = b in place of b, A being symmetric (row-major, n x n).
+    // Returns false if A is not (numerically) positive definite.
+    bool solveCholesky(std::vector<double> a, int n, std::vector<double> &b)
+    {
+        double maxDiagonal = 0;
+        for(int i = 0; i < n; i++)
+            maxDiagonal = std::max(maxDiagonal, a[i * n + i]);
+        const auto threshold = 1e-12 * maxDiagonal;
+
+        // lower triangle becomes L, such that A = L L^T
+        for(int j = 0; j < n; j++)
+        {
+            auto diagonal = a[j * n + j];
+            for(int k = 0; k < j; k++)
+                diagonal -= a[j * n + k] * a[j * n + k];
+            if(!(diagonal > threshold))
+                return false;
+
+            const auto l = std::sqrt(diagonal);
+            a[j * n + j] = l;
+            for(int i = j + 1; i < n; i++)
+            {
+                auto value = a[i * n + j];
+                for(int k = 0; k < j; k++)
+                    value -= a[i * n + k] * a[j * n + k];
+                a[i * n + j] = value / l;
+            }
+        }
+
+        for(int i = 0; i < n; i++)
+        {
+            for(int k = 0; k < i; k++)
+                b[i] -= a[i * n + k] * b[k];
+            b[i] /= a[i * n + i];
+        }
+        for(int i = n; i-- > 0; )
+        {
+            for(int k = i + 1; k < n; k++)
+                b[i] -= a[k * n + i] * b[k];
+            b[i] /= a[i * n + i];
+        }
+        return true;
+    }
+
+    // Least squares solution of min |X beta - y| using Householder QR, X given by columns.
+    // Slower than normal equations, but doesn't square the condition number.
+    // Returns nullopt if X is (numerically) rank-deficient.
+    std::optional<std::vector<double>> solveQR(std::vector<std::vector<double>> columns, std::vector<double> y)
+    {
+        const auto p = (int)columns.size();
+        const auto n = (int64_t)y.size();
+        if(n < p)
+            return std::nullopt;
+
+        double maxNorm = 0;
+        for(auto &column : columns)
+        {
+            double norm = 0;
+            for(auto value : column)
+                norm += value * value;
+            maxNorm = std::max(maxNorm, std::sqrt(norm));
+        }
+
+        // after step j, column k > j holds R's (j, k) entry at j, and the diagonal is kept aside
+        std::vector<double> diagonal(p);
+        for(int j = 0; j < p; j++)
+        {
+            auto &v = columns[j];
+            double norm = 0;
+            for(int64_t i = j; i < n; i++)
+                norm += v[i] * v[i];
+            norm = std::sqrt(norm);
+            if(norm <= 1e-10 * maxNorm)
+                return std::nullopt;
+
+            // reflection by u = v - alpha * e_j, stored in place of v
+            const auto alpha = v[j] > 0 ? -norm : norm;
+            v[j] -= alpha;
+            double uNorm2 = 0;
+            for(int64_t i = j; i < n; i++)
+                uNorm2 += v[i] * v[i];
+
+            const auto reflect = [&] (std::vector<double> &target)
+            {
+                double dot = 0;
+                for(int64_t i = j; i < n; i++)
+                    dot += v[i] * target[i];
+                const auto factor = 2 * dot / uNorm2;
+                for(int64_t i = j; i < n; i++)
+                    target[i] -= factor * v[i];
+            };
+            for(int k = j + 1; k < p; k++)
+                reflect(columns[k]);
+            reflect(y);
+            diagonal[j] = alpha;
+        }
+
+        std::vector<double> beta(p);
+        for(int j = p; j-- > 0; )
+        {
+            auto value = y[j];
+            for(int k = j + 1; k < p; k++)
+                value -= columns[k][j] * beta[k];
+            beta[j] = value / diagonal[j];
+        }
+        return beta;
+    }
+
+    std::vector<double> linearPredictor(const Design &x, const std::vector<double> &coefficients, double intercept)
+    {
+        if(x.featureCount() != (int)coefficients.size())
+            THROW("model was fitted with {} features, got {}", coefficients.size(), x.featureCount());
+
+        std::vector<double> ret(x.rows, intercept);
+        parallelFor(0, x.rows, [&] (int64_t from, int64_t to)
+        {
+            for(int a = 0; a < x.featureCount(); a++)
+                for(auto i = from; i < to; i++)
+                    ret[i] += coefficients[a] * x.columns[a][i];
+        });
+        return ret;
+    }
+
+    auto toPredictionsColumn(const std::vector<double> &values)
+    {
+        return toColumn(values, "Predictions");
+    }
+}
+
+namespace learn
+{
+    Model::~Model()
+    {
+        resetFallback();
+    }
+
+    void Model::resetFallback()
+    {
+        // model may be released on any thread, or at exit when the interpreter is already gone
+        if(fallback)
+            releasePythonObject(*fallback);
+        fallback.reset();
+    }
+
+    std::shared_ptr<arrow::Column> Model::predictInBatches(const arrow::Table &xs, int64_t batchRows) const
+    {
+        if(fallback)
+            return sklearn::predict(*fallback, xs, batchRows);
+
+        // native models don't export features, they only need the output buffer
+        if(batchRows <= 0)
+            THROW("batch must have at least one row, got {}", batchRows);
+        return predict(xs);
+    }
+
+    LinearRegression::LinearRegression(double alpha)
+        : alpha(alpha)
+    {
+        if(alpha < 0)
+            THROW("regularization strength must not be negative, got {}", alpha);
+    }
+
+    void LinearRegression::fit(const arrow::Table &xs, const arrow::Column &y)
+    {
+        resetFallback();
+        const auto x = readDesign(xs);
+        const auto target = readTarget(y, x);
+
+        auto equations = accumulateNormalEquations(x, {}, [&] (int64_t from, int64_t to, const double *, double *weights, double *targets)
+        {
+            std::fill_n(weights, to - from, 1.0);
+            std::copy(target.data() + from, target.data() + to, targets);
+        });
+
+        // centering (subtracting means) lets the intercept be solved separately and unpenalized
+        const auto p = x.featureCount();
+        const auto n = equations.at(p, p);
+        const auto targetSum = equations.rhs[p];
+        std::vector<double> centered(p * p), solution(p);
+        for(int a = 0; a < p; a++)
+        {
+            for(int b = 0; b < p; b++)
+                centered[a * p + b] = equations.at(a, b) - equations.at(a, p) * equations.at(b, p) / n;
+            centered[a * p + a] += alpha;
+            solution[a] = equations.rhs[a] - equations.at(a, p) * targetSum / n;
+        }
+
+        if(!solveCholesky(centered, p, solution))
+        {
+            std::optional<std::vector<double>> qrSolution;
+            if(alpha == 0)
+            {
+                auto centeredColumns = transformToVector(x.columns, [&] (const double *column)
+                {
+                    std::vector<double> ret(column, column + x.rows);
+                    const auto mean = std::accumulate(ret.begin(), ret.end(), 0.0) / x.rows;
+                    for(auto &value : ret)
+                        value -= mean;
+                    return ret;
+                });
+                auto centeredTarget = target;
+                for(auto &value : centeredTarget)
+                    value -= targetSum / n;
+                qrSolution = solveQR(std::move(centeredColumns), std::move(centeredTarget));
+            }
+            if(!qrSolution)
+            {
+                // rank-deficient: sklearn gives the minimum norm solution
+                // (or, for ridge, solves the same penalized problem more carefully)
+                fallback = alpha > 0 ? sklearn::newRidgeRegression(alpha) : sklearn::newLinearRegression();
+                sklearn::fit(*fallback, xs, y);
+                return;
+            }
+            solution = std::move(*qrSolution);
+        }
+
+        intercept_ = targetSum;
+        for(int a = 0; a < p; a++)
+            intercept_ -= solution[a] * equations.at(a, p);
+        intercept_ /= n;
+        coefficients_ = std::move(solution);
+    }
+
+    std::shared_ptr<arrow::Column> LinearRegression::predict(const arrow::Table &xs) const
+    {
+        if(fallback)
+            return sklearn::predict(*fallback, xs);
+        return toPredictionsColumn(linearPredictor(readDesign(xs), coefficients_, intercept_));
+    }
+
+    double LinearRegression::score(const arrow::Table &xs, const arrow::Column &y) const
+    {
+        if(fallback)
+            return sklearn::score(*fallback, xs, y);
+
+        const auto x = readDesign(xs);
+        const auto target = readTarget(y, x);
+        const auto predicted = linearPredictor(x, coefficients_, intercept_);
+        const auto mean = std::accumulate(target.begin(), target.end(), 0.0) / target.size();
+        double residualSum = 0, totalSum = 0;
+        for(size_t i = 0; i < target.size(); i++)
+        {
+            residualSum += (target[i] - predicted[i]) * (target[i] - predicted[i]);
+            totalSum += (target[i] - mean) * (target[i] - mean);
+        }
+        return 1 - residualSum / totalSum;
+    }
+
+    LogisticRegression::LogisticRegression(double C)
+        : C(C)
+    {
+        if(!(C > 0))
+            THROW("inverse of regularization strength must be positive, got {}", C);
+    }
+
+    void LogisticRegression::fit(const arrow::Table &xs, const arrow::Column &y)
+    {
+        resetFallback();
+        const auto x = readDesign(xs);
+        const auto target = readTarget(y, x);
+
+        std::set<double> distinct;
+        for(auto value : target)
+            if(distinct.insert(value).second && distinct.size() > 2)
+                break;
+
+        const auto fitWithSklearn = [&]
+        {
+            fallback = sklearn::newLogisticRegression(C);
+            sklearn::fit(*fallback, xs, y);
+        };
+        if(distinct.size() != 2)
+            return fitWithSklearn(); // multinomial (or degenerate) problem
+
+        classes = { *distinct.begin(), *distinct.rbegin() };
+
+        // each Newton step solves weighted least squares: (X^T W X + I/C) beta = X^T W z
+        // with p = sigmoid(X beta), W = diag(p(1-p)), z = X beta + W^-1 (t - p)
+        constexpr int MaxIterations = 100;
+        const auto p = x.featureCount();
+        std::vector<double> beta(p + 1, 0.0);
+        for(int iteration = 0; iteration < MaxIterations; iteration++)
+        {
+            checkCancellation();
+            auto equations = accumulateNormalEquations(x, beta, [&] (int64_t from, int64_t to, const double *linearPredictor, double *weights, double *targets)
+            {
+                for(int64_t i = 0; i < to - from; i++)
+                {
+                    const auto probability = 1 / (1 + std::exp(-linearPredictor[i]));
+                    const auto weight = std::max(probability * (1 - probability), 1e-10);
+                    const auto label = target[from + i] == classes[1] ? 1.0 : 0.0;
+                    weights[i] = weight;
+                    targets[i] = linearPredictor[i] + (label - probability) / weight;
+                }
+            });
+            for(int a = 0; a < p; a++)
+                equations.at(a, a) += 1 / C;
+
+            auto next = equations.rhs;
+            if(!solveCholesky(equations.gram, p + 1, next))
+                return fitWithSklearn();
+
+            double change = 0, magnitude = 0;
+            for(int a = 0; a <= p; a++)
+            {
+                change = std::max(change, std::abs(next[a] - beta[a]));
+                magnitude = std::max(magnitude, std::abs(next[a]));
+            }
+            beta = std::move(next);
+            if(change <= 1e-8 * (1 + magnitude))
+                break;
+        }
+
+        intercept_ = beta.back();
+        beta.pop_back();
+        coefficients_ = std::move(beta);
+    }
+
+    std::shared_ptr<arrow::Column> LogisticRegression::predict(const arrow::Table &xs) const
+    {
+        if(fallback)
+            return sklearn::predict(*fallback, xs);
+
+        auto labels = linearPredictor(readDesign(xs), coefficients_, intercept_);
+        for(auto &value : labels)
+            value = classes[value > 0];
+        return toPredictionsColumn(labels);
+    }
+
+    double LogisticRegression::score(const arrow::Table &xs, const arrow::Column &y) const
+    {
+        if(fallback)
+            return sklearn::score(*fallback, xs, y);
+
+        const auto x = readDesign(xs);
+        const auto target = readTarget(y, x);
+        const auto decision = linearPredictor(x, coefficients_, intercept_);
+        int64_t correct = 0;
+        for(size_t i = 0; i < target.size(); i++)
+            correct += classes[decision[i] > 0] == target[i];
+        return double(correct) / target.size();
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <Core/Common.h>
+#include "Python/IncludePython.h"
+
+namespace arrow
+{
+    class Column;
+    class Table;
+}
+
+// Models fitted without leaving native code: the design matrix is read directly from
+// Arrow columns and the normal equations are accumulated in parallel blocks of rows.
+// When the native solver can't handle the problem (e.g. rank-deficient design or more
+// than two classes), the model falls back to the equivalent sklearn estimator.
+//
+// Features must not contain nulls. Intercept is always fitted and never penalized.
+namespace learn
+{
+    class EXPORT Model
+    {
+    public:
+        virtual ~Model();
+
+        virtual void fit(const arrow::Table &xs, const arrow::Column &y) = 0;
+        virtual std::shared_ptr<arrow::Column> predict(const arrow::Table &xs) const = 0;
+        virtual double score(const arrow::Table &xs, const arrow::Column &y) const = 0;
+
+        // Same as predict, but features are given to sklearn fallback in blocks of batchRows rows.
+        std::shared_ptr<arrow::Column> predictInBatches(const arrow::Table &xs, int64_t batchRows) const;
+
+        bool usesFallback() const { return fallback.has_value(); }
+
+    protected:
+        std::optional<pybind11::object> fallback; // sklearn estimator, when native solver wasn't used
+        void resetFallback();
+    };
+
+    // Ordinary least squares, or ridge regression when alpha > 0. Solved with Cholesky
+    // decomposition of centered X^T X, with Householder QR when it is not positive definite.
+    // Ridge problem that Cholesky can't handle (e.g. badly scaled features) goes to sklearn Ridge.
+    class EXPORT LinearRegression : public Model
+    {
+    public:
+        explicit LinearRegression(double alpha = 0);
+
+        void fit(const arrow::Table &xs, const arrow::Column &y) override;
+        std::shared_ptr<arrow::Column> predict(const arrow::Table &xs) const override;
+        double score(const arrow::Table &xs, const arrow::Column &y) const override; // R^2
+
+        const std::vector<double> &coefficients() const { return coefficients_; }
+        double intercept() const { return intercept_; }
+
+    private:
+        double alpha;
+        std::vector<double> coefficients_;
+        double intercept_ = 0;
+    };
+
+    // Binary L2-regularized logistic regression, C is the inverse of regularization strength
+    // (as in sklearn). Solved with iteratively reweighted least squares (Newton's method).
+    class EXPORT LogisticRegression : public Model
+    {
+    public:
+        explicit LogisticRegression(double C = 1.0);
+
+        void fit(const arrow::Table &xs, const arrow::Column &y) override;
+        std::shared_ptr<arrow::Column> predict(const arrow::Table &xs) const override; // class labels
+        double score(const arrow::Table &xs, const arrow::Column &y) const override; // accuracy
+
+        const std::vector<double> &coefficients() const { return coefficients_; }
+        double intercept() const { return intercept_; }
+
+    private:
+        double C;
+        std::vector<double> coefficients_;
+        double intercept_ = 0;
+        std::array<double, 2> classes{}; // ascending, the second one is the positive class
+    };
+
+}
@@ -18,6 +18,7 @@ struct EXPORT interpreter
 {
     pybind11::function s_python_function_logistic_regression;
     pybind11::function s_python_function_linear_regression;
+    pybind11::function s_python_function_ridge;
     pybind11::function s_python_function_test_train_split;
     pybind11::function s_python_function_confusion_matrix;
 
@@ -31,6 +32,7 @@ private:
         pybind11::module sklearnlinmod = pybind11::module::import("sklearn.linear_model");
         s_python_function_logistic_regression = getMethod(sklearnlinmod, "LogisticRegression");
         s_python_function_linear_regression   = getMethod(sklearnlinmod, "LinearRegression");
+        s_python_function_ridge               = getMethod(sklearnlinmod, "Ridge");
         s_python_function_test_train_split    = getMethod(sklearnlinmod, "LogisticRegression");
 
         pybind11::module sklearnmetricsmod = pybind11::module::import("sklearn.metrics");
@@ -52,6 +54,11 @@ inline pybind11::object newLinearRegression()
     return interpreter::get().s_python_function_linear_regression();
 }
 
+inline pybind11::object newRidgeRegression(double alpha)
+{
+    return interpreter::get().s_python_function_ridge("alpha"_a=alpha);
+}
+
 inline void fit(pybind11::object model, pybind11::array xs, pybind11::array y)
 {
     model.attr("fit")(xs, y);
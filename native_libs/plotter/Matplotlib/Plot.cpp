@@ -75,7 +75,7 @@ pybind11::list toPyList(const arrow::ChunkedArray &arr)
     {
         PyListBuilder builder{ (size_t)arr.length() };
         iterateOverGeneric(arr,
-            [&](auto &&elem) { builder.append(elem); },
+            [&](auto &&elem) { builder.append(widen(elem)); },
             [&]()            { builder.appendNull(); });
         return builder.release();
     }
@@ -122,12 +122,14 @@ void saveFigure(const std::string &fname)
     return plt::save(fname);
 }
 
+// Python is started by the first call to any of these functions, not when the library is loaded.
 extern "C"
 {
     void plot(const arrow::Column *xs, const arrow::Column *ys, const char* label, const char *style, const char *color, double alpha, const char **outError) noexcept
     {
         return TRANSLATE_EXCEPTION(outError)
         {
+            PythonInterpreter::instance();
             auto xsarray = toPyList(*xs);
             auto ysarray = toPyList(*ys);
             plt::plot(xsarray, ysarray, label, style, color, alpha);
@@ -138,6 +140,7 @@ extern "C"
     {
         return TRANSLATE_EXCEPTION(outError)
         {
+            PythonInterpreter::instance();
             auto xsarray = toPyList(*xs);
             auto ysarray = toPyList(*ys);
             plt::plot_date(xsarray, ysarray);
@@ -148,6 +151,7 @@ extern "C"
     {
         return TRANSLATE_EXCEPTION(outError)
         {
+            PythonInterpreter::instance();
             auto xsarray = toPyList(*xs);
             auto ysarray = toPyList(*ys);
             plt::scatter(xsarray, ysarray);
@@ -158,6 +162,7 @@ extern "C"
     {
         return TRANSLATE_EXCEPTION(outError)
         {
+            PythonInterpreter::instance();
             auto xsarray = toPyList(*xs);
             plt::kdeplot(xsarray, label);
         };
@@ -167,6 +172,7 @@ extern "C"
     {
         return TRANSLATE_EXCEPTION(outError)
         {
+            PythonInterpreter::instance();
             auto xsarray = toPyList(*xs);
             auto ysarray = toPyList(*ys);
             plt::kdeplot2(xsarray, ysarray, colormap);
@@ -177,6 +183,7 @@ extern "C"
     {
         return TRANSLATE_EXCEPTION(outError)
         {
+            PythonInterpreter::instance();
             auto xsarray = toPyList(*xs);
             auto ysarray1 = toPyList(*ys1);
             auto ysarray2 = toPyList(*ys2);
@@ -188,6 +195,7 @@ extern "C"
     {
         return TRANSLATE_EXCEPTION(outError)
         {
+            PythonInterpreter::instance();
             auto xsarray = toPyList(*xs);
             plt::heatmap(xsarray, cmap, annot);
         };
@@ -197,6 +205,7 @@ extern "C"
     {
         return TRANSLATE_EXCEPTION(outError)
         {
+            PythonInterpreter::instance();
             auto xsarray = toPyList(*xs);
             plt::hist(xsarray, bins);
         };
@@ -206,6 +215,7 @@ extern "C"
     {
         return TRANSLATE_EXCEPTION(outError)
         {
+            PythonInterpreter::instance();
             plt::show();
         };
     }
@@ -222,6 +232,7 @@ extern "C"
             if(h == 0)
                 THROW("figure height must be positive, requested height={}", h);
 
+            PythonInterpreter::instance();
             plt::backend("Agg");
             plt::detail::_interpreter::get();
             plt::figure_size(w, h);
@@ -233,6 +244,7 @@ extern "C"
     {
         return TRANSLATE_EXCEPTION(outError)
         {
+            PythonInterpreter::instance();
             plt::subplot(nrows, ncols, plot_number);
         };
     }
@@ -241,6 +253,7 @@ extern "C"
     {
         return TRANSLATE_EXCEPTION(outError)
         {
+            PythonInterpreter::instance();
             auto png = ::getPNG();
             auto encodedPng = base64_encode(png);
             return returnedString.store(std::move(encodedPng));
@@ -251,6 +264,7 @@ extern "C"
     {
         return TRANSLATE_EXCEPTION(outError)
         {
+            PythonInterpreter::instance();
             return saveFigure(fname);
         };
     }
@@ -9,7 +9,7 @@
 
 
 template<typename T>
-std::common_type_t<T, double> vectorNthElement(std::vector<T> &data, int32_t n)
+std::common_type_t<T, double> vectorNthElement(std::vector<T> &data, int64_t n)
 {
     assert(n >= 0 && n < data.size());
     std::nth_element(data.begin(), data.begin() + n, data.end());
@@ -28,8 +28,8 @@ std::common_type_t<T, double> vectorQuantile(std::vector<T> &data, double q = 0.
 
     q = std::clamp(q, 0.0, 1.0);
     const double n = data.size() * q - 0.5;
-    const int n1 = static_cast<int>(std::floor(n));
-    const int n2 = static_cast<int>(std::ceil(n));
+    const auto n1 = static_cast<int64_t>(std::floor(n));
+    const auto n2 = static_cast<int64_t>(std::ceil(n));
     const auto t = n - n1;
     std::nth_element(data.begin(), data.begin() + n1, data.end());
     std::nth_element(data.begin() + n1, data.begin() + n2, data.end());
@@ -45,12 +45,26 @@ std::shared_ptr<arrow::Table> countValueTyped(const arrow::Column &column)
     using Builder = typename TypeDescription<id>::BuilderType;
     std::unordered_map<T, int64_t> valueCounts;
 
-    iterateOver<id>(column,
-        [&] (auto &&elem) { valueCounts[elem]++; },
-        [] () {});
+    if constexpr(hasFixedWidthValues<id>)
+    {
+        using StorageT = typename TypeDescription<id>::StorageValueType;
+        iterateOverRuns<id>(column,
+            [&] (const StorageT *values, int64_t length)
+            {
+                for(int64_t i = 0; i < length; i++)
+                    valueCounts[T(values[i])]++;
+            },
+            [] (int64_t) {});
+    }
+    else
+    {
+        iterateOver<id>(column,
+            [&] (auto &&elem) { valueCounts[elem]++; },
+            [] () {});
+    }
 
     auto valueBuilder = makeBuilder(std::static_pointer_cast<ArrowType>(column.field()->type()));
-    arrow::Int64Builder countBuilder;
+    arrow::Int64Builder countBuilder{memoryPool()};
 
     valueBuilder->Reserve(valueCounts.size());
     countBuilder.Reserve(valueCounts.size());
@@ -255,9 +269,23 @@ template<typename T> struct AggregatorFor<AggregateFunction::StdDev , T> { using
 template<arrow::Type::type id, typename Processor>
 auto calculateStatScalar(const arrow::Column &column, Processor &p)
 {
-    iterateOver<id>(column,
-        [&] (auto elem) { p(toStorage(elem)); },
-        [] {});
+    if constexpr(hasFixedWidthValues<id>)
+    {
+        using StorageT = typename TypeDescription<id>::StorageValueType;
+        iterateOverRuns<id>(column,
+            [&] (const StorageT *values, int64_t length)
+            {
+                for(int64_t i = 0; i < length; i++)
+                    p(values[i]);
+            },
+            [] (int64_t) {});
+    }
+    else
+    {
+        iterateOver<id>(column,
+            [&] (auto elem) { p(toStorage(elem)); },
+            [] {});
+    }
 
     return p.get();
 }
@@ -291,7 +319,8 @@ struct CalculateStatVisitor
     template<typename IDType>
     std::shared_ptr<arrow::Column> operator()(IDType id) const
     {
-        using T = typename TypeDescription<id.value>::ValueType;
+        // narrow types are accumulated as int64/double, so e.g. sum of int8 column does not overflow
+        using T = WidenedType<typename TypeDescription<id.value>::ValueType>;
         Processor<T> p;
         using ResultT = decltype(p.get());
 
@@ -381,7 +410,7 @@ std::shared_ptr<arrow::Column> calculateQuantile(const arrow::Column &column, do
 
 std::shared_ptr<arrow::Array> fromMemory(double *data, int32_t dataCount)
 {
-    arrow::DoubleBuilder builder;
+    arrow::DoubleBuilder builder{memoryPool()};
     builder.AppendValues(data, dataCount);
     return finish(builder);
 }
@@ -489,6 +518,7 @@ std::shared_ptr<arrow::Column> calculateCorrelation(const arrow::Table &table, c
 
 std::shared_ptr<arrow::Table> calculateCorrelationMatrix(const arrow::Table &table)
 {
+    TRACE_SPAN("analysis", "correlation matrix");
     const auto N = table.num_columns();
     std::vector<std::vector<double>> correlationMatrix;
     correlationMatrix.resize(N);
@@ -497,6 +527,10 @@ std::shared_ptr<arrow::Table> calculateCorrelationMatrix(const arrow::Table &tab
 
     for(int i = 0; i < N; i++)
     {
+        checkCancellation();
+        // the remaining pairs to calculate form a triangle
+        reportProgress(1.0 - double(N - i) * (N - i) / (double(N) * N), "correlating");
+
         const auto ci = table.column(i);
         correlationMatrix[i][i] = 1.0;
         for(int j = i + 1; j < N; j++)
@@ -652,7 +686,11 @@ DFH_EXPORT std::shared_ptr<arrow::Table> abominableGroupAggregate(std::shared_pt
         }
         else
         {
-            GroupedKeyInfo<ArrowType> groups{*keyColumn};
+            auto groups = [&]
+            {
+                TRACE_SPAN("aggregate", "group keys");
+                return GroupedKeyInfo<ArrowType>{*keyColumn};
+            }();
 
             const auto groupCount = groups.groupCount();
             const auto hasNulls = groups.hasNulls;
@@ -679,11 +717,12 @@ DFH_EXPORT std::shared_ptr<arrow::Table> abominableGroupAggregate(std::shared_pt
             {
                 visitType(colAggrs.first->type()->id(), [&](auto id)
                 {
+                    TRACE_SPAN("aggregate", "aggregate column");
                     auto [column, aggregates] = colAggrs;
-                    using T = typename TypeDescription<id.value>::ObservedType;
+                    using T = WidenedType<typename TypeDescription<id.value>::ObservedType>;
                     std::vector<Aggregators<T>> aggregators;
                     aggregators.reserve(afterLastGroup);
-                    for(int i = 0; i < afterLastGroup; i++)
+                    for(int64_t i = 0; i < afterLastGroup; i++)
                     {
                         try
                         {
@@ -778,7 +817,7 @@ std::vector<int64_t> collectRollingWindowPositionsT(const Indexable &indexable,
         {
             using TD = TypeDescription<id.value>;
             using Array = typename TD::Array;
-            using IntervalType = IntervalType<TD>;
+            using IntervalType = WidenedType<IntervalType<TD>>;
 
             if(!holds_alternative<IntervalType>(interval))
                 THROW("wrong interval type: `index {}`, expected: `{}`", interval.index(), typeid(IntervalType));
@@ -816,7 +855,7 @@ struct FunctionOverWindowCalculator
     template <AggregateFunction f>
     std::optional<double> operator()(std::integral_constant<AggregateFunction, f> aggrC) const
     {
-        using T = typename TypeDescription<id>::ValueType;
+        using T = WidenedType<typename TypeDescription<id>::ValueType>;
         using Aggregator = AggregatorFor_t<aggrC.value, T>;
         Aggregator aggregator;
 
@@ -844,7 +883,7 @@ std::optional<double> calculateFunctionOnWindow(const Indexable &indexable, int6
 {
     return visitType4(indexable.type(), [&] (auto id) -> std::optional<double>
     {
-        if constexpr(id.value == arrow::Type::INT64 || id.value == arrow::Type::DOUBLE)
+        if constexpr(std::is_arithmetic_v<typename TypeDescription<id.value>::ObservedType>)
         {
             FunctionOverWindowCalculator<Indexable, id.value> calculator{indexable, startIndex, windowsWidth};
             return dispatchAggregateByEnum(f, calculator);
@@ -894,7 +933,7 @@ std::shared_ptr<arrow::Table> rollingInterval(std::shared_ptr<arrow::Column> key
             {
                 try
                 {
-                    arrow::DoubleBuilder builder;
+                    arrow::DoubleBuilder builder{memoryPool()};
                     builder.Reserve(N);
 
                     for(int64_t row = 0; row < N; ++row)
@@ -31,7 +31,7 @@ struct GroupedKeyInfo
     using KeyT = typename ArrowTypeDescription<ArrowType>::ObservedType;
     bool hasNulls;
     std::unordered_map<KeyT, int64_t> uniqueValues; // key value => group id
-    std::vector<int64_t> groupIds; // [row index] => group id
+    ScratchVector<int64_t> groupIds; // [row index] => group id
 
     explicit GroupedKeyInfo(const arrow::Column &keyColumn)
         : hasNulls(keyColumn.null_count() != 0)
@@ -1,5 +1,9 @@
 #include "ArrowUtilities.h"
 
+#include <cmath>
+#include <limits>
+#include <optional>
+
 using namespace std::literals;
 
 //DFH_EXPORT std::shared_ptr<arrow::TimestampType> timestampTypeSingleton = std::make_shared<arrow::TimestampType>(arrow::TimeUnit::NANO);
@@ -155,7 +159,7 @@ DynamicJustVector toJustVector(const arrow::ChunkedArray &chunkedArray)
 {
     return visitType(*chunkedArray.type(), [&] (auto id)  -> DynamicJustVector
     {
-        using T = typename TypeDescription<id.value>::ObservedType;
+        using T = WidenedType<typename TypeDescription<id.value>::ObservedType>;
 
         std::vector<T> ret;
         ret.reserve(chunkedArray.length() - chunkedArray.null_count());
@@ -170,12 +174,108 @@ DynamicJustVector toJustVector(const arrow::Column &column)
     return toJustVector(*column.data());
 }
 
-DynamicField arrayAt(const arrow::Array &array, int32_t index)
+namespace
+{
+    template<arrow::Type::type sourceId, arrow::Type::type targetId>
+    std::shared_ptr<arrow::Array> convertNumericArray(const arrow::Array &array)
+    {
+        using Source = typename TypeDescription<sourceId>::StorageValueType;
+        using Target = typename TypeDescription<targetId>::StorageValueType;
+
+        const auto length = array.length();
+        const auto source = rawValues<Source>(array);
+        auto [valueBuffer, target] = allocateBuffer<Target>(length);
+
+        std::optional<BitmaskGenerator> validity;
+        if(array.null_count())
+            validity.emplace(length, true);
+
+        iterateOverValidityRuns(array, [&, target = target] (bool valid, int64_t start, int64_t runLength)
+        {
+            if(valid)
+            {
+                std::transform(source + start, source + start + runLength, target + start,
+                    [] (Source value) { return static_cast<Target>(value); });
+            }
+            else
+            {
+                std::fill_n(target + start, runLength, Target{});
+                for(int64_t row = start; row < start + runLength; row++)
+                    validity->clear(row);
+            }
+        });
+
+        using Array = typename TypeDescription<targetId>::Array;
+        const auto nullBuffer = validity ? validity->buffer : nullptr;
+        return std::make_shared<Array>(getTypeSingleton<targetId>(), length, valueBuffer, nullBuffer, array.null_count());
+    }
+
+    template<typename T>
+    bool valuesFitIn(int64_t minValue, int64_t maxValue)
+    {
+        return minValue >= std::numeric_limits<T>::min() && maxValue <= std::numeric_limits<T>::max();
+    }
+}
+
+std::shared_ptr<arrow::Array> narrowNumericArray(std::shared_ptr<arrow::Array> array)
+{
+    if(array->length() == array->null_count())
+        return array;
+
+    switch(array->type_id())
+    {
+    case arrow::Type::INT64:
+    {
+        auto minValue = std::numeric_limits<int64_t>::max();
+        auto maxValue = std::numeric_limits<int64_t>::min();
+        iterateOverRuns<arrow::Type::INT64>(*array,
+            [&] (const int64_t *values, int64_t length)
+            {
+                const auto [runMin, runMax] = std::minmax_element(values, values + length);
+                minValue = std::min(minValue, *runMin);
+                maxValue = std::max(maxValue, *runMax);
+            },
+            [] (int64_t) {});
+
+        if(valuesFitIn<int8_t>(minValue, maxValue))
+            return convertNumericArray<arrow::Type::INT64, arrow::Type::INT8>(*array);
+        if(valuesFitIn<int16_t>(minValue, maxValue))
+            return convertNumericArray<arrow::Type::INT64, arrow::Type::INT16>(*array);
+        if(valuesFitIn<int32_t>(minValue, maxValue))
+            return convertNumericArray<arrow::Type::INT64, arrow::Type::INT32>(*array);
+        return array;
+    }
+    case arrow::Type::DOUBLE:
+    {
+        // NaN fails the check below, so columns with NaNs are kept as doubles
+        bool exact = true;
+        iterateOverRuns<arrow::Type::DOUBLE>(*array,
+            [&] (const double *values, int64_t length)
+            {
+                for(int64_t i = 0; i < length && exact; i++)
+                {
+                    const auto value = values[i];
+                    exact = std::abs(value) <= std::numeric_limits<float>::max()
+                        && static_cast<double>(static_cast<float>(value)) == value;
+                }
+            },
+            [] (int64_t) {});
+
+        if(exact)
+            return convertNumericArray<arrow::Type::DOUBLE, arrow::Type::FLOAT>(*array);
+        return array;
+    }
+    default:
+        return array;
+    }
+}
+
+DynamicField arrayAt(const arrow::Array &array, int64_t index)
 {
     return visitArray(array, [&](auto *array) -> DynamicField
     {
         if(array->IsValid(index))
-            return arrayValueAtTyped(*array, index);
+            return widen(arrayValueAtTyped(*array, index));
         else
             return std::nullopt;
     });
@@ -192,7 +292,7 @@ DynamicField arrayAt(const arrow::Column &column, int64_t index)
     return arrayAt(*column.data(), index);
 }
 
-std::pair<std::shared_ptr<arrow::Array>, int32_t> locateChunk(const arrow::ChunkedArray &chunkedArray, int64_t index)
+std::pair<std::shared_ptr<arrow::Array>, int64_t> locateChunk(const arrow::ChunkedArray &chunkedArray, int64_t index)
 {
     validateIndex(chunkedArray, index);
 
@@ -201,7 +301,7 @@ std::pair<std::shared_ptr<arrow::Array>, int32_t> locateChunk(const arrow::Chunk
     {
         const auto length = chunk->length(); // Note: having this assigned to variable greatly improves performance (MSVC)
         if(i < length)
-            return {chunk, static_cast<int32_t>(i)};
+            return {chunk, i};
 
         i -= length;
     }
@@ -303,14 +403,14 @@ ChunkAccessor::ChunkAccessor(const arrow::Column &column)
     : ChunkAccessor(*column.data())
 {}
 
-std::pair<const arrow::Array *, int32_t> ChunkAccessor::locate(int64_t index) const
+std::pair<const arrow::Array *, int64_t> ChunkAccessor::locate(int64_t index) const
 {
     auto itr = std::upper_bound(chunkStartIndices.begin(), chunkStartIndices.end(), index);
     if(itr != chunkStartIndices.begin())
     {
         auto chunkStart = itr - 1;
         auto chunkIndex = std::distance(chunkStartIndices.begin(), chunkStart);
-        auto indexWithinChunk = (int32_t)(index - *chunkStart);
+        auto indexWithinChunk = index - *chunkStart;
         return { chunks[chunkIndex].get(), indexWithinChunk };
     }
     else
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <cstring>
 #include <ctime>
 #include <iomanip>
 #include <sstream>
@@ -15,7 +17,16 @@
 #include <arrow/builder.h>
 #include <arrow/table.h>
 #include <arrow/type.h>
+#include "Cancellation.h"
 #include "Common.h"
+#include "MemoryTracking.h"
+#include "ScratchArena.h"
+#include "ThreadPool.h"
+#include "Tracing.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 using TypePtr = std::shared_ptr<arrow::DataType>;
 
@@ -85,6 +96,24 @@ constexpr auto ValueTypeToId()
         return arrow::Type::INT64;
     else if constexpr(std::is_same_v<T, double>)
         return arrow::Type::DOUBLE;
+    else if constexpr(std::is_same_v<T, int8_t>)
+        return arrow::Type::INT8;
+    else if constexpr(std::is_same_v<T, int16_t>)
+        return arrow::Type::INT16;
+    else if constexpr(std::is_same_v<T, int32_t>)
+        return arrow::Type::INT32;
+    else if constexpr(std::is_same_v<T, uint8_t>)
+        return arrow::Type::UINT8;
+    else if constexpr(std::is_same_v<T, uint16_t>)
+        return arrow::Type::UINT16;
+    else if constexpr(std::is_same_v<T, uint32_t>)
+        return arrow::Type::UINT32;
+    else if constexpr(std::is_same_v<T, uint64_t>)
+        return arrow::Type::UINT64;
+    else if constexpr(std::is_same_v<T, float>)
+        return arrow::Type::FLOAT;
+    else if constexpr(std::is_same_v<T, bool>)
+        return arrow::Type::BOOL;
     else if constexpr(std::is_same_v<T, std::string>)
         return arrow::Type::STRING;
     else if constexpr(std::is_same_v<T, Timestamp>)
@@ -136,13 +165,28 @@ template<> struct TypeDescription<arrow::Type::STRING>
     static constexpr arrow::Type::type id = ArrowType::type_id;
 };
 
+// Booleans are bit-packed, so unlike numeric types they don't have an
+// addressable value buffer and must be accessed through array's Value.
+template<> struct TypeDescription<arrow::Type::BOOL>
+{
+    using ArrowType = arrow::BooleanType;
+    using BuilderType = arrow::BooleanBuilder;
+    using ValueType = bool;
+    using ObservedType = bool;
+    using CType = bool;
+    using Array = arrow::BooleanArray;
+    using StorageValueType = uint8_t;
+    using OffsetType = void;
+    static constexpr arrow::Type::type id = ArrowType::type_id;
+};
+
 struct ListElemView
 {
     arrow::Array *array{};
-    int32_t offset{};
-    int32_t length{};
+    int64_t offset{};
+    int64_t length{};
 
-    ListElemView(arrow::Array *array, int32_t offset, int32_t length)
+    ListElemView(arrow::Array *array, int64_t offset, int64_t length)
         : array(array), offset(offset), length(length)
     {}
 };
@@ -174,6 +218,24 @@ template<> struct TypeDescription<arrow::Type::LIST>
     static constexpr arrow::Type::type id = ArrowType::type_id;
 };
 
+// Narrow numeric types (int8-int32, unsigned integers, float) are processed
+// as their widest counterpart: int64_t for integers and double for floating
+// point. This is the promotion rule for LQuery and statistics, and the only
+// numeric types that DynamicField can hold. Other values are left as they are.
+template<typename T>
+constexpr auto widen(const T &value)
+{
+    if constexpr(std::is_integral_v<T>)
+        return static_cast<int64_t>(value);
+    else if constexpr(std::is_floating_point_v<T>)
+        return static_cast<double>(value);
+    else
+        return value;
+}
+
+template<typename T>
+using WidenedType = decltype(widen(std::declval<T>()));
+
 template<typename Array>
 using ArrayTypeDescription = TypeDescription<std::decay_t<std::remove_pointer_t<Array>>::TypeClass::type_id>;
 
@@ -198,6 +260,15 @@ auto visitDataType3(const std::shared_ptr<arrow::DataType> &type, F &&f)
     {
         case arrow::Type::INT64: return f(std::static_pointer_cast<arrow::Int64Type>(type));
         case arrow::Type::DOUBLE: return f(std::static_pointer_cast<arrow::DoubleType>(type));
+        case arrow::Type::INT8: return f(std::static_pointer_cast<arrow::Int8Type>(type));
+        case arrow::Type::INT16: return f(std::static_pointer_cast<arrow::Int16Type>(type));
+        case arrow::Type::INT32: return f(std::static_pointer_cast<arrow::Int32Type>(type));
+        case arrow::Type::UINT8: return f(std::static_pointer_cast<arrow::UInt8Type>(type));
+        case arrow::Type::UINT16: return f(std::static_pointer_cast<arrow::UInt16Type>(type));
+        case arrow::Type::UINT32: return f(std::static_pointer_cast<arrow::UInt32Type>(type));
+        case arrow::Type::UINT64: return f(std::static_pointer_cast<arrow::UInt64Type>(type));
+        case arrow::Type::FLOAT: return f(std::static_pointer_cast<arrow::FloatType>(type));
+        case arrow::Type::BOOL: return f(std::static_pointer_cast<arrow::BooleanType>(type));
         case arrow::Type::STRING: return f(std::static_pointer_cast<arrow::StringType>(type));
         case arrow::Type::TIMESTAMP: return f(std::static_pointer_cast<arrow::TimestampType>(type));
         default: throw std::runtime_error("type not supported to downcast: " + type->ToString());
@@ -211,6 +282,15 @@ auto visitDataType(const std::shared_ptr<arrow::DataType> &type, F &&f)
     {
     case arrow::Type::INT64: return f(std::static_pointer_cast<arrow::Int64Type>(type));
     case arrow::Type::DOUBLE: return f(std::static_pointer_cast<arrow::DoubleType>(type));
+    case arrow::Type::INT8: return f(std::static_pointer_cast<arrow::Int8Type>(type));
+    case arrow::Type::INT16: return f(std::static_pointer_cast<arrow::Int16Type>(type));
+    case arrow::Type::INT32: return f(std::static_pointer_cast<arrow::Int32Type>(type));
+    case arrow::Type::UINT8: return f(std::static_pointer_cast<arrow::UInt8Type>(type));
+    case arrow::Type::UINT16: return f(std::static_pointer_cast<arrow::UInt16Type>(type));
+    case arrow::Type::UINT32: return f(std::static_pointer_cast<arrow::UInt32Type>(type));
+    case arrow::Type::UINT64: return f(std::static_pointer_cast<arrow::UInt64Type>(type));
+    case arrow::Type::FLOAT: return f(std::static_pointer_cast<arrow::FloatType>(type));
+    case arrow::Type::BOOL: return f(std::static_pointer_cast<arrow::BooleanType>(type));
     case arrow::Type::STRING: return f(std::static_pointer_cast<arrow::StringType>(type));
     case arrow::Type::TIMESTAMP: return f(std::static_pointer_cast<arrow::TimestampType>(type));
     case arrow::Type::LIST: return f(std::static_pointer_cast<arrow::ListType>(type));
@@ -225,6 +305,15 @@ auto visitType(const arrow::Type::type &id, F &&f)
     {
     case arrow::Type::INT64 : return f(std::integral_constant<arrow::Type::type, arrow::Type::INT64 >{});
     case arrow::Type::DOUBLE: return f(std::integral_constant<arrow::Type::type, arrow::Type::DOUBLE>{});
+    case arrow::Type::INT8  : return f(std::integral_constant<arrow::Type::type, arrow::Type::INT8  >{});
+    case arrow::Type::INT16 : return f(std::integral_constant<arrow::Type::type, arrow::Type::INT16 >{});
+    case arrow::Type::INT32 : return f(std::integral_constant<arrow::Type::type, arrow::Type::INT32 >{});
+    case arrow::Type::UINT8 : return f(std::integral_constant<arrow::Type::type, arrow::Type::UINT8 >{});
+    case arrow::Type::UINT16: return f(std::integral_constant<arrow::Type::type, arrow::Type::UINT16>{});
+    case arrow::Type::UINT32: return f(std::integral_constant<arrow::Type::type, arrow::Type::UINT32>{});
+    case arrow::Type::UINT64: return f(std::integral_constant<arrow::Type::type, arrow::Type::UINT64>{});
+    case arrow::Type::FLOAT : return f(std::integral_constant<arrow::Type::type, arrow::Type::FLOAT >{});
+    case arrow::Type::BOOL  : return f(std::integral_constant<arrow::Type::type, arrow::Type::BOOL  >{});
     case arrow::Type::STRING: return f(std::integral_constant<arrow::Type::type, arrow::Type::STRING>{});
     case arrow::Type::TIMESTAMP: return f(std::integral_constant<arrow::Type::type, arrow::Type::TIMESTAMP>{});
     //case arrow::Type::LIST: return f(std::integral_constant<arrow::Type::type, arrow::Type::LIST>{});
@@ -239,6 +328,15 @@ auto visitType(const arrow::DataType &type, F &&f)
     {
     case arrow::Type::INT64 : return f(std::integral_constant<arrow::Type::type, arrow::Type::INT64 >{});
     case arrow::Type::DOUBLE: return f(std::integral_constant<arrow::Type::type, arrow::Type::DOUBLE>{});
+    case arrow::Type::INT8  : return f(std::integral_constant<arrow::Type::type, arrow::Type::INT8  >{});
+    case arrow::Type::INT16 : return f(std::integral_constant<arrow::Type::type, arrow::Type::INT16 >{});
+    case arrow::Type::INT32 : return f(std::integral_constant<arrow::Type::type, arrow::Type::INT32 >{});
+    case arrow::Type::UINT8 : return f(std::integral_constant<arrow::Type::type, arrow::Type::UINT8 >{});
+    case arrow::Type::UINT16: return f(std::integral_constant<arrow::Type::type, arrow::Type::UINT16>{});
+    case arrow::Type::UINT32: return f(std::integral_constant<arrow::Type::type, arrow::Type::UINT32>{});
+    case arrow::Type::UINT64: return f(std::integral_constant<arrow::Type::type, arrow::Type::UINT64>{});
+    case arrow::Type::FLOAT : return f(std::integral_constant<arrow::Type::type, arrow::Type::FLOAT >{});
+    case arrow::Type::BOOL  : return f(std::integral_constant<arrow::Type::type, arrow::Type::BOOL  >{});
     case arrow::Type::STRING: return f(std::integral_constant<arrow::Type::type, arrow::Type::STRING>{});
     case arrow::Type::TIMESTAMP: return f(std::integral_constant<arrow::Type::type, arrow::Type::TIMESTAMP>{});
     //case arrow::Type::LIST: return f(std::integral_constant<arrow::Type::type, arrow::Type::LIST>{});
@@ -253,6 +351,15 @@ auto visitType4(const TypePtr &type, F &&f)
     {
     case arrow::Type::INT64: return f(std::integral_constant<arrow::Type::type, arrow::Type::INT64 >{});
     case arrow::Type::DOUBLE: return f(std::integral_constant<arrow::Type::type, arrow::Type::DOUBLE>{});
+    case arrow::Type::INT8  : return f(std::integral_constant<arrow::Type::type, arrow::Type::INT8  >{});
+    case arrow::Type::INT16 : return f(std::integral_constant<arrow::Type::type, arrow::Type::INT16 >{});
+    case arrow::Type::INT32 : return f(std::integral_constant<arrow::Type::type, arrow::Type::INT32 >{});
+    case arrow::Type::UINT8 : return f(std::integral_constant<arrow::Type::type, arrow::Type::UINT8 >{});
+    case arrow::Type::UINT16: return f(std::integral_constant<arrow::Type::type, arrow::Type::UINT16>{});
+    case arrow::Type::UINT32: return f(std::integral_constant<arrow::Type::type, arrow::Type::UINT32>{});
+    case arrow::Type::UINT64: return f(std::integral_constant<arrow::Type::type, arrow::Type::UINT64>{});
+    case arrow::Type::FLOAT : return f(std::integral_constant<arrow::Type::type, arrow::Type::FLOAT >{});
+    case arrow::Type::BOOL  : return f(std::integral_constant<arrow::Type::type, arrow::Type::BOOL  >{});
     case arrow::Type::STRING: return f(std::integral_constant<arrow::Type::type, arrow::Type::STRING>{});
     case arrow::Type::TIMESTAMP: return f(std::integral_constant<arrow::Type::type, arrow::Type::TIMESTAMP>{});
     case arrow::Type::LIST: return f(std::integral_constant<arrow::Type::type, arrow::Type::LIST>{});
@@ -261,7 +368,7 @@ auto visitType4(const TypePtr &type, F &&f)
 }
 
 template <typename Array>
-auto arrayValueAtTyped(const Array &array, int32_t index)
+auto arrayValueAtTyped(const Array &array, int64_t index)
 {
     if constexpr(std::is_same_v<arrow::StringArray, Array>)
     {
@@ -319,15 +426,15 @@ auto makeBuilder(const std::shared_ptr<TypeT> &type)
 
         // list builder must additionally take a nested builder for a value buffer
         auto nestedBuilder = makeBuilder(type->child(0)->type());
-        return std::make_shared<Builder>(nullptr, nestedBuilder);
+        return std::make_shared<Builder>(memoryPool(), nestedBuilder);
     }
     else if constexpr(TT::is_parameter_free)
     {
-        return std::make_shared<Builder>();
+        return std::make_shared<Builder>(memoryPool());
     }
     else
     {
-        return std::make_shared<Builder>(type, arrow::default_memory_pool());
+        return std::make_shared<Builder>(type, memoryPool());
     }
 }
 
@@ -342,6 +449,11 @@ auto append(arrow::NumericBuilder<N> &builder, const V &value, std::enable_if_t<
     return builder.Append(value);
 }
 
+inline auto append(arrow::BooleanBuilder &builder, bool value)
+{
+    return builder.Append(value);
+}
+
 inline auto append(arrow::TimestampBuilder &builder, const Timestamp &value)
 {
     // TODO support other units than nanoseconds
@@ -363,13 +475,13 @@ inline auto append(Builder &builder, const std::optional<T> &value)
 //////////////////////////////////////////////////////////////////////////
 
 template <arrow::Type::type type>
-auto arrayValueAt(const arrow::Array &array, int32_t index)
+auto arrayValueAt(const arrow::Array &array, int64_t index)
 {
     using Array = typename TypeDescription<type>::Array;
     return arrayValueAtTyped(static_cast<const Array &>(array), index);
 }
 template <arrow::Type::type type>
-auto tryArrayValueAt(const arrow::Array &array, int32_t index)
+auto tryArrayValueAt(const arrow::Array &array, int64_t index)
 {
     using T = typename TypeDescription<type>::ObservedType;
     if(array.IsValid(index))
@@ -383,24 +495,24 @@ auto tryArrayValueAt(const arrow::Array &array, int32_t index)
 template <arrow::Type::type type, typename ElementF, typename NullF>
 void iterateOver(const arrow::Array &array, ElementF &&handleElem, NullF &&handleNull)
 {
-    const auto N = static_cast<int32_t>(array.length());
+    const auto N = array.length();
     const auto nullCount = array.null_count();
     //const auto nullBitmapData = array.null_bitmap_data();
 
     // special fast paths when there are no nulls or array is all nulls
     if(nullCount == 0)
     {
-        for(int32_t row = 0; row < N; row++)
+        for(int64_t row = 0; row < N; row++)
             handleElem(arrayValueAt<type>(array, row));
     }
     else if(nullCount == N)
     {
-        for(int32_t row = 0; row < N; row++)
+        for(int64_t row = 0; row < N; row++)
             handleNull();
     }
     else
     {
-        for(int32_t row = 0; row < N; row++)
+        for(int64_t row = 0; row < N; row++)
         {
             if(!array.IsNull(row))
             {
@@ -448,6 +560,199 @@ void iterateOverGeneric(const arrow::Column &column, ElementF &&handleElem, Null
     return iterateOverGeneric(*column.data(), handleElem, handleNull);
 }
 
+//////////////////////////////////////////////////////////////////////////
+// Bulk iteration
+//
+// Functions below visit whole runs of elements rather than single elements.
+// Validity bitmap is scanned a 64-bit word at a time, so for typical data
+// (no nulls or few nulls) callers get long contiguous spans of values that
+// they can process in a tight, vectorizable loop.
+
+// Bit-packed booleans are not included: they have no addressable values.
+template<arrow::Type::type id>
+constexpr bool hasFixedWidthValues = std::is_same_v<typename TypeDescription<id>::OffsetType, void> && id != arrow::Type::BOOL;
+
+inline int countTrailingZeros(uint64_t word)
+{
+    assert(word != 0);
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return (int)index;
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+// Returns the index of the first bit in [start, end) that has the given value, or end if there's no such bit.
+inline int64_t findNextBit(const uint8_t *bitmap, int64_t start, int64_t end, bool value)
+{
+    int64_t i = start;
+    for( ; i < end && i % 64; i++)
+        if(arrow::BitUtil::GetBit(bitmap, i) == value)
+            return i;
+
+    for( ; i + 64 <= end; i += 64)
+    {
+        uint64_t word;
+        std::memcpy(&word, bitmap + i / 8, sizeof(word));
+        if(!value)
+            word = ~word;
+        if(word)
+            return i + countTrailingZeros(word);
+    }
+
+    for( ; i < end; i++)
+        if(arrow::BitUtil::GetBit(bitmap, i) == value)
+            return i;
+
+    return end;
+}
+
+// Loads `count` (at most 64) bits starting at the given bit offset.
+inline uint64_t loadBits(const uint8_t *bitmap, int64_t bitOffset, int count)
+{
+    assert(count > 0 && count <= 64);
+    const auto shift = bitOffset % 8;
+    const auto bytesNeeded = (shift + count + 7) / 8;
+    const auto source = bitmap + bitOffset / 8;
+
+    uint64_t word = 0;
+    std::memcpy(&word, source, std::min<int64_t>(bytesNeeded, 8));
+    word >>= shift;
+    if(bytesNeeded > 8)
+        word |= uint64_t(source[8]) << (64 - shift);
+
+    return count == 64 ? word : word & ((uint64_t(1) << count) - 1);
+}
+
+// Calls handleRun(bool valid, int64_t start, int64_t length) for each maximal
+// run of consecutive valid or consecutive null elements.
+template <typename RunF>
+void iterateOverValidityRuns(const arrow::Array &array, RunF &&handleRun)
+{
+    const auto length = array.length();
+    const auto nullCount = array.null_count();
+    if(length == 0)
+        return;
+
+    if(nullCount == 0)
+        return handleRun(true, int64_t(0), length);
+    if(nullCount == length)
+        return handleRun(false, int64_t(0), length);
+
+    const auto bitmap = array.null_bitmap_data();
+    const auto offset = array.offset();
+    for(int64_t row = 0; row < length; )
+    {
+        const bool valid = arrow::BitUtil::GetBit(bitmap, offset + row);
+        const auto runEnd = findNextBit(bitmap, offset + row + 1, offset + length, !valid) - offset;
+        handleRun(valid, row, runEnd - row);
+        row = runEnd;
+    }
+}
+
+// Same as above but for chunked data, start is an index in the whole chunked array.
+template <typename RunF>
+void iterateOverValidityRuns(const arrow::ChunkedArray &arrays, RunF &&handleRun)
+{
+    int64_t chunkStart = 0;
+    for(auto &chunk : arrays.chunks())
+    {
+        iterateOverValidityRuns(*chunk, [&] (bool valid, int64_t start, int64_t length)
+        {
+            handleRun(valid, chunkStart + start, length);
+        });
+        chunkStart += chunk->length();
+    }
+}
+
+template <typename RunF>
+void iterateOverValidityRuns(const arrow::Column &column, RunF &&handleRun)
+{
+    return iterateOverValidityRuns(*column.data(), handleRun);
+}
+
+// Pointer to the first value of fixed-width array (respecting array offset).
+template<typename T>
+const T *rawValues(const arrow::Array &array)
+{
+    const auto &valueBuffer = array.data()->buffers.at(1);
+    if(!valueBuffer)
+        return nullptr;
+
+    return reinterpret_cast<const T *>(valueBuffer->data()) + array.offset();
+}
+
+// For fixed-width types: calls handleValidRun(const T *values, int64_t length)
+// for runs of valid elements and handleNullRun(int64_t length) for runs of nulls.
+// T is the storage type (e.g. int64_t for timestamps).
+template <arrow::Type::type type, typename ValidRunF, typename NullRunF>
+void iterateOverRuns(const arrow::Array &array, ValidRunF &&handleValidRun, NullRunF &&handleNullRun)
+{
+    static_assert(hasFixedWidthValues<type>, "runs of values are available only for fixed-width types");
+    using T = typename TypeDescription<type>::StorageValueType;
+
+    const auto values = rawValues<T>(array);
+    iterateOverValidityRuns(array, [&] (bool valid, int64_t start, int64_t length)
+    {
+        if(valid)
+            handleValidRun(values + start, length);
+        else
+            handleNullRun(length);
+    });
+}
+
+template <arrow::Type::type type, typename ValidRunF, typename NullRunF>
+void iterateOverRuns(const arrow::ChunkedArray &arrays, ValidRunF &&handleValidRun, NullRunF &&handleNullRun)
+{
+    assert(type == arrays.type()->id());
+    for(auto &chunk : arrays.chunks())
+        iterateOverRuns<type>(*chunk, handleValidRun, handleNullRun);
+}
+
+template <arrow::Type::type type, typename ValidRunF, typename NullRunF>
+void iterateOverRuns(const arrow::Column &column, ValidRunF &&handleValidRun, NullRunF &&handleNullRun)
+{
+    return iterateOverRuns<type>(*column.data(), handleValidRun, handleNullRun);
+}
+
+// For fixed-width types: calls handleBatch(const T *values, int length, uint64_t validity)
+// for consecutive batches of (at most) 64 elements. Bit i of validity is set
+// when the i-th element of the batch is valid.
+template <arrow::Type::type type, typename BatchF>
+void iterateOverBatches(const arrow::Array &array, BatchF &&handleBatch)
+{
+    static_assert(hasFixedWidthValues<type>, "batches of values are available only for fixed-width types");
+    using T = typename TypeDescription<type>::StorageValueType;
+
+    const auto values = rawValues<T>(array);
+    const auto length = array.length();
+    const auto bitmap = array.null_count() ? array.null_bitmap_data() : nullptr;
+    const auto offset = array.offset();
+    for(int64_t start = 0; start < length; start += 64)
+    {
+        const auto batchLength = (int)std::min<int64_t>(64, length - start);
+        const auto allValid = batchLength == 64 ? ~uint64_t(0) : (uint64_t(1) << batchLength) - 1;
+        const auto validity = bitmap ? loadBits(bitmap, offset + start, batchLength) : allValid;
+        handleBatch(values + start, batchLength, validity);
+    }
+}
+
+template <arrow::Type::type type, typename BatchF>
+void iterateOverBatches(const arrow::ChunkedArray &arrays, BatchF &&handleBatch)
+{
+    assert(type == arrays.type()->id());
+    for(auto &chunk : arrays.chunks())
+        iterateOverBatches<type>(*chunk, handleBatch);
+}
+
+template <arrow::Type::type type, typename BatchF>
+void iterateOverBatches(const arrow::Column &column, BatchF &&handleBatch)
+{
+    return iterateOverBatches<type>(*column.data(), handleBatch);
+}
+
 inline void checkStatus(const arrow::Status &status)
 {
     if(!status.ok())
@@ -504,16 +809,16 @@ inline std::shared_ptr<arrow::Array> finish(arrow::ArrayBuilder &builder)
 }
 
 template<typename T>
-std::pair<std::shared_ptr<arrow::Buffer>, T*> allocateBuffer(size_t length)
+std::pair<std::shared_ptr<arrow::Buffer>, T*> allocateBuffer(size_t length, arrow::MemoryPool *pool = memoryPool())
 {
     std::shared_ptr<arrow::Buffer> ret{};
-    checkStatus(arrow::AllocateBuffer(length * sizeof(T), &ret));
+    checkStatus(arrow::AllocateBuffer(pool, length * sizeof(T), &ret));
     return { ret, reinterpret_cast<T*>(ret->mutable_data()) } ;
 }
 
 
-template<typename T>
-void toVector(std::vector<T> &out, const arrow::Array &array);
+template<typename T, typename Allocator>
+void toVector(std::vector<T, Allocator> &out, const arrow::Array &array);
 
 template<typename T>
 void toVector(std::vector<std::vector<T>> &out, const arrow::Array &array)
@@ -532,8 +837,8 @@ void toVector(std::vector<std::vector<T>> &out, const arrow::Array &array)
     );
 }
 
-template<typename T>
-void toVector(std::vector<T> &out, const arrow::Array &array)
+template<typename T, typename Allocator>
+void toVector(std::vector<T, Allocator> &out, const arrow::Array &array)
 {
     iterateOverGeneric
     (
@@ -697,6 +1002,8 @@ using DynamicJustVector = variant<std::vector<int64_t>, std::vector<double>, std
 DFH_EXPORT DynamicJustVector toJustVector(const arrow::ChunkedArray &chunkedArray);
 DFH_EXPORT DynamicJustVector toJustVector(const arrow::Column &column);
 
+DFH_EXPORT std::shared_ptr<arrow::Array> narrowNumericArray(std::shared_ptr<arrow::Array> array); // int64 -> smallest fitting integer type, double -> float if exact
+
 DFH_EXPORT DynamicField arrayAt(const arrow::Array &array, int64_t index);
 DFH_EXPORT DynamicField arrayAt(const arrow::ChunkedArray &array, int64_t index);
 DFH_EXPORT DynamicField arrayAt(const arrow::Column &column, int64_t index);
@@ -708,7 +1015,7 @@ struct DFH_EXPORT ChunkAccessor
 
     ChunkAccessor(const arrow::ChunkedArray &array);
     ChunkAccessor(const arrow::Column &column);
-    std::pair<const arrow::Array *, int32_t> locate(int64_t index) const;
+    std::pair<const arrow::Array *, int64_t> locate(int64_t index) const;
 
     template <arrow::Type::type type>
     auto valueAt(int64_t index) const
@@ -720,7 +1027,7 @@ struct DFH_EXPORT ChunkAccessor
     bool isNull(int64_t index);
 };
 
-DFH_EXPORT std::pair<std::shared_ptr<arrow::Array>, int32_t> locateChunk(const arrow::ChunkedArray &chunkedArray, int64_t index);
+DFH_EXPORT std::pair<std::shared_ptr<arrow::Array>, int64_t> locateChunk(const arrow::ChunkedArray &chunkedArray, int64_t index);
 
 template <arrow::Type::type type>
 auto columnValueAt(const arrow::Column &column, int64_t index)
@@ -754,22 +1061,22 @@ void iterateOverPairs(const arrow::ChunkedArray &array1, const arrow::ChunkedArr
 
     int64_t row = 0;
 
-    int32_t chunk1Length = (int32_t)(*chunks1Itr)->length(); // arrow specification says that array size is 32-bit
-    int32_t chunk2Length = (int32_t)(*chunks2Itr)->length(); // arrow specification says that array size is 32-bit
+    int64_t chunk1Length = (*chunks1Itr)->length();
+    int64_t chunk2Length = (*chunks2Itr)->length();
 
-    int32_t index1 = -1, index2 = -1;
+    int64_t index1 = -1, index2 = -1;
     for(; row < N; row++)
     {
         if(++index1 >= chunk1Length)
         {
             ++chunks1Itr;
-            chunk1Length = (int32_t)(*chunks1Itr)->length();
+            chunk1Length = (*chunks1Itr)->length();
             index1 = 0;
         }
         if(++index2 >= chunk2Length)
         {
             ++chunks2Itr;
-            chunk2Length = (int32_t)(*chunks2Itr)->length();
+            chunk2Length = (*chunks2Itr)->length();
             index2 = 0;
         }
 
@@ -797,22 +1104,22 @@ void iterateOverJustPairs(const arrow::ChunkedArray &array1, const arrow::Chunke
 
     int64_t row = 0;
 
-    int32_t chunk1Length = (int32_t) (*chunks1Itr)->length(); // arrow specification says that array size is 32-bit
-    int32_t chunk2Length = (int32_t) (*chunks2Itr)->length(); // arrow specification says that array size is 32-bit
+    int64_t chunk1Length = (*chunks1Itr)->length();
+    int64_t chunk2Length = (*chunks2Itr)->length();
 
-    int32_t index1 = -1, index2 = -1;
+    int64_t index1 = -1, index2 = -1;
     for( ; row < N; row++)
     {
         if(++index1 >= chunk1Length)
         {
             ++chunks1Itr;
-            chunk1Length = (int32_t)(*chunks1Itr)->length();
+            chunk1Length = (*chunks1Itr)->length();
             index1 = 0;
         }
         if(++index2 >= chunk2Length)
         {
             ++chunks2Itr;
-            chunk2Length = (int32_t)(*chunks2Itr)->length();
+            chunk2Length = (*chunks2Itr)->length();
             index2 = 0;
         }
 
@@ -844,17 +1151,17 @@ struct FixedSizeArrayBuilder
     T *nextValueToWrite{};
 
 
-    FixedSizeArrayBuilder(std::shared_ptr<arrow::DataType> type, int32_t length)
+    FixedSizeArrayBuilder(std::shared_ptr<arrow::DataType> type, int64_t length)
         : type(std::move(type))
         , length(length)
     {
         std::tie(valueBuffer, nextValueToWrite) = allocateBuffer<T>(length);
 
         static_assert(nullable == false); // would need null mask
-        static_assert(id == arrow::Type::INT64 || arrow::Type::DOUBLE); // would need another buffer
+        static_assert(std::is_arithmetic_v<T>); // would need another buffer
     }
 
-    explicit FixedSizeArrayBuilder(int32_t length)
+    explicit FixedSizeArrayBuilder(int64_t length)
         : FixedSizeArrayBuilder(getTypeSingleton<id>(), length)
     {
         // TODO: should eventually require that type is parameter-free
@@ -1 +1,221 @@
-#include "Benchmark.h"
\ No newline at end of file
+#include "Benchmark.h"
+
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // For even count, mean of the two middle values.
+    template<typename T>
+    T medianOf(std::vector<T> values)
+    {
+        const auto middle = values.begin() + values.size() / 2;
+        std::nth_element(values.begin(), middle, values.end());
+        if(values.size() % 2)
+            return *middle;
+
+        const auto lowerMiddle = *std::max_element(values.begin(), middle);
+        return lowerMiddle + (*middle - lowerMiddle) / 2;
+    }
+
+#ifdef __linux__
+    int openCounter(uint64_t config)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        // pid 0 and cpu -1: calling thread on any CPU
+        return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+#endif
+}
+
+HardwareCounterGroup::HardwareCounterGroup()
+{
+#ifdef __linux__
+    const uint64_t events[EventCount] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES };
+    for(int i = 0; i < EventCount; i++)
+        descriptors[i] = openCounter(events[i]);
+#else
+    for(auto &descriptor : descriptors)
+        descriptor = -1;
+#endif
+}
+
+HardwareCounterGroup::~HardwareCounterGroup()
+{
+#ifdef __linux__
+    for(auto descriptor : descriptors)
+        if(descriptor >= 0)
+            close(descriptor);
+#endif
+}
+
+bool HardwareCounterGroup::available() const
+{
+    for(auto descriptor : descriptors)
+        if(descriptor >= 0)
+            return true;
+    return false;
+}
+
+void HardwareCounterGroup::start()
+{
+#ifdef __linux__
+    for(auto descriptor : descriptors)
+    {
+        if(descriptor >= 0)
+        {
+            ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+            ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+HardwareCounters HardwareCounterGroup::stop()
+{
+    int64_t values[EventCount] = { -1, -1, -1, -1 };
+#ifdef __linux__
+    for(int i = 0; i < EventCount; i++)
+    {
+        if(descriptors[i] < 0)
+            continue;
+
+        ioctl(descriptors[i], PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t count = 0;
+        if(read(descriptors[i], &count, sizeof(count)) == sizeof(count))
+            values[i] = (int64_t)count;
+    }
+#endif
+    return HardwareCounters{ values[0], values[1], values[2], values[3] };
+}
+
+MeasureSeries::Duration MeasureSeries::bestTime() const
+{
+    if(times.empty())
+        throw std::runtime_error("no measures");
+
+    return *std::min_element(times.begin(), times.end());
+}
+
+MeasureSeries::Duration MeasureSeries::medianTime() const
+{
+    if(times.empty())
+        throw std::runtime_error("no measures");
+
+    return medianOf(times);
+}
+
+MeasureSeries::Duration MeasureSeries::percentileTime(double p) const
+{
+    if(times.empty())
+        throw std::runtime_error("no measures");
+    if(p < 0 || p > 1)
+        throw std::runtime_error("percentile must be in [0, 1], got " + std::to_string(p));
+
+    auto sorted = times;
+    std::sort(sorted.begin(), sorted.end());
+    const auto rank = (size_t)std::ceil(p * sorted.size());
+    return sorted[std::max<size_t>(rank, 1) - 1];
+}
+
+MeasureSeries::Duration MeasureSeries::medianAbsoluteDeviation() const
+{
+    const auto median = medianTime();
+    std::vector<Duration> deviations;
+    deviations.reserve(times.size());
+    for(auto time : times)
+        deviations.push_back(time > median ? time - median : median - time);
+    return medianOf(deviations);
+}
+
+double MeasureSeries::itemsPerSecond() const
+{
+    const auto seconds = std::chrono::duration<double>(medianTime()).count();
+    return seconds > 0 ? itemsPerIteration / seconds : 0;
+}
+
+double MeasureSeries::bytesPerSecond() const
+{
+    const auto seconds = std::chrono::duration<double>(medianTime()).count();
+    return seconds > 0 ? bytesPerIteration / seconds : 0;
+}
+
+HardwareCounters MeasureSeries::medianCounters() const
+{
+    HardwareCounters ret;
+    if(counters.empty())
+        return ret;
+
+    const auto medianOfField = [&] (int64_t HardwareCounters::*field)
+    {
+        std::vector<int64_t> values;
+        for(auto &sample : counters)
+            values.push_back(sample.*field);
+        return medianOf(values);
+    };
+    ret.cycles = medianOfField(&HardwareCounters::cycles);
+    ret.instructions = medianOfField(&HardwareCounters::instructions);
+    ret.cacheMisses = medianOfField(&HardwareCounters::cacheMisses);
+    ret.branchMisses = medianOfField(&HardwareCounters::branchMisses);
+    return ret;
+}
+
+void MeasureSeries::print(std::ostream &out) const
+{
+    const auto ms = [] (Duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+
+    const auto flags = out.flags();
+    const auto precision = out.precision(3);
+    out << std::fixed << name << ": median " << ms(medianTime()) << " ms, p95 " << ms(percentileTime(0.95))
+        << " ms, MAD " << ms(medianAbsoluteDeviation()) << " ms, best " << ms(bestTime()) << " ms";
+    if(itemsPerIteration)
+        out << ", " << itemsPerSecond() / 1e6 << " M items/s";
+    if(bytesPerIteration)
+        out << ", " << bytesPerSecond() / (1 << 20) << " MiB/s";
+
+    const auto hardware = medianCounters();
+    if(hardware.cycles >= 0 && hardware.instructions >= 0 && hardware.cycles > 0)
+        out << ", IPC " << (double)hardware.instructions / hardware.cycles;
+    if(hardware.cacheMisses >= 0)
+        out << ", cache misses " << hardware.cacheMisses;
+    if(hardware.branchMisses >= 0)
+        out << ", branch misses " << hardware.branchMisses;
+    out << std::endl;
+
+    out.precision(precision);
+    out.flags(flags);
+}
+
+std::string SweepPoint::label() const
+{
+    std::ostringstream out;
+    out << "[size=" << size << " nulls=" << nullShare << " chunks=" << chunkCount << "]";
+    return out.str();
+}
+
+std::vector<SweepPoint> sweepGrid(const std::vector<int64_t> &sizes, const std::vector<double> &nullShares, const std::vector<int> &chunkCounts)
+{
+    std::vector<SweepPoint> ret;
+    for(auto size : sizes)
+        for(auto nullShare : nullShares)
+            for(auto chunkCount : chunkCounts)
+                ret.push_back(SweepPoint{size, nullShare, chunkCount});
+    return ret;
+}
@@ -4,6 +4,7 @@
 #include <chrono>
 #include <functional>
 #include <iostream>
+#include <ostream>
 #include <string>
 #include <type_traits>
 #include <utility>
@@ -68,30 +69,65 @@ static auto measure(std::string text, F&& func, Args&&... args)
     return results;
 }
 
-struct MeasureSeries
+// Hardware event counts for a single measured call, -1 when not available.
+struct HardwareCounters
 {
-    using Duration = std::chrono::microseconds;
+    int64_t cycles = -1;
+    int64_t instructions = -1;
+    int64_t cacheMisses = -1;
+    int64_t branchMisses = -1;
+};
+
+// Counts hardware events of the calling thread. Uses perf_event_open on Linux,
+// elsewhere (or if the kernel doesn't allow it) all counters are reported as unavailable.
+class DFH_EXPORT HardwareCounterGroup
+{
+    static constexpr int EventCount = 4;
+    int descriptors[EventCount];
+
+public:
+    HardwareCounterGroup();
+    ~HardwareCounterGroup();
+
+    HardwareCounterGroup(const HardwareCounterGroup &) = delete;
+    HardwareCounterGroup &operator=(const HardwareCounterGroup &) = delete;
+
+    bool available() const;
+    void start();
+    HardwareCounters stop();
+};
+
+struct DFH_EXPORT MeasureSeries
+{
+    using Duration = std::chrono::nanoseconds;
     std::string name;
     std::vector<Duration> times;
+    std::vector<HardwareCounters> counters; // empty or one per time
+
+    // work done by a single call, used to report throughput
+    int64_t itemsPerIteration = 0;
+    int64_t bytesPerIteration = 0;
 
     explicit MeasureSeries(std::string name)
         : name(std::move(name)) 
     {}
 
-    Duration bestTime()
-    {
-        if(times.empty())
-            throw std::runtime_error("no measures");
+    Duration bestTime() const;
+    Duration medianTime() const;
+    Duration percentileTime(double p) const; // p in [0, 1], nearest-rank
+    Duration medianAbsoluteDeviation() const;
 
-        return *std::min_element(times.begin(), times.end());
-    }
+    double itemsPerSecond() const; // at median time, 0 if items were not given
+    double bytesPerSecond() const;
+    HardwareCounters medianCounters() const;
 
     void add(Duration d)
     {
         times.push_back(d);
     }
-};
 
+    void print(std::ostream &out) const;
+};
 
 template<typename Policy, typename F, typename ...Args>
 static auto measure(std::string text, Policy &&p, F&& func, Args&&... args)
@@ -124,3 +160,77 @@ static auto measure(std::string text, Policy &&p, F&& func, Args&&... args)
 
     }
 }
+
+// Prevents the compiler from discarding computation of the value.
+template<typename T>
+inline void doNotOptimizeAway(const T &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static const void * volatile sink; // the pointer itself is volatile, so the store is kept
+    sink = &value;
+#endif
+}
+
+struct MicroBenchmarkOptions
+{
+    int warmupIterations = 3; // calls made before measuring, not recorded
+    int64_t iterations = 10; // minimal count of measured calls
+    std::chrono::milliseconds minTime = 100ms; // minimal total time of measured calls
+    int64_t items = 0; // rows, fields, etc. processed by a single call
+    int64_t bytes = 0;
+    bool hardwareCounters = true;
+};
+
+// Measures func after warming up, collecting hardware counters when possible.
+template<typename F>
+MeasureSeries microBenchmark(std::string name, const MicroBenchmarkOptions &options, F &&func)
+{
+    using namespace std::chrono;
+
+    MeasureSeries series{std::move(name)};
+    series.itemsPerIteration = options.items;
+    series.bytesPerIteration = options.bytes;
+
+    for(int i = 0; i < options.warmupIterations; i++)
+        func();
+
+    HardwareCounterGroup hardware;
+    const bool collectCounters = options.hardwareCounters && hardware.available();
+
+    const auto startTime = steady_clock::now();
+    while((int64_t)series.times.size() < options.iterations || steady_clock::now() - startTime < options.minTime)
+    {
+        if(collectCounters)
+            hardware.start();
+        const auto start = steady_clock::now();
+        if constexpr(std::is_same_v<void, std::invoke_result_t<F>>)
+        {
+            func();
+        }
+        else
+        {
+            const auto value = func();
+            doNotOptimizeAway(value);
+        }
+        const auto time = steady_clock::now() - start;
+        if(collectCounters)
+            series.counters.push_back(hardware.stop());
+        series.add(duration_cast<MeasureSeries::Duration>(time));
+    }
+    return series;
+}
+
+// A single combination of parameters in a sweep over benchmark inputs.
+struct DFH_EXPORT SweepPoint
+{
+    int64_t size;
+    double nullShare;
+    int chunkCount;
+
+    std::string label() const; // e.g. "[size=1000 nulls=0.1 chunks=4]"
+};
+
+// Cartesian product of given parameter values.
+DFH_EXPORT std::vector<SweepPoint> sweepGrid(const std::vector<int64_t> &sizes, const std::vector<double> &nullShares, const std::vector<int> &chunkCounts);
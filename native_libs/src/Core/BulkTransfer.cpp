@@ -0,0 +1,82 @@
+#include "BulkTransfer.h"
+
+#include <bitset>
+
+void validateRange(const arrow::Array &array, int64_t from, int64_t to)
+{
+    if(from < 0 || to < from || to > array.length())
+        THROW("wrong range [{}, {}) when array's length={}", from, to, array.length());
+}
+
+int64_t copyValidity(const arrow::Array &array, int64_t from, int64_t to, uint8_t *outBitmap)
+{
+    validateRange(array, from, to);
+
+    const auto length = to - from;
+    const auto byteCount = arrow::BitUtil::BytesForBits(length);
+    if(array.null_count() == 0)
+    {
+        std::memset(outBitmap, 0xFF, byteCount);
+        if(length % 8)
+            outBitmap[byteCount - 1] = uint8_t((1 << (length % 8)) - 1);
+        return 0;
+    }
+
+    const auto bitmap = array.null_bitmap_data();
+    const auto offset = array.offset() + from;
+    int64_t validCount = 0;
+    for(int64_t start = 0; start < length; start += 64)
+    {
+        const auto batchLength = (int)std::min<int64_t>(64, length - start);
+        const auto word = loadBits(bitmap, offset + start, batchLength);
+        validCount += std::bitset<64>(word).count();
+        std::memcpy(outBitmap + start / 8, &word, (batchLength + 7) / 8); // little endian, as is Arrow bitmap
+    }
+    return length - validCount;
+}
+
+int64_t copyStringOffsets(const arrow::StringArray &array, int64_t from, int64_t to, int32_t *outOffsets)
+{
+    validateRange(array, from, to);
+
+    const auto offsets = array.raw_value_offsets();
+    const auto base = offsets[from];
+    for(int64_t i = from; i <= to; i++)
+        outOffsets[i - from] = offsets[i] - base;
+    return offsets[to] - base;
+}
+
+int64_t stringDataLength(const arrow::StringArray &array, int64_t from, int64_t to)
+{
+    validateRange(array, from, to);
+    return array.value_offset(to) - array.value_offset(from);
+}
+
+void copyStringData(const arrow::StringArray &array, int64_t from, int64_t to, char *outData)
+{
+    const auto byteCount = stringDataLength(array, from, to);
+    if(byteCount)
+        std::memcpy(outData, array.value_data()->data() + array.value_offset(from), byteCount);
+}
+
+void appendStrings(arrow::StringBuilder &builder, const int32_t *offsets, const char *data, int64_t count, const uint8_t *validityBitmap)
+{
+    if(count <= 0)
+        return;
+
+    if(offsets[0] < 0)
+        THROW("string offsets must not be negative, first offset is {}", offsets[0]);
+    for(int64_t i = 0; i < count; i++)
+        if(offsets[i + 1] < offsets[i])
+            THROW("string offsets must not decrease, offset {} is {} and next one is {}", i, offsets[i], offsets[i + 1]);
+
+    checkStatus(builder.Reserve(count));
+    checkStatus(builder.ReserveData(offsets[count] - offsets[0]));
+    for(int64_t i = 0; i < count; i++)
+    {
+        if(validityBitmap && !arrow::BitUtil::GetBit(validityBitmap, i))
+            checkStatus(builder.AppendNull());
+        else
+            checkStatus(builder.Append(data + offsets[i], offsets[i + 1] - offsets[i]));
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "ArrowUtilities.h"
+
+// Range-based copying of array contents to caller-provided buffers and appending
+// whole buffers to builders. These back the bulk C API calls, so that a foreign
+// caller crosses the library boundary once per range rather than once per element.
+//
+// Validity is exchanged as a bitmap in Arrow layout: bit i (LSB first) of the
+// bitmap describes i-th element of the range, set bit means a valid value.
+
+// Throws unless [from, to) is a range within array.
+DFH_EXPORT void validateRange(const arrow::Array &array, int64_t from, int64_t to);
+
+// Writes validity of elements [from, to) to BytesForBits(to - from) bytes of outBitmap.
+// Bits past the range in the last byte are cleared. Returns the null count in the range.
+DFH_EXPORT int64_t copyValidity(const arrow::Array &array, int64_t from, int64_t to, uint8_t *outBitmap);
+
+// Writes to - from + 1 offsets to outOffsets, rebased so the first one is zero.
+// Returns byte length of the strings in the range, i.e. the last offset.
+DFH_EXPORT int64_t copyStringOffsets(const arrow::StringArray &array, int64_t from, int64_t to, int32_t *outOffsets);
+
+// Writes bytes of strings [from, to) to outData, that must hold stringDataLength bytes.
+DFH_EXPORT void copyStringData(const arrow::StringArray &array, int64_t from, int64_t to, char *outData);
+DFH_EXPORT int64_t stringDataLength(const arrow::StringArray &array, int64_t from, int64_t to);
+
+// Appends count strings: i-th is data[offsets[i], offsets[i+1]). Validity bitmap may be null if all are valid.
+DFH_EXPORT void appendStrings(arrow::StringBuilder &builder, const int32_t *offsets, const char *data, int64_t count, const uint8_t *validityBitmap);
+
+// Writes values of elements [from, to) to outValues. Values of null elements are unspecified.
+template<typename T>
+void copyValues(const arrow::Array &array, int64_t from, int64_t to, T *outValues)
+{
+    validateRange(array, from, to);
+    if(to > from)
+        std::memcpy(outValues, rawValues<T>(array) + from, (to - from) * sizeof(T));
+}
+
+// Appends count values. Validity bitmap may be null if all values are valid.
+// Values under null bits are ignored.
+template<typename Builder, typename T>
+void appendValues(Builder &builder, const T *values, int64_t count, const uint8_t *validityBitmap)
+{
+    if(!validityBitmap)
+        return checkStatus(builder.AppendValues(values, count));
+
+    // builder takes validity as a byte per value, bitmap is expanded in batches
+    constexpr int64_t BatchSize = 1024;
+    uint8_t validBytes[BatchSize];
+    checkStatus(builder.Reserve(count));
+    for(int64_t start = 0; start < count; start += BatchSize)
+    {
+        const auto batchLength = std::min(BatchSize, count - start);
+        for(int64_t i = 0; i < batchLength; i++)
+            validBytes[i] = arrow::BitUtil::GetBit(validityBitmap, start + i);
+        checkStatus(builder.AppendValues(values + start, batchLength, validBytes));
+    }
+}
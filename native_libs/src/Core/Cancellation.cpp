@@ -0,0 +1,84 @@
+#include "Cancellation.h"
+
+#include <algorithm>
+
+namespace
+{
+    thread_local std::shared_ptr<CancellationToken> boundToken;
+}
+
+void CancellationToken::cancel() noexcept
+{
+    cancelled = true;
+}
+
+bool CancellationToken::isCancelled() const noexcept
+{
+    return cancelled;
+}
+
+void CancellationToken::throwIfCancelled() const
+{
+    if(isCancelled())
+        throw OperationCancelled{};
+}
+
+void CancellationToken::setProgressCallback(ProgressCallback callback, void *userData)
+{
+    std::unique_lock<std::mutex> lock{ progressMx };
+    progressCallback = callback;
+    progressUserData = userData;
+}
+
+// The callback is called without holding the lock, so it may set a new callback or report
+// progress itself. Reports from other threads meanwhile are dropped rather than waiting,
+// the following ones carry newer progress anyway.
+void CancellationToken::reportProgress(double fraction, const char *phase)
+{
+    if(reporting.exchange(true))
+        return;
+
+    ProgressCallback callback;
+    void *userData;
+    {
+        std::unique_lock<std::mutex> lock{ progressMx };
+        callback = progressCallback;
+        userData = progressUserData;
+    }
+    if(callback)
+        callback(userData, std::clamp(fraction, 0.0, 1.0), phase);
+    reporting = false;
+}
+
+CancellationScope::CancellationScope(std::shared_ptr<CancellationToken> token) noexcept
+    : previous(std::move(boundToken))
+{
+    boundToken = std::move(token);
+}
+
+CancellationScope::~CancellationScope()
+{
+    boundToken = std::move(previous);
+}
+
+const std::shared_ptr<CancellationToken> &CancellationScope::current() noexcept
+{
+    return boundToken;
+}
+
+void CancellationScope::bind(std::shared_ptr<CancellationToken> token) noexcept
+{
+    boundToken = std::move(token);
+}
+
+void checkCancellation()
+{
+    if(boundToken)
+        boundToken->throwIfCancelled();
+}
+
+void reportProgress(double fraction, const char *phase)
+{
+    if(boundToken)
+        boundToken->reportProgress(fraction, phase);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+#include "Common.h"
+
+// Receives progress of a running operation: fraction done (0 to 1) and the name of the current phase.
+// It might be called from a worker thread, but never concurrently for the same token.
+using ProgressCallback = void(*)(void *userData, double fraction, const char *phase);
+
+struct OperationCancelled : std::runtime_error
+{
+    OperationCancelled() : std::runtime_error("operation was cancelled") {}
+};
+
+// Shared between the operation and the one who wants to stop it.
+// Operations check it cooperatively at chunk / morsel boundaries and unwind
+// by throwing OperationCancelled.
+class DFH_EXPORT CancellationToken
+{
+    std::atomic_bool cancelled{false};
+
+    std::mutex progressMx; // guards the callback and its data, not the call
+    ProgressCallback progressCallback{};
+    void *progressUserData{};
+    std::atomic_bool reporting{false}; // set while the callback runs
+
+public:
+    void cancel() noexcept; // can be called from any thread
+    bool isCancelled() const noexcept;
+    void throwIfCancelled() const;
+
+    void setProgressCallback(ProgressCallback callback, void *userData);
+    void reportProgress(double fraction, const char *phase); // dropped if the callback is already running
+};
+
+// Binds token to the calling thread until the end of scope.
+class DFH_EXPORT CancellationScope
+{
+    std::shared_ptr<CancellationToken> previous;
+
+public:
+    explicit CancellationScope(std::shared_ptr<CancellationToken> token) noexcept;
+    ~CancellationScope();
+
+    CancellationScope(const CancellationScope &) = delete;
+    CancellationScope &operator=(const CancellationScope &) = delete;
+
+    static const std::shared_ptr<CancellationToken> &current() noexcept; // token bound to the calling thread, may be null
+    static void bind(std::shared_ptr<CancellationToken> token) noexcept; // binds without scope, null unbinds
+};
+
+// Helpers for kernels, using the token bound to the calling thread (no-op if there is none).
+DFH_EXPORT void checkCancellation(); // throws OperationCancelled if the operation was cancelled
+DFH_EXPORT void reportProgress(double fraction, const char *phase);
@@ -3,6 +3,8 @@
 
 #include "Common.h"
 #include "Logger.h"
+#include "MemoryTracking.h"
+#include "Tracing.h"
 
 DFH_EXPORT void setError(const char **outError, const char *errorToSet, const char *functionName) noexcept;
 DFH_EXPORT void clearError(const char **outError) noexcept;
@@ -13,6 +15,10 @@ auto translateExceptionToError(const char *functionName, const char **outError,
     using ResultType = std::invoke_result_t<Function>;
     constexpr auto returnVoid = std::is_same_v<void, ResultType>;
 
+    // allocations made by the call are accounted under its name
+    MemoryTrackingScope trackingScope{functionName};
+    TraceSpan traceSpan{"api", functionName, Tracing::ApiCallMinDurationNs};
+
     try
     {
         clearError(outError);
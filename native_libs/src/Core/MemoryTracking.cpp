@@ -0,0 +1,189 @@
+#include "MemoryTracking.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace
+{
+    thread_local const char *currentAllocationTag = nullptr;
+
+    // Tags are (almost always) string literals, so the same pointer is used again and again.
+    thread_local std::unordered_map<const char *, TrackingMemoryPool::AtomicStats *> internedTags;
+
+    TrackingMemoryPool::AtomicStats *&headerOf(uint8_t *base)
+    {
+        return *reinterpret_cast<TrackingMemoryPool::AtomicStats **>(base);
+    }
+}
+
+void TrackingMemoryPool::AtomicStats::allocated(int64_t size) noexcept
+{
+    const auto current = currentBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    totalBytes.fetch_add(size, std::memory_order_relaxed);
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    auto peak = peakBytes.load(std::memory_order_relaxed);
+    while(current > peak && !peakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed))
+        ;
+}
+
+void TrackingMemoryPool::AtomicStats::freed(int64_t size) noexcept
+{
+    currentBytes.fetch_sub(size, std::memory_order_relaxed);
+}
+
+void TrackingMemoryPool::AtomicStats::reset() noexcept
+{
+    peakBytes = currentBytes.load();
+    totalBytes = 0;
+    allocationCount = 0;
+}
+
+AllocationStats TrackingMemoryPool::AtomicStats::load() const noexcept
+{
+    AllocationStats ret;
+    ret.currentBytes = currentBytes.load(std::memory_order_relaxed);
+    ret.peakBytes = peakBytes.load(std::memory_order_relaxed);
+    ret.totalBytes = totalBytes.load(std::memory_order_relaxed);
+    ret.allocationCount = allocationCount.load(std::memory_order_relaxed);
+    return ret;
+}
+
+TrackingMemoryPool::TrackingMemoryPool(arrow::MemoryPool *pool)
+    : pool(pool)
+{}
+
+TrackingMemoryPool &TrackingMemoryPool::instance()
+{
+    static TrackingMemoryPool trackingPool{arrow::default_memory_pool()};
+    return trackingPool;
+}
+
+TrackingMemoryPool::AtomicStats *TrackingMemoryPool::statsFor(const char *tag)
+{
+    if(!tag)
+        return nullptr;
+
+    // cache is per thread, but there is only one tracking pool that uses it
+    if(auto itr = internedTags.find(tag); itr != internedTags.end())
+        return itr->second;
+
+    try
+    {
+        std::unique_lock<std::mutex> lock{ mx };
+        auto stats = &tags[tag];
+        internedTags.emplace(tag, stats);
+        return stats;
+    }
+    catch(...)
+    {
+        return nullptr; // allocation can still be made, it is accounted only globally
+    }
+}
+
+arrow::Status TrackingMemoryPool::Allocate(int64_t size, uint8_t **out)
+{
+    const auto stats = statsFor(MemoryTrackingScope::currentTag());
+    uint8_t *base = nullptr;
+    auto status = pool->Allocate(size + HeaderSize, &base);
+    if(!status.ok())
+        return status;
+
+    headerOf(base) = stats;
+    global.allocated(size);
+    if(stats)
+        stats->allocated(size);
+    *out = base + HeaderSize;
+    return status;
+}
+
+arrow::Status TrackingMemoryPool::Reallocate(int64_t old_size, int64_t new_size, uint8_t **ptr)
+{
+    const auto stats = statsFor(MemoryTrackingScope::currentTag());
+    auto base = *ptr - HeaderSize;
+    const auto oldStats = headerOf(base);
+    auto status = pool->Reallocate(old_size + HeaderSize, new_size + HeaderSize, &base);
+    if(!status.ok())
+        return status;
+
+    global.freed(old_size);
+    if(oldStats)
+        oldStats->freed(old_size);
+    headerOf(base) = stats;
+    global.allocated(new_size);
+    if(stats)
+        stats->allocated(new_size);
+    *ptr = base + HeaderSize;
+    return status;
+}
+
+void TrackingMemoryPool::Free(uint8_t *buffer, int64_t size)
+{
+    const auto base = buffer - HeaderSize;
+    global.freed(size);
+    if(const auto stats = headerOf(base))
+        stats->freed(size);
+    pool->Free(base, size + HeaderSize);
+}
+
+int64_t TrackingMemoryPool::bytes_allocated() const
+{
+    return global.currentBytes.load(std::memory_order_relaxed);
+}
+
+int64_t TrackingMemoryPool::max_memory() const
+{
+    return global.peakBytes.load(std::memory_order_relaxed);
+}
+
+AllocationStats TrackingMemoryPool::globalStats() const
+{
+    return global.load();
+}
+
+AllocationStats TrackingMemoryPool::tagStats(const std::string &tag) const
+{
+    std::unique_lock<std::mutex> lock{ mx };
+    if(auto itr = tags.find(tag); itr != tags.end())
+        return itr->second.load();
+    return {};
+}
+
+std::vector<std::string> TrackingMemoryPool::knownTags() const
+{
+    std::unique_lock<std::mutex> lock{ mx };
+    std::vector<std::string> ret;
+    for(auto &&[tag, stats] : tags)
+        if(stats.currentBytes.load(std::memory_order_relaxed) != 0 || stats.allocationCount.load(std::memory_order_relaxed) != 0)
+            ret.push_back(tag);
+    return ret;
+}
+
+// Counters of tags are never freed, as headers of live buffers may point to them.
+void TrackingMemoryPool::reset()
+{
+    std::unique_lock<std::mutex> lock{ mx };
+    global.reset();
+    for(auto &&[tag, stats] : tags)
+        stats.reset();
+}
+
+arrow::MemoryPool *memoryPool()
+{
+    return &TrackingMemoryPool::instance();
+}
+
+MemoryTrackingScope::MemoryTrackingScope(const char *tag) noexcept
+    : previousTag(currentAllocationTag)
+{
+    currentAllocationTag = tag;
+}
+
+MemoryTrackingScope::~MemoryTrackingScope()
+{
+    currentAllocationTag = previousTag;
+}
+
+const char *MemoryTrackingScope::currentTag() noexcept
+{
+    return currentAllocationTag;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <arrow/memory_pool.h>
+
+#include "Common.h"
+
+struct AllocationStats
+{
+    int64_t currentBytes = 0; // bytes allocated and not yet freed
+    int64_t peakBytes = 0; // the highest observed value of currentBytes
+    int64_t totalBytes = 0; // cumulative bytes allocated (frees don't decrease it)
+    int64_t allocationCount = 0; // number of allocations (reallocations count as new ones)
+};
+
+// Memory pool that forwards to the Arrow's default pool, while recording
+// allocation statistics globally and per operation tag.
+//
+// Tag is a thread-local, set for the duration of scope with MemoryTrackingScope
+// (every C API call made through TRANSLATE_EXCEPTION is tagged with its function name).
+// Freeing memory is accounted to the tag that allocated it, even if happens under another tag.
+// Allocations made when no tag is set are accounted only globally.
+//
+// Allocating and freeing only update atomic counters. Each buffer is preceded by a header
+// pointing to the counters of its tag; these counters live as long as the pool, so the header
+// stays valid whatever happens to the tag. Each thread remembers the counters of the tags it
+// used, the lock is taken only on the first allocation with a tag on a thread.
+class DFH_EXPORT TrackingMemoryPool : public arrow::MemoryPool
+{
+public:
+    struct AtomicStats
+    {
+        std::atomic<int64_t> currentBytes{0};
+        std::atomic<int64_t> peakBytes{0};
+        std::atomic<int64_t> totalBytes{0};
+        std::atomic<int64_t> allocationCount{0};
+
+        void allocated(int64_t size) noexcept;
+        void freed(int64_t size) noexcept;
+        void reset() noexcept; // keeps only the current bytes
+        AllocationStats load() const noexcept;
+    };
+
+    // Keeps buffers aligned as the underlying pool does (Arrow aligns to 64 bytes).
+    static constexpr int64_t HeaderSize = 64;
+
+private:
+    arrow::MemoryPool *pool{};
+
+    AtomicStats global;
+
+    mutable std::mutex mx; // guards tags, not the counters
+    std::map<std::string, AtomicStats> tags; // node-based and never erased, so headers can point to elements
+
+    AtomicStats *statsFor(const char *tag); // interned, nullptr for no tag
+
+public:
+    explicit TrackingMemoryPool(arrow::MemoryPool *pool);
+
+    static TrackingMemoryPool &instance();
+
+    arrow::Status Allocate(int64_t size, uint8_t **out) override;
+    arrow::Status Reallocate(int64_t old_size, int64_t new_size, uint8_t **ptr) override;
+    void Free(uint8_t *buffer, int64_t size) override;
+    int64_t bytes_allocated() const override;
+    int64_t max_memory() const override;
+
+    AllocationStats globalStats() const;
+    AllocationStats tagStats(const std::string &tag) const; // zeroed stats if tag is not known
+    std::vector<std::string> knownTags() const; // tags with live memory or allocations since the last reset
+
+    // Clears peaks and cumulative counters, tags that have no live allocations are no longer listed.
+    // Current byte counts are kept, as the memory is still allocated.
+    void reset();
+};
+
+// Pool to be used for all allocations made by the library.
+DFH_EXPORT arrow::MemoryPool *memoryPool();
+
+// Sets the allocation tag for the current thread until the end of scope.
+// Tags are remembered by address, so they must be string literals (or otherwise never change).
+class DFH_EXPORT MemoryTrackingScope
+{
+    const char *previousTag{};
+
+public:
+    explicit MemoryTrackingScope(const char *tag) noexcept;
+    ~MemoryTrackingScope();
+
+    MemoryTrackingScope(const MemoryTrackingScope &) = delete;
+    MemoryTrackingScope &operator=(const MemoryTrackingScope &) = delete;
+
+    static const char *currentTag() noexcept;
+};
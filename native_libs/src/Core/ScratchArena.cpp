@@ -0,0 +1,279 @@
+#include "ScratchArena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <arrow/memory_pool.h>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace
+{
+    constexpr size_t SmallAlignment = 64; // as required by arrow buffers
+    constexpr int MinSizeClassLog2 = 16;
+    static_assert(ScratchArena::MinCachedSize == size_t(1) << MinSizeClassLog2);
+
+    std::atomic<size_t> highWatermarkBytes{ScratchArena::DefaultHighWatermark};
+    std::atomic<size_t> totalCached{0}; // sum of cachedBytes() of all arenas
+    thread_local bool arenaDestroyed = false;
+
+    int log2Floor(size_t value)
+    {
+        int ret = 0;
+        while(value >>= 1)
+            ++ret;
+        return ret;
+    }
+
+    // Four classes for each power of two: 2^k * {1, 1.25, 1.5, 1.75}
+    size_t sizeClass(size_t size)
+    {
+        auto exponent = log2Floor(size);
+        const auto base = size_t(1) << exponent;
+        const auto quarter = base / 4;
+        auto sub = (size - base + quarter - 1) / quarter;
+        if(sub == 4)
+        {
+            ++exponent;
+            sub = 0;
+        }
+        return (exponent - MinSizeClassLog2) * 4 + sub;
+    }
+
+    size_t sizeOfClass(size_t sizeClass)
+    {
+        const auto base = size_t(1) << (sizeClass / 4 + MinSizeClassLog2);
+        return base + (sizeClass % 4) * (base / 4);
+    }
+
+    size_t alignmentFor(size_t size)
+    {
+        return size >= ScratchArena::HugePageSize ? ScratchArena::HugePageSize : SmallAlignment;
+    }
+
+    size_t roundUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    void *allocateBlock(size_t size)
+    {
+        const auto alignment = alignmentFor(size);
+        const auto allocatedSize = roundUp(std::max<size_t>(size, 1), alignment);
+#ifdef _WIN32
+        auto ret = _aligned_malloc(allocatedSize, alignment);
+#else
+        void *ret = nullptr;
+        if(posix_memalign(&ret, alignment, allocatedSize) != 0)
+            ret = nullptr;
+#endif
+        if(!ret)
+            throw std::bad_alloc{};
+
+#ifdef __linux__
+        // failure is not an error, we just won't get huge pages
+        if(alignment == ScratchArena::HugePageSize)
+            madvise(ret, allocatedSize, MADV_HUGEPAGE);
+#endif
+        return ret;
+    }
+
+    void freeBlock(void *block)
+    {
+#ifdef _WIN32
+        _aligned_free(block);
+#else
+        std::free(block);
+#endif
+    }
+}
+
+ScratchArena::~ScratchArena()
+{
+    trim(0);
+    arenaDestroyed = true;
+}
+
+ScratchArena &ScratchArena::local()
+{
+    thread_local ScratchArena arena;
+    return arena;
+}
+
+void *ScratchArena::acquireLocal(size_t size)
+{
+    if(arenaDestroyed)
+        return allocateBlock(size);
+    return local().acquire(size);
+}
+
+void ScratchArena::releaseLocal(void *block, size_t size)
+{
+    if(arenaDestroyed)
+        freeBlock(block);
+    else
+        local().release(block, size);
+}
+
+void *ScratchArena::acquire(size_t size)
+{
+    if(size < MinCachedSize)
+        return allocateBlock(size);
+
+    const auto classIndex = sizeClass(size);
+    if(classIndex < freeBlocks.size() && !freeBlocks[classIndex].empty())
+    {
+        auto ret = freeBlocks[classIndex].back();
+        freeBlocks[classIndex].pop_back();
+        cached -= sizeOfClass(classIndex);
+        totalCached.fetch_sub(sizeOfClass(classIndex), std::memory_order_relaxed);
+        return ret;
+    }
+
+    return allocateBlock(sizeOfClass(classIndex));
+}
+
+void ScratchArena::release(void *block, size_t size)
+{
+    if(!block)
+        return;
+
+    if(size < MinCachedSize)
+    {
+        freeBlock(block);
+        return;
+    }
+
+    const auto classIndex = sizeClass(size);
+    const auto blockSize = sizeOfClass(classIndex);
+    const auto limit = highWatermark();
+
+    // room for the block is reserved first, so that concurrent releases can't overshoot the limit together
+    const auto reserve = [&]
+    {
+        if(totalCached.fetch_add(blockSize, std::memory_order_relaxed) + blockSize <= limit)
+            return true;
+        totalCached.fetch_sub(blockSize, std::memory_order_relaxed);
+        return false;
+    };
+    if(!reserve())
+    {
+        const auto total = totalCached.load(std::memory_order_relaxed);
+        const auto othersCached = total - std::min(cached, total);
+        trim(limit / 2 > othersCached ? limit / 2 - othersCached : 0);
+        if(!reserve())
+        {
+            freeBlock(block); // memory is cached by other threads
+            return;
+        }
+    }
+
+    if(classIndex >= freeBlocks.size())
+        freeBlocks.resize(classIndex + 1);
+
+    freeBlocks[classIndex].push_back(block);
+    cached += blockSize;
+}
+
+void ScratchArena::trim(size_t targetCachedBytes)
+{
+    // biggest blocks go first, they are the least likely to be reused
+    for(auto classIndex = freeBlocks.size(); classIndex-- > 0 && cached > targetCachedBytes; )
+    {
+        auto &blocks = freeBlocks[classIndex];
+        while(!blocks.empty() && cached > targetCachedBytes)
+        {
+            freeBlock(blocks.back());
+            blocks.pop_back();
+            cached -= sizeOfClass(classIndex);
+            totalCached.fetch_sub(sizeOfClass(classIndex), std::memory_order_relaxed);
+        }
+    }
+}
+
+size_t ScratchArena::highWatermark()
+{
+    return highWatermarkBytes.load(std::memory_order_relaxed);
+}
+
+void ScratchArena::setHighWatermark(size_t bytes)
+{
+    highWatermarkBytes.store(bytes, std::memory_order_relaxed);
+}
+
+size_t ScratchArena::totalCachedBytes()
+{
+    return totalCached.load(std::memory_order_relaxed);
+}
+
+namespace
+{
+    class ScratchMemoryPool : public arrow::MemoryPool
+    {
+        std::atomic<int64_t> allocated{0};
+        std::atomic<int64_t> peak{0};
+
+        void added(int64_t size)
+        {
+            const auto current = allocated.fetch_add(size) + size;
+            auto previousPeak = peak.load();
+            while(current > previousPeak && !peak.compare_exchange_weak(previousPeak, current))
+                ;
+        }
+
+    public:
+        arrow::Status Allocate(int64_t size, uint8_t **out) override
+        {
+            try
+            {
+                *out = static_cast<uint8_t *>(ScratchArena::acquireLocal(size));
+            }
+            catch(std::bad_alloc &)
+            {
+                return arrow::Status::OutOfMemory("failed to allocate scratch memory");
+            }
+            added(size);
+            return arrow::Status::OK();
+        }
+        arrow::Status Reallocate(int64_t old_size, int64_t new_size, uint8_t **ptr) override
+        {
+            uint8_t *newBlock = nullptr;
+            auto status = Allocate(new_size, &newBlock);
+            if(!status.ok())
+                return status;
+
+            std::memcpy(newBlock, *ptr, std::min(old_size, new_size));
+            Free(*ptr, old_size);
+            *ptr = newBlock;
+            return arrow::Status::OK();
+        }
+        void Free(uint8_t *buffer, int64_t size) override
+        {
+            ScratchArena::releaseLocal(buffer, size);
+            allocated.fetch_sub(size);
+        }
+        int64_t bytes_allocated() const override
+        {
+            return allocated.load();
+        }
+        int64_t max_memory() const override
+        {
+            return peak.load();
+        }
+    };
+}
+
+arrow::MemoryPool *scratchMemoryPool()
+{
+    static ScratchMemoryPool pool;
+    return &pool;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Common.h"
+
+namespace arrow
+{
+    class MemoryPool;
+}
+
+// Thread-local cache of memory blocks for temporary buffers of kernels.
+//
+// Kernels tend to allocate and free big temporaries on each call. Getting fresh
+// memory from the system means page-faulting it again, so released blocks are kept
+// and given back on next acquire of the same size class.
+//
+// Sizes are rounded up to classes, there are four classes per each power of two
+// (so no more than 25% is wasted). Requests below MinCachedSize are not cached.
+// Blocks of at least HugePageSize are aligned to it and advised to be backed by
+// transparent huge pages (Linux only).
+//
+// The high watermark limits cached (unused) memory of all threads together, as each
+// pool worker keeps its own arena. When releasing a block would exceed it, the releasing
+// thread's cache is trimmed so that the total drops to half of the watermark, or as close
+// to that as its own cache allows; if the block still doesn't fit, it is freed instead of cached.
+//
+// Blocks are not bound to the thread that acquired them: they can be released
+// on any thread and will land in that thread's cache.
+class DFH_EXPORT ScratchArena
+{
+    std::vector<std::vector<void *>> freeBlocks; // [size class] => cached blocks
+    size_t cached = 0; // total size of blocks in freeBlocks
+
+public:
+    static constexpr size_t MinCachedSize = 64 * 1024;
+    static constexpr size_t HugePageSize = 2 * 1024 * 1024;
+    static constexpr size_t DefaultHighWatermark = 256 * 1024 * 1024; // for the whole process
+
+    ScratchArena() = default;
+    ScratchArena(const ScratchArena &) = delete;
+    ScratchArena &operator=(const ScratchArena &) = delete;
+    ~ScratchArena();
+
+    static ScratchArena &local(); // arena of the calling thread
+
+    // Use the calling thread's arena. Unlike local() these are safe to call also
+    // when the thread's arena was already destroyed (e.g. during the thread exit).
+    static void *acquireLocal(size_t size);
+    static void releaseLocal(void *block, size_t size);
+
+    void *acquire(size_t size);
+    void release(void *block, size_t size); // size must be the same as given to acquire
+    void trim(size_t targetCachedBytes); // frees cached blocks until no more than target bytes remain
+
+    size_t cachedBytes() const { return cached; }
+
+    static size_t highWatermark();
+    static void setHighWatermark(size_t bytes); // caches above a lowered watermark shrink on their next release
+    static size_t totalCachedBytes(); // of all threads
+};
+
+// Arrow memory pool backed by the thread-local scratch arenas.
+// Meant for intermediate buffers of kernels.
+DFH_EXPORT arrow::MemoryPool *scratchMemoryPool();
+
+// Standard-library allocator that borrows from the thread-local scratch arena.
+template<typename T>
+struct ScratchAllocator
+{
+    using value_type = T;
+
+    ScratchAllocator() noexcept = default;
+    template<typename U>
+    ScratchAllocator(const ScratchAllocator<U> &) noexcept {}
+
+    T *allocate(size_t n)
+    {
+        return static_cast<T *>(ScratchArena::acquireLocal(n * sizeof(T)));
+    }
+    void deallocate(T *ptr, size_t n) noexcept
+    {
+        ScratchArena::releaseLocal(ptr, n * sizeof(T));
+    }
+
+    template<typename U>
+    bool operator==(const ScratchAllocator<U> &) const noexcept { return true; }
+    template<typename U>
+    bool operator!=(const ScratchAllocator<U> &) const noexcept { return false; }
+};
+
+template<typename T>
+using ScratchVector = std::vector<T, ScratchAllocator<T>>;
@@ -0,0 +1,290 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <stdexcept>
+
+#include "Cancellation.h"
+#include "MemoryTracking.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+    thread_local const ThreadPool *workerPool = nullptr; // pool that owns the calling thread
+    thread_local size_t workerIndex = 0;
+    thread_local const ExecutionContext *activeContext = nullptr;
+
+    int resolveThreadCount(int threadCount)
+    {
+        if(threadCount > 0)
+            return threadCount;
+        return std::max(1, (int)std::thread::hardware_concurrency());
+    }
+
+    std::atomic<int> globalThreadCount{resolveThreadCount(0)};
+    std::atomic<int64_t> globalMorselSize{ExecutionContext::DefaultMorselSize};
+
+    std::mutex globalPoolMx;
+    std::shared_ptr<ThreadPool> globalPool; // created on first use
+}
+
+ThreadPool::ThreadPool(int workerCount)
+{
+    for(int i = 0; i < workerCount; i++)
+        queues.push_back(std::make_unique<WorkerQueue>());
+    for(int i = 0; i < workerCount; i++)
+        threads.emplace_back([this, i] { workerLoop(i); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::unique_lock<std::mutex> lock{ sleepMx };
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for(auto &thread : threads)
+        thread.join();
+}
+
+void ThreadPool::submit(Task task)
+{
+    if(queues.empty())
+    {
+        task();
+        return;
+    }
+
+    // Worker keeps tasks it spawns for itself, others are spread round-robin.
+    const auto queueIndex = workerPool == this
+        ? workerIndex
+        : nextQueue++ % queues.size();
+
+    {
+        auto &queue = *queues[queueIndex];
+        std::unique_lock<std::mutex> lock{ queue.mx };
+        queue.tasks.push_back(std::move(task));
+    }
+    {
+        std::unique_lock<std::mutex> lock{ sleepMx };
+        ++pendingCount;
+    }
+    wakeUp.notify_one();
+}
+
+bool ThreadPool::tryPop(size_t preferredQueue, Task &task)
+{
+    if(queues.empty())
+        return false;
+
+    {
+        auto &own = *queues[preferredQueue];
+        std::unique_lock<std::mutex> lock{ own.mx };
+        if(!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            --pendingCount;
+            return true;
+        }
+    }
+
+    for(size_t i = 1; i < queues.size(); i++)
+    {
+        auto &victim = *queues[(preferredQueue + i) % queues.size()];
+        std::unique_lock<std::mutex> lock{ victim.mx };
+        if(!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            --pendingCount;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool ThreadPool::tryRunPendingTask()
+{
+    Task task;
+    if(!tryPop(workerPool == this ? workerIndex : 0, task))
+        return false;
+
+    task();
+    return true;
+}
+
+void ThreadPool::workerLoop(size_t index)
+{
+    workerPool = this;
+    workerIndex = index;
+
+    while(true)
+    {
+        Task task;
+        if(tryPop(index, task))
+        {
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock{ sleepMx };
+        wakeUp.wait(lock, [&] { return stopping || pendingCount > 0; });
+        if(stopping && pendingCount == 0)
+            return;
+    }
+}
+
+std::shared_ptr<ThreadPool> ThreadPool::global()
+{
+    std::unique_lock<std::mutex> lock{ globalPoolMx };
+    if(!globalPool)
+        globalPool = std::make_shared<ThreadPool>(globalThreadCount - 1); // caller is the remaining thread
+    return globalPool;
+}
+
+ExecutionContext ExecutionContext::current()
+{
+    if(auto context = ExecutionContextScope::active())
+        return *context;
+    return global();
+}
+
+ExecutionContext ExecutionContext::global()
+{
+    ExecutionContext ret;
+    ret.threadCount = globalThreadCount;
+    ret.morselSize = globalMorselSize;
+    return ret;
+}
+
+void ExecutionContext::setGlobalThreadCount(int threadCount)
+{
+    if(threadCount < 0)
+        throw std::runtime_error("thread count must not be negative, got " + std::to_string(threadCount));
+
+    const auto resolved = resolveThreadCount(threadCount);
+    std::unique_lock<std::mutex> lock{ globalPoolMx };
+    if(resolved == globalThreadCount)
+        return;
+
+    globalThreadCount = resolved;
+    globalPool.reset(); // operations in progress keep the old pool until they finish
+}
+
+void ExecutionContext::setGlobalMorselSize(int64_t morselSize)
+{
+    if(morselSize <= 0)
+        throw std::runtime_error("morsel size must be positive, got " + std::to_string(morselSize));
+
+    globalMorselSize = morselSize;
+}
+
+ExecutionContextScope::ExecutionContextScope(ExecutionContext context) noexcept
+    : previous(activeContext)
+    , context(context)
+{
+    activeContext = &this->context;
+}
+
+ExecutionContextScope::~ExecutionContextScope()
+{
+    activeContext = previous;
+}
+
+const ExecutionContext *ExecutionContextScope::active() noexcept
+{
+    return activeContext;
+}
+
+void parallelFor(int64_t begin, int64_t end, int64_t morselSize, const std::function<void(int64_t, int64_t)> &f)
+{
+    if(end <= begin)
+        return;
+
+    morselSize = std::max<int64_t>(morselSize, 1);
+    const auto morselCount = (end - begin + morselSize - 1) / morselSize;
+    const auto context = ExecutionContext::current();
+    const auto pool = ThreadPool::global();
+    const auto helperCount = std::min<int64_t>({context.threadCount - 1, pool->workerCount(), morselCount - 1});
+    if(helperCount <= 0)
+    {
+        for(auto from = begin; from < end; from += morselSize)
+        {
+            checkCancellation();
+            f(from, std::min(end, from + morselSize));
+        }
+        return;
+    }
+
+    std::atomic<int64_t> nextMorsel{0};
+    std::mutex mx;
+    std::condition_variable helperFinished;
+    int64_t finishedHelpers = 0; // guarded by mx
+    std::exception_ptr error; // guarded by mx
+
+    const auto processMorsels = [&]
+    {
+        for(auto morsel = nextMorsel++; morsel < morselCount; morsel = nextMorsel++)
+        {
+            const auto from = begin + morsel * morselSize;
+            const auto to = std::min(end, from + morselSize);
+            try
+            {
+                checkCancellation();
+                f(from, to);
+            }
+            catch(...)
+            {
+                std::unique_lock<std::mutex> lock{ mx };
+                if(!error)
+                    error = std::current_exception();
+                nextMorsel = morselCount; // no point in starting remaining morsels
+            }
+        }
+    };
+
+    // helpers run with the caller's thread-local settings
+    const auto tag = MemoryTrackingScope::currentTag();
+    const auto token = CancellationScope::current();
+    for(int64_t i = 0; i < helperCount; i++)
+    {
+        pool->submit([&]
+        {
+            {
+                ExecutionContextScope contextScope{context};
+                MemoryTrackingScope trackingScope{tag};
+                CancellationScope cancellationScope{token};
+                processMorsels();
+            }
+
+            std::unique_lock<std::mutex> lock{ mx };
+            ++finishedHelpers;
+            helperFinished.notify_all();
+        });
+    }
+
+    processMorsels();
+
+    // Helpers might still be queued behind other work. Rather than block, help the pool.
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock{ mx };
+            if(finishedHelpers == helperCount)
+                break;
+        }
+
+        if(!pool->tryRunPendingTask())
+        {
+            std::unique_lock<std::mutex> lock{ mx };
+            helperFinished.wait_for(lock, 1ms, [&] { return finishedHelpers == helperCount; });
+        }
+    }
+
+    if(error)
+        std::rethrow_exception(error);
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Common.h"
+
+// Fixed-size pool of worker threads with work stealing.
+// Each worker has its own task queue: it takes its own tasks from the back
+// and when it runs out of them, steals from the front of other queues.
+//
+// Threads waiting for their tasks should help with executing queued work
+// (see tryRunPendingTask), so nested parallel calls can't deadlock the pool.
+class DFH_EXPORT ThreadPool
+{
+public:
+    using Task = std::function<void()>;
+
+    explicit ThreadPool(int workerCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    int workerCount() const { return (int)threads.size(); }
+
+    void submit(Task task);
+    bool tryRunPendingTask(); // executes a single queued task on the calling thread, returns false if none was queued
+
+    // Pool shared by the whole library. The returned pointer keeps the pool alive,
+    // even if the thread count is changed meanwhile.
+    static std::shared_ptr<ThreadPool> global();
+
+private:
+    struct WorkerQueue
+    {
+        std::mutex mx;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex sleepMx;
+    std::condition_variable wakeUp;
+    std::atomic<int64_t> pendingCount{0};
+    std::atomic<size_t> nextQueue{0};
+    bool stopping = false; // guarded by sleepMx
+
+    bool tryPop(size_t preferredQueue, Task &task);
+    void workerLoop(size_t index);
+};
+
+// Settings controlling how operations are parallelized.
+struct DFH_EXPORT ExecutionContext
+{
+    int threadCount = 1; // threads working on a single operation, including the calling one
+    int64_t morselSize = DefaultMorselSize; // count of rows processed by a single task
+
+    static constexpr int64_t DefaultMorselSize = 64 * 1024;
+
+    // Context for the calling thread: the one set by ExecutionContextScope if any, otherwise global.
+    static ExecutionContext current();
+    static ExecutionContext global();
+
+    // Thread count of 0 means using all hardware threads. Changing it restarts the global pool.
+    static void setGlobalThreadCount(int threadCount);
+    static void setGlobalMorselSize(int64_t morselSize);
+};
+
+// Overrides the execution context on the calling thread until the end of scope.
+class DFH_EXPORT ExecutionContextScope
+{
+    const ExecutionContext *previous{};
+    ExecutionContext context;
+
+public:
+    explicit ExecutionContextScope(ExecutionContext context) noexcept;
+    ~ExecutionContextScope();
+
+    ExecutionContextScope(const ExecutionContextScope &) = delete;
+    ExecutionContextScope &operator=(const ExecutionContextScope &) = delete;
+
+    static const ExecutionContext *active() noexcept;
+};
+
+// Calls f(from, to) for subranges covering [begin, end), each no longer than morselSize.
+// Subranges are processed on the global pool, according to the current execution context.
+// The calling thread takes part in processing. The first exception thrown by f is rethrown.
+// Cancellation is checked before each subrange.
+DFH_EXPORT void parallelFor(int64_t begin, int64_t end, int64_t morselSize, const std::function<void(int64_t, int64_t)> &f);
+
+inline void parallelFor(int64_t begin, int64_t end, const std::function<void(int64_t, int64_t)> &f)
+{
+    parallelFor(begin, end, ExecutionContext::current().morselSize, f);
+}
+
+// Calls f(index) for each index in [0, count) in parallel. Useful for independent per-column work.
+inline void parallelForEach(int64_t count, const std::function<void(int64_t)> &f)
+{
+    parallelFor(0, count, 1, [&] (int64_t from, int64_t to)
+    {
+        for(auto i = from; i < to; i++)
+            f(i);
+    });
+}
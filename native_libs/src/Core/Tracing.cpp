@@ -0,0 +1,185 @@
+#include "Tracing.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+std::atomic_bool Tracing::enabledFlag{false};
+
+namespace
+{
+    struct TraceEvent
+    {
+        const char *category;
+        const char *name;
+        int64_t startNs;
+        int64_t endNs;
+    };
+
+    // Written only by its thread. The lock is needed only to synchronize with dumping,
+    // so normally it is not contended.
+    struct ThreadTraceBuffer
+    {
+        std::mutex mx;
+        std::vector<TraceEvent> events; // ring buffer, allocated with the first event
+        size_t recordedCount = 0; // total count of recorded events, including overwritten ones
+        int threadIndex = 0;
+        bool retired = false; // thread has exited, events hold only its remaining spans (guarded by registryMx)
+    };
+
+    std::mutex registryMx;
+    std::vector<std::shared_ptr<ThreadTraceBuffer>> registry; // buffers outlive their threads, so their spans can still be dumped
+    int registeredThreadCount = 0;
+
+    // When the thread exits, the ring buffer is replaced with just the spans it holds.
+    void retire(const std::shared_ptr<ThreadTraceBuffer> &buffer)
+    {
+        std::unique_lock<std::mutex> lock{ registryMx };
+        std::unique_lock<std::mutex> bufferLock{ buffer->mx };
+        const auto count = std::min(buffer->recordedCount, Tracing::RingBufferCapacity);
+        if(count == 0)
+        {
+            registry.erase(std::remove(registry.begin(), registry.end(), buffer), registry.end());
+            return;
+        }
+
+        std::vector<TraceEvent> remaining;
+        remaining.reserve(count);
+        for(auto i = buffer->recordedCount - count; i < buffer->recordedCount; i++)
+            remaining.push_back(buffer->events[i % Tracing::RingBufferCapacity]);
+
+        buffer->events = std::move(remaining);
+        buffer->recordedCount = count;
+        buffer->retired = true;
+    }
+
+    struct LocalBuffer
+    {
+        std::shared_ptr<ThreadTraceBuffer> buffer;
+
+        ~LocalBuffer()
+        {
+            if(buffer)
+                retire(buffer);
+        }
+    };
+    thread_local LocalBuffer localBuffer;
+
+    ThreadTraceBuffer &threadBuffer()
+    {
+        if(!localBuffer.buffer)
+        {
+            auto buffer = std::make_shared<ThreadTraceBuffer>();
+            std::unique_lock<std::mutex> lock{ registryMx };
+            buffer->threadIndex = ++registeredThreadCount;
+            registry.push_back(buffer);
+            localBuffer.buffer = std::move(buffer);
+        }
+        return *localBuffer.buffer;
+    }
+
+    void writeEscaped(std::ostream &out, const char *text)
+    {
+        out << '"';
+        for(auto c = text; *c; ++c)
+        {
+            if(*c == '"' || *c == '\\')
+                out << '\\';
+            out << *c;
+        }
+        out << '"';
+    }
+}
+
+void Tracing::setEnabled(bool enabled) noexcept
+{
+    enabledFlag.store(enabled);
+}
+
+int64_t Tracing::now() noexcept
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void Tracing::record(const char *category, const char *name, int64_t startNs, int64_t endNs) noexcept
+{
+    try
+    {
+        auto &buffer = threadBuffer();
+        std::unique_lock<std::mutex> lock{ buffer.mx };
+        if(buffer.events.empty())
+            buffer.events.resize(RingBufferCapacity);
+
+        buffer.events[buffer.recordedCount++ % RingBufferCapacity] = TraceEvent{category, name, startNs, endNs};
+    }
+    catch(...)
+    {
+        // tracing must never break the traced code, span is dropped
+    }
+}
+
+void Tracing::clear()
+{
+    std::unique_lock<std::mutex> lock{ registryMx };
+    for(auto &buffer : registry)
+    {
+        std::unique_lock<std::mutex> bufferLock{ buffer->mx };
+        buffer->recordedCount = 0;
+    }
+
+    // buffers of exited threads won't get any more spans
+    registry.erase(std::remove_if(registry.begin(), registry.end(), [] (auto &buffer) { return buffer->retired; }), registry.end());
+}
+
+void Tracing::writeJson(std::ostream &out)
+{
+    std::unique_lock<std::mutex> lock{ registryMx };
+
+    // microseconds since clock epoch need more than default 6 digits
+    const auto previousPrecision = out.precision(15);
+    out << "{\"traceEvents\":[";
+    bool first = true;
+    auto separate = [&]
+    {
+        if(!first)
+            out << ",\n";
+        first = false;
+    };
+
+    for(auto &buffer : registry)
+    {
+        std::unique_lock<std::mutex> bufferLock{ buffer->mx };
+
+        separate();
+        out << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << buffer->threadIndex
+            << R"(,"args":{"name":"thread )" << buffer->threadIndex << R"("}})";
+
+        const auto count = std::min(buffer->recordedCount, RingBufferCapacity);
+        const auto oldest = buffer->recordedCount - count;
+        for(auto i = oldest; i < buffer->recordedCount; i++)
+        {
+            const auto &event = buffer->events[i % RingBufferCapacity];
+            separate();
+            out << "{\"name\":";
+            writeEscaped(out, event.name);
+            out << ",\"cat\":";
+            writeEscaped(out, event.category);
+            out << R"(,"ph":"X","pid":1,"tid":)" << buffer->threadIndex
+                << ",\"ts\":" << event.startNs / 1000.0
+                << ",\"dur\":" << (event.endNs - event.startNs) / 1000.0 << "}";
+        }
+    }
+
+    out << "],\"displayTimeUnit\":\"ms\"}";
+    out.precision(previousPrecision);
+}
+
+std::string Tracing::toJson()
+{
+    std::ostringstream out;
+    writeJson(out);
+    return out.str();
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "Common.h"
+
+// Lightweight tracing of operation phases.
+//
+// Spans are always compiled in, but recorded only when tracing is enabled at runtime.
+// Each thread writes into its own ring buffer (when full, the oldest spans are overwritten).
+// When a thread exits, its ring buffer is freed and only the spans it holds are kept until clear().
+// Collected spans can be dumped as Chrome trace-event JSON, that can be viewed
+// in chrome://tracing or in Perfetto UI.
+//
+// Span names and categories are not copied: they must be string literals
+// (or otherwise outlive the trace).
+class DFH_EXPORT Tracing
+{
+public:
+    static constexpr size_t RingBufferCapacity = 64 * 1024; // spans per thread
+
+    // C API calls shorter than this (e.g. per-element accessors) are not recorded,
+    // as they would quickly overwrite spans of the actual operations.
+    static constexpr int64_t ApiCallMinDurationNs = 20'000;
+
+    static bool enabled() noexcept { return enabledFlag.load(std::memory_order_relaxed); }
+    static void setEnabled(bool enabled) noexcept;
+
+    static int64_t now() noexcept; // nanoseconds since an arbitrary epoch
+    static void record(const char *category, const char *name, int64_t startNs, int64_t endNs) noexcept;
+
+    static void clear(); // drops all collected spans
+    static void writeJson(std::ostream &out);
+    static std::string toJson();
+
+private:
+    static std::atomic_bool enabledFlag;
+};
+
+// Records the span between its construction and destruction.
+class TraceSpan
+{
+    const char *category;
+    const char *name;
+    int64_t minDurationNs; // shorter spans are not recorded
+    int64_t start = -1; // -1 if tracing was disabled when span started
+
+public:
+    TraceSpan(const char *category, const char *name, int64_t minDurationNs = 0) noexcept
+        : category(category), name(name), minDurationNs(minDurationNs)
+    {
+        if(Tracing::enabled())
+            start = Tracing::now();
+    }
+    ~TraceSpan()
+    {
+        if(start < 0)
+            return;
+
+        const auto end = Tracing::now();
+        if(end - start >= minDurationNs)
+            Tracing::record(category, name, start, end);
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+// Traces the rest of the enclosing scope, e.g. TRACE_SPAN("csv", "parse");
+#define TRACE_SPAN(category, name) TraceSpan TRACE_CONCAT(traceSpan, __LINE__){category, name}
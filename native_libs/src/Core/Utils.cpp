@@ -38,6 +38,10 @@ std::string formatColumnElem(const T &elem)
 {
     return std::to_string(elem);
 }
+std::string formatColumnElem(const bool &elem)
+{
+    return elem ? "true"s : "false"s;
+}
 std::string formatColumnElem(const std::string_view &elem)
 {
     return '"' + std::string(elem) + '"';
@@ -55,7 +59,7 @@ std::string formatColumnElem(const ListElemView &elem)
             out << formatColumnElem(value);
         }
 
-        for(int i = 1; i < elem.length; i++)
+        for(int64_t i = 1; i < elem.length; i++)
         {
             out << ", ";
             auto value = tryArrayValueAt<id.value>(*elem.array, elem.offset + i);
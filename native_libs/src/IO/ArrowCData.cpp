@@ -0,0 +1,451 @@
+#include "ArrowCData.h"
+
+#include <cerrno>
+#include <string>
+#include <vector>
+
+#include <arrow/array.h>
+#include <arrow/buffer.h>
+#include <arrow/record_batch.h>
+#include <arrow/table.h>
+#include <arrow/type.h>
+
+#include "Core/ArrowUtilities.h"
+
+namespace
+{
+    std::string formatOf(const arrow::DataType &type)
+    {
+        switch(type.id())
+        {
+        case arrow::Type::BOOL:   return "b";
+        case arrow::Type::INT8:   return "c";
+        case arrow::Type::UINT8:  return "C";
+        case arrow::Type::INT16:  return "s";
+        case arrow::Type::UINT16: return "S";
+        case arrow::Type::INT32:  return "i";
+        case arrow::Type::UINT32: return "I";
+        case arrow::Type::INT64:  return "l";
+        case arrow::Type::UINT64: return "L";
+        case arrow::Type::FLOAT:  return "f";
+        case arrow::Type::DOUBLE: return "g";
+        case arrow::Type::STRING: return "u";
+        case arrow::Type::STRUCT: return "+s";
+        case arrow::Type::TIMESTAMP:
+        {
+            const auto &timestampType = static_cast<const arrow::TimestampType &>(type);
+            const char *units[] = { "tss:", "tsm:", "tsu:", "tsn:" };
+            return units[(int)timestampType.unit()] + timestampType.timezone();
+        }
+        default:
+            THROW("C Data Interface: type {} is not supported", type.ToString());
+        }
+    }
+
+    std::shared_ptr<arrow::DataType> typeFromFormat(std::string_view format, std::vector<std::shared_ptr<arrow::Field>> children)
+    {
+        if(format.size() == 1)
+        {
+            switch(format[0])
+            {
+            case 'b': return arrow::boolean();
+            case 'c': return arrow::int8();
+            case 'C': return arrow::uint8();
+            case 's': return arrow::int16();
+            case 'S': return arrow::uint16();
+            case 'i': return arrow::int32();
+            case 'I': return arrow::uint32();
+            case 'l': return arrow::int64();
+            case 'L': return arrow::uint64();
+            case 'f': return arrow::float32();
+            case 'g': return arrow::float64();
+            case 'u': return arrow::utf8();
+            }
+        }
+        if(format == "+s")
+            return arrow::struct_(children);
+        // other units would need converting the values, the library works with nanoseconds only
+        if(format.substr(0, 4) == "tsn:")
+            return arrow::timestamp(arrow::TimeUnit::NANO, std::string(format.substr(4)));
+
+        THROW("C Data Interface: format '{}' is not supported", format);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    // Export
+
+    struct ExportedSchema
+    {
+        std::string format;
+        std::string name;
+        std::vector<ArrowSchema> children;
+        std::vector<ArrowSchema *> childPointers;
+    };
+
+    void releaseExportedSchema(ArrowSchema *schema)
+    {
+        auto exported = static_cast<ExportedSchema *>(schema->private_data);
+        for(auto &child : exported->children)
+            if(child.release)
+                child.release(&child);
+        delete exported;
+        schema->release = nullptr;
+    }
+
+    void exportSchema(std::string name, const arrow::DataType &type, bool nullable, ArrowSchema *out)
+    {
+        auto exported = std::make_unique<ExportedSchema>();
+        exported->format = formatOf(type);
+        exported->name = std::move(name);
+        exported->children.resize(type.num_children());
+        for(int i = 0; i < type.num_children(); i++)
+        {
+            exportField(*type.child(i), &exported->children[i]);
+            exported->childPointers.push_back(&exported->children[i]);
+        }
+
+        out->format = exported->format.c_str();
+        out->name = exported->name.c_str();
+        out->metadata = nullptr;
+        out->flags = nullable ? ARROW_FLAG_NULLABLE : 0;
+        out->n_children = type.num_children();
+        out->children = exported->childPointers.data();
+        out->dictionary = nullptr;
+        out->release = releaseExportedSchema;
+        out->private_data = exported.release();
+    }
+
+    struct ExportedArray
+    {
+        std::shared_ptr<arrow::ArrayData> data;
+        std::vector<const void *> buffers;
+        std::vector<ArrowArray> children;
+        std::vector<ArrowArray *> childPointers;
+    };
+
+    void releaseExportedArray(ArrowArray *array)
+    {
+        auto exported = static_cast<ExportedArray *>(array->private_data);
+        for(auto &child : exported->children)
+            if(child.release)
+                child.release(&child);
+        delete exported;
+        array->release = nullptr;
+    }
+
+    void exportArrayData(std::shared_ptr<arrow::ArrayData> data, ArrowArray *out)
+    {
+        formatOf(*data->type); // validates that type is supported
+
+        // Arrow's in-memory layout is the one of C Data Interface, buffers are passed as they are
+        auto exported = std::make_unique<ExportedArray>();
+        for(auto &buffer : data->buffers)
+            exported->buffers.push_back(buffer ? buffer->data() : nullptr);
+        exported->children.resize(data->child_data.size());
+        for(size_t i = 0; i < data->child_data.size(); i++)
+        {
+            exportArrayData(data->child_data[i], &exported->children[i]);
+            exported->childPointers.push_back(&exported->children[i]);
+        }
+
+        out->length = data->length;
+        out->null_count = data->null_count;
+        out->offset = data->offset;
+        out->n_buffers = exported->buffers.size();
+        out->n_children = exported->children.size();
+        out->buffers = exported->buffers.data();
+        out->children = exported->childPointers.data();
+        out->dictionary = nullptr;
+        exported->data = std::move(data);
+        out->release = releaseExportedArray;
+        out->private_data = exported.release();
+    }
+
+    // Stream over arrays prepared up front. Exceptions must not cross the C boundary,
+    // they are turned into error codes with message kept for get_last_error.
+    struct ExportedStream
+    {
+        std::shared_ptr<arrow::Field> field;
+        std::vector<std::shared_ptr<arrow::Array>> arrays;
+        size_t nextIndex = 0;
+        std::string lastError;
+    };
+
+    template<typename F>
+    int translateToErrorCode(ArrowArrayStream *stream, F &&f)
+    {
+        auto exported = static_cast<ExportedStream *>(stream->private_data);
+        try
+        {
+            f(*exported);
+            return 0;
+        }
+        catch(std::exception &e)
+        {
+            exported->lastError = e.what();
+            return EINVAL;
+        }
+    }
+
+    void exportStream(std::shared_ptr<arrow::Field> field, std::vector<std::shared_ptr<arrow::Array>> arrays, ArrowArrayStream *out)
+    {
+        formatOf(*field->type());
+
+        auto exported = std::make_unique<ExportedStream>();
+        exported->field = std::move(field);
+        exported->arrays = std::move(arrays);
+
+        out->get_schema = [] (ArrowArrayStream *stream, ArrowSchema *result)
+        {
+            return translateToErrorCode(stream, [&] (ExportedStream &exported)
+            {
+                exportField(*exported.field, result);
+            });
+        };
+        out->get_next = [] (ArrowArrayStream *stream, ArrowArray *result)
+        {
+            return translateToErrorCode(stream, [&] (ExportedStream &exported)
+            {
+                if(exported.nextIndex < exported.arrays.size())
+                    exportArray(exported.arrays[exported.nextIndex++], result);
+                else
+                    result->release = nullptr; // marks the end of stream
+            });
+        };
+        out->get_last_error = [] (ArrowArrayStream *stream) -> const char *
+        {
+            auto exported = static_cast<ExportedStream *>(stream->private_data);
+            return exported->lastError.empty() ? nullptr : exported->lastError.c_str();
+        };
+        out->release = [] (ArrowArrayStream *stream)
+        {
+            delete static_cast<ExportedStream *>(stream->private_data);
+            stream->release = nullptr;
+        };
+        out->private_data = exported.release();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    // Import
+
+    std::shared_ptr<arrow::Field> fieldFromSchema(const ArrowSchema &schema)
+    {
+        if(schema.dictionary)
+            THROW("C Data Interface: dictionary types are not supported");
+
+        // children are released together with the parent
+        std::vector<std::shared_ptr<arrow::Field>> children;
+        for(int64_t i = 0; i < schema.n_children; i++)
+            children.push_back(fieldFromSchema(*schema.children[i]));
+
+        const auto type = typeFromFormat(schema.format, std::move(children));
+        return arrow::field(schema.name ? schema.name : "", type, (schema.flags & ARROW_FLAG_NULLABLE) != 0);
+    }
+
+    // Owns the imported structure, releasing it when the last buffer using it is destroyed.
+    struct ImportedArray
+    {
+        ArrowArray array;
+
+        explicit ImportedArray(ArrowArray *source)
+            : array(*source)
+        {
+            source->release = nullptr; // moved, as the specification allows
+        }
+        ~ImportedArray()
+        {
+            if(array.release)
+                array.release(&array);
+        }
+    };
+
+    class ImportedBuffer : public arrow::Buffer
+    {
+        std::shared_ptr<ImportedArray> owner;
+
+    public:
+        ImportedBuffer(const void *data, int64_t size, std::shared_ptr<ImportedArray> owner)
+            : arrow::Buffer(static_cast<const uint8_t *>(data), size)
+            , owner(std::move(owner))
+        {}
+    };
+
+    std::shared_ptr<arrow::ArrayData> importArrayData(const ArrowArray &array, const std::shared_ptr<arrow::DataType> &type, const std::shared_ptr<ImportedArray> &owner)
+    {
+        const auto id = type->id();
+        const int64_t expectedBufferCount = id == arrow::Type::STRUCT ? 1 : id == arrow::Type::STRING ? 3 : 2;
+        if(array.n_buffers != expectedBufferCount)
+            THROW("C Data Interface: array of type {} should have {} buffers, has {}", type->ToString(), expectedBufferCount, array.n_buffers);
+        if(array.n_children != type->num_children())
+            THROW("C Data Interface: array of type {} should have {} children, has {}", type->ToString(), type->num_children(), array.n_children);
+        if(array.dictionary)
+            THROW("C Data Interface: dictionary arrays are not supported");
+
+        const auto endIndex = array.offset + array.length;
+        const auto wrap = [&] (int64_t index, int64_t size) -> std::shared_ptr<arrow::Buffer>
+        {
+            const auto data = array.buffers[index];
+            if(!data)
+                return size ? nullptr : std::make_shared<arrow::Buffer>(nullptr, 0);
+            return std::make_shared<ImportedBuffer>(data, size, owner);
+        };
+
+        // validity buffer is optional if there are no nulls
+        std::vector<std::shared_ptr<arrow::Buffer>> buffers;
+        buffers.push_back(array.null_count == 0 || !array.buffers[0] ? nullptr : wrap(0, arrow::BitUtil::BytesForBits(endIndex)));
+
+        if(id == arrow::Type::STRING)
+        {
+            const auto offsets = static_cast<const int32_t *>(array.buffers[1]);
+            buffers.push_back(wrap(1, (endIndex + 1) * sizeof(int32_t)));
+            buffers.push_back(wrap(2, offsets ? offsets[endIndex] : 0));
+        }
+        else if(id == arrow::Type::BOOL)
+        {
+            buffers.push_back(wrap(1, arrow::BitUtil::BytesForBits(endIndex)));
+        }
+        else if(id != arrow::Type::STRUCT)
+        {
+            const auto &fixedWidthType = static_cast<const arrow::FixedWidthType &>(*type);
+            buffers.push_back(wrap(1, endIndex * fixedWidthType.bit_width() / 8));
+        }
+
+        if(std::any_of(buffers.begin() + 1, buffers.end(), [] (auto &buffer) { return !buffer; }))
+            THROW("C Data Interface: array of type {} is missing its data buffer", type->ToString());
+
+        std::vector<std::shared_ptr<arrow::ArrayData>> children;
+        for(int i = 0; i < type->num_children(); i++)
+            children.push_back(importArrayData(*array.children[i], type->child(i)->type(), owner));
+
+        return arrow::ArrayData::Make(type, array.length, std::move(buffers), std::move(children), array.null_count, array.offset);
+    }
+
+    // Stream is released when leaving the scope.
+    struct ImportedStream
+    {
+        ArrowArrayStream *stream;
+
+        ~ImportedStream()
+        {
+            if(stream->release)
+                stream->release(stream);
+        }
+
+        void check(int errorCode)
+        {
+            if(errorCode)
+            {
+                const auto message = stream->get_last_error(stream);
+                THROW("C Data Interface: stream failed with error code {}: {}", errorCode, message ? message : "unknown error");
+            }
+        }
+
+        std::shared_ptr<arrow::Field> field()
+        {
+            ArrowSchema schema;
+            check(stream->get_schema(stream, &schema));
+            return importField(&schema);
+        }
+
+        // Returns nullptr at the end of stream.
+        std::shared_ptr<arrow::Array> next(const std::shared_ptr<arrow::DataType> &type)
+        {
+            ArrowArray array;
+            check(stream->get_next(stream, &array));
+            if(!array.release)
+                return nullptr;
+            return importArray(&array, type);
+        }
+    };
+}
+
+void exportField(const arrow::Field &field, ArrowSchema *out)
+{
+    exportSchema(field.name(), *field.type(), field.nullable(), out);
+}
+
+void exportArray(std::shared_ptr<arrow::Array> array, ArrowArray *out)
+{
+    exportArrayData(array->data(), out);
+}
+
+void exportColumn(std::shared_ptr<arrow::Column> column, ArrowArrayStream *out)
+{
+    exportStream(column->field(), column->data()->chunks(), out);
+}
+
+void exportTable(std::shared_ptr<arrow::Table> table, ArrowArrayStream *out)
+{
+    // columns may be chunked differently, batches are slices where all columns are contiguous
+    const auto type = arrow::struct_(table->schema()->fields());
+    std::vector<std::shared_ptr<arrow::Array>> batches;
+    arrow::TableBatchReader reader{*table};
+    std::shared_ptr<arrow::RecordBatch> batch;
+    for(checkStatus(reader.ReadNext(&batch)); batch; checkStatus(reader.ReadNext(&batch)))
+    {
+        std::vector<std::shared_ptr<arrow::Array>> columns;
+        for(int i = 0; i < batch->num_columns(); i++)
+            columns.push_back(batch->column(i));
+        batches.push_back(std::make_shared<arrow::StructArray>(type, batch->num_rows(), columns));
+    }
+
+    exportStream(arrow::field("", type, false), std::move(batches), out);
+}
+
+std::shared_ptr<arrow::Field> importField(ArrowSchema *schema)
+{
+    if(!schema->release)
+        THROW("C Data Interface: schema was already released");
+
+    // schema is only read, so it can be released right away
+    struct Releaser
+    {
+        ArrowSchema *schema;
+        ~Releaser() { schema->release(schema); }
+    } releaser{schema};
+
+    return fieldFromSchema(*schema);
+}
+
+std::shared_ptr<arrow::Array> importArray(ArrowArray *array, std::shared_ptr<arrow::DataType> type)
+{
+    if(!array->release)
+        THROW("C Data Interface: array was already released");
+
+    const auto owner = std::make_shared<ImportedArray>(array);
+    return arrow::MakeArray(importArrayData(owner->array, type, owner));
+}
+
+std::shared_ptr<arrow::Column> importColumn(ArrowArrayStream *stream)
+{
+    ImportedStream imported{stream};
+    const auto field = imported.field();
+
+    std::vector<std::shared_ptr<arrow::Array>> chunks;
+    while(auto chunk = imported.next(field->type()))
+        chunks.push_back(chunk);
+
+    return std::make_shared<arrow::Column>(field, std::make_shared<arrow::ChunkedArray>(chunks, field->type()));
+}
+
+std::shared_ptr<arrow::Table> importTable(ArrowArrayStream *stream)
+{
+    ImportedStream imported{stream};
+    const auto field = imported.field();
+    if(field->type()->id() != arrow::Type::STRUCT)
+        THROW("C Data Interface: table must be streamed as struct arrays, got {}", field->type()->ToString());
+
+    const auto &fields = field->type()->children();
+    std::vector<std::vector<std::shared_ptr<arrow::Array>>> chunks(fields.size());
+    while(auto batch = imported.next(field->type()))
+    {
+        const auto &structArray = static_cast<const arrow::StructArray &>(*batch);
+        for(size_t i = 0; i < fields.size(); i++)
+            chunks[i].push_back(structArray.field((int)i));
+    }
+
+    std::vector<std::shared_ptr<arrow::Column>> columns;
+    for(size_t i = 0; i < fields.size(); i++)
+        columns.push_back(std::make_shared<arrow::Column>(fields[i], std::make_shared<arrow::ChunkedArray>(chunks[i], fields[i]->type())));
+    return tableFromColumns(columns, arrow::schema(fields));
+}
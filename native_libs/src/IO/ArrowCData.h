@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "Core/Common.h"
+
+namespace arrow
+{
+    class Array;
+    class Column;
+    class DataType;
+    class Field;
+    class Table;
+}
+
+// Structures below are defined by the Arrow C Data Interface and C Stream Interface
+// specifications: https://arrow.apache.org/docs/format/CDataInterface.html
+// Their layout is the ABI shared with other Arrow implementations and must not change.
+// Macro guards are the ones suggested by the specification, so that the definitions
+// coexist with copies from other libraries.
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+extern "C"
+{
+    struct ArrowSchema
+    {
+        const char *format;
+        const char *name;
+        const char *metadata;
+        int64_t flags;
+        int64_t n_children;
+        struct ArrowSchema **children;
+        struct ArrowSchema *dictionary;
+
+        void (*release)(struct ArrowSchema *);
+        void *private_data;
+    };
+
+    struct ArrowArray
+    {
+        int64_t length;
+        int64_t null_count;
+        int64_t offset;
+        int64_t n_buffers;
+        int64_t n_children;
+        const void **buffers;
+        struct ArrowArray **children;
+        struct ArrowArray *dictionary;
+
+        void (*release)(struct ArrowArray *);
+        void *private_data;
+    };
+}
+
+#endif // ARROW_C_DATA_INTERFACE
+
+#ifndef ARROW_C_STREAM_INTERFACE
+#define ARROW_C_STREAM_INTERFACE
+
+extern "C"
+{
+    struct ArrowArrayStream
+    {
+        int (*get_schema)(struct ArrowArrayStream *, struct ArrowSchema *out);
+        int (*get_next)(struct ArrowArrayStream *, struct ArrowArray *out);
+        const char *(*get_last_error)(struct ArrowArrayStream *);
+
+        void (*release)(struct ArrowArrayStream *);
+        void *private_data;
+    };
+}
+
+#endif // ARROW_C_STREAM_INTERFACE
+
+// Export fills the given (caller-allocated) structure. Buffers are shared, not copied:
+// the exported structure keeps the data alive until consumer calls its release callback.
+//
+// Import takes over the given structure (it is marked as released afterwards) and wraps
+// its buffers without copying. The producer's release callback is called once the last
+// array using them is gone.
+//
+// Supported types are the ones supported by the library: integers, floating point,
+// boolean, UTF-8 string and timestamp; and struct for tables.
+
+DFH_EXPORT void exportField(const arrow::Field &field, ArrowSchema *out);
+DFH_EXPORT void exportArray(std::shared_ptr<arrow::Array> array, ArrowArray *out);
+DFH_EXPORT void exportColumn(std::shared_ptr<arrow::Column> column, ArrowArrayStream *out); // stream of column chunks
+DFH_EXPORT void exportTable(std::shared_ptr<arrow::Table> table, ArrowArrayStream *out); // stream of struct arrays, one per batch of aligned chunks
+
+DFH_EXPORT std::shared_ptr<arrow::Field> importField(ArrowSchema *schema);
+DFH_EXPORT std::shared_ptr<arrow::Array> importArray(ArrowArray *array, std::shared_ptr<arrow::DataType> type);
+DFH_EXPORT std::shared_ptr<arrow::Column> importColumn(ArrowArrayStream *stream);
+DFH_EXPORT std::shared_ptr<arrow::Table> importTable(ArrowArrayStream *stream); // stream of struct arrays, each becomes a chunk
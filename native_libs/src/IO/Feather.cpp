@@ -14,6 +14,7 @@ std::string FormatFeather::fileSignature() const
 
 std::shared_ptr<arrow::Table> FormatFeather::read(std::string_view filePath) const
 {
+    TRACE_SPAN("feather", "read");
     std::shared_ptr<arrow::io::ReadableFile> out;
     checkStatus(arrow::io::ReadableFile::Open((std::string)filePath, &out));
 
@@ -39,6 +40,7 @@ std::shared_ptr<arrow::Table> FormatFeather::read(std::string_view filePath) con
 
 void FormatFeather::write(std::string_view filePath, const arrow::Table &table) const
 {
+    TRACE_SPAN("feather", "write");
     std::shared_ptr<arrow::io::FileOutputStream> out;
     checkStatus(arrow::io::FileOutputStream::Open((std::string)filePath, &out));
 
@@ -16,6 +16,8 @@
 
 #include <boost/algorithm/string/predicate.hpp>
 
+#include "Core/Tracing.h"
+
 namespace
 {
 auto supportedFormatHandlers()
@@ -145,6 +147,7 @@ std::ifstream openFileToRead(std::string_view filepath)
 
 std::string getFileContents(std::string_view filepath)
 {
+    TRACE_SPAN("io", "read file");
     try
     {
         auto input = openFileToRead(filepath);
@@ -61,14 +61,20 @@ inline constexpr auto defaultValue()
     {
         return "";
     }
-    else if constexpr(type == arrow::Type::INT64 || type == arrow::Type::TIMESTAMP)
+    else if constexpr(type == arrow::Type::INT64 || type == arrow::Type::TIMESTAMP
+        || type == arrow::Type::INT8 || type == arrow::Type::INT16 || type == arrow::Type::INT32
+        || type == arrow::Type::UINT8 || type == arrow::Type::UINT16 || type == arrow::Type::UINT32 || type == arrow::Type::UINT64)
     {
         return std::int64_t(0);
     }
-    else if constexpr(type == arrow::Type::DOUBLE)
+    else if constexpr(type == arrow::Type::DOUBLE || type == arrow::Type::FLOAT)
     {
         return 0.0;
     }
+    else if constexpr(type == arrow::Type::BOOL)
+    {
+        return false;
+    }
     else
         throw std::runtime_error(__FUNCTION__ + std::string(" : type not supported ") + std::to_string(type));
 }
@@ -73,6 +73,12 @@ namespace
                     Timestamp t{(sys_days)day + timeOfDay};
                     checkStatus(builder->Append(t.toStorage()));
                 }
+                else if constexpr(type == arrow::Type::BOOL)
+                    checkStatus(builder->Append(field.value<bool>()));
+                else if constexpr(std::is_integral_v<typename TypeDescription<type>::ValueType>)
+                    checkStatus(builder->Append(static_cast<typename TypeDescription<type>::ValueType>(field.value<long long int>())));
+                else if constexpr(std::is_floating_point_v<typename TypeDescription<type>::ValueType>)
+                    checkStatus(builder->Append(static_cast<typename TypeDescription<type>::ValueType>(field.value<double>())));
                 else
                     throw std::runtime_error("wrong type");
             }
@@ -183,8 +189,13 @@ namespace
                 auto cell = sheet.cell(column + 1, row + 1);
                 // NOTE: workaround for GCC: otherwise call to xlnt::cell::value would be ambiguous
                 // as int64_t is long int and there is no such overload (just ints and long long ints)
-                if constexpr(std::is_same_v<int64_t, FieldType>)
+                // Narrow numeric types are written through the same overloads as their wide counterparts.
+                if constexpr(std::is_same_v<bool, FieldType>)
+                    cell.value(field);
+                else if constexpr(std::is_integral_v<FieldType>)
                     cell.value((long long)field);
+                else if constexpr(std::is_floating_point_v<FieldType>)
+                    cell.value((double)field);
                 else if constexpr(std::is_same_v<std::string_view, FieldType>)
                     cell.value(std::string(field));
                 else if constexpr(std::is_same_v<Timestamp, FieldType>)
@@ -234,6 +245,7 @@ std::string FormatXLSX::fileSignature() const
 
 std::shared_ptr<arrow::Table> FormatXLSX::read(std::string_view filePath, const XlsxReadOptions &options) const
 {
+    TRACE_SPAN("xlsx", "read");
     try
     {
         auto input = openFileToRead(filePath);
@@ -247,6 +259,7 @@ std::shared_ptr<arrow::Table> FormatXLSX::read(std::string_view filePath, const
 
 void FormatXLSX::write(std::string_view filePath, const arrow::Table &table, const XlsxWriteOptions &options) const
 {
+    TRACE_SPAN("xlsx", "write");
     auto out = openFileToWrite(filePath);
     return writeXlsx(out, table, options.headerPolicy);
 }
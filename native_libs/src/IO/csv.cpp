@@ -27,10 +27,23 @@ using namespace std::literals;
 template<arrow::Type::type id> struct always_false2 : std::false_type {};
 template<arrow::Type::type id> constexpr bool always_false2_v = always_false2<id>::value;
 
+// Accepts the spellings commonly produced by spreadsheets and pandas.
+// Note that 0/1 are not recognized, such columns are deduced as integers.
+std::optional<bool> parseBool(std::string_view text)
+{
+    if(text == "true" || text == "True" || text == "TRUE")
+        return true;
+    if(text == "false" || text == "False" || text == "FALSE")
+        return false;
+    return std::nullopt;
+}
+
 arrow::Type::type deduceType(std::string_view text)
 {
     if(text.empty())
         return arrow::Type::NA;
+    if(parseBool(text))
+        return arrow::Type::BOOL;
     if(Parser::as<Timestamp>(text))
         return arrow::Type::TIMESTAMP;
     if(Parser::as<int64_t>(text))
@@ -42,6 +55,7 @@ arrow::Type::type deduceType(std::string_view text)
 
 ParsedCsv parseCsvData(std::string data, char fieldSeparator /*= ','*/, char recordSeparator /*= '\n'*/, char quote /*= '"'*/)
 {
+    TRACE_SPAN("csv", "parse");
     // we are going to return string_views inside buffer
     // and due to SSO that disallows us from moving std::string -- it needs to be single object
     auto bufferPtr = std::make_unique<std::string>(std::move(data));
@@ -65,6 +79,7 @@ template<arrow::Type::type id>
 struct ColumnBuilder
 {
     using ArrowType = typename TypeDescription<id>::ArrowType;
+    using T = typename TypeDescription<id>::ValueType;
 
     MissingField missingField;
     std::shared_ptr<BuilderFor<id>> builder;
@@ -128,6 +143,42 @@ struct ColumnBuilder
                         addMissing();
                     }
                 }
+                else if constexpr(id == arrow::Type::BOOL)
+                {
+                    if(auto v = parseBool(field))
+                    {
+                        checkStatus(builder->Append(*v));
+                    }
+                    else
+                    {
+                        addMissing();
+                    }
+                }
+                else if constexpr(std::is_integral_v<T>)
+                {
+                    // narrow integers: values out of the type's range are treated as missing
+                    const auto v = Parser::as<int64_t>(field);
+                    if(v && *v >= static_cast<int64_t>(std::numeric_limits<T>::min())
+                        && (*v < 0 || static_cast<uint64_t>(*v) <= std::numeric_limits<T>::max()))
+                    {
+                        checkStatus(builder->Append(static_cast<T>(*v)));
+                    }
+                    else
+                    {
+                        addMissing();
+                    }
+                }
+                else if constexpr(std::is_floating_point_v<T>)
+                {
+                    if(auto v = Parser::as<double>(field))
+                    {
+                        checkStatus(builder->Append(static_cast<T>(*v)));
+                    }
+                    else
+                    {
+                        addMissing();
+                    }
+                }
                 else
                     static_assert(always_false2_v<id>, "wrong type");
             }
@@ -167,6 +218,13 @@ ColumnType deduceType(const ParsedCsv &csv, size_t columnIndex, size_t startRow,
 
     auto typePtr = [&] () -> TypePtr
     {
+        if(encounteredTypes.count(arrow::Type::BOOL))
+        {
+            // string if there are booleans and types other than booleans (excluding nulls)
+            if(encounteredTypes.size() > 1 + encounteredTypes.count(arrow::Type::NA))
+                return arrow::TypeTraits<arrow::StringType>::type_singleton();
+            return arrow::TypeTraits<arrow::BooleanType>::type_singleton();
+        }
         if(encounteredTypes.count(arrow::Type::TIMESTAMP))
         {
             // string if there are timestamps and types other than timestamps (excluding nulls)
@@ -187,7 +245,7 @@ ColumnType deduceType(const ParsedCsv &csv, size_t columnIndex, size_t startRow,
     return ColumnType{typePtr, encounteredTypes.count(arrow::Type::NA) > 0, true};
 }
 
-std::shared_ptr<arrow::Table> csvToArrowTable(const ParsedCsv &csv, HeaderPolicy header, std::vector<ColumnType> columnTypes, int typeDeductionDepth)
+std::shared_ptr<arrow::Table> csvToArrowTable(const ParsedCsv &csv, HeaderPolicy header, std::vector<ColumnType> columnTypes, int typeDeductionDepth, bool narrowDeducedTypes)
 {
     // empty table
     if(csv.recordCount == 0 || csv.fieldCount == 0)
@@ -200,22 +258,30 @@ std::shared_ptr<arrow::Table> csvToArrowTable(const ParsedCsv &csv, HeaderPolicy
     arrays.reserve(csv.fieldCount);
 
     const bool takeFirstRowAsNames = holds_alternative<TakeFirstRowAsHeaders>(header);
-    const int startRow = takeFirstRowAsNames ? 1 : 0;
+    const int64_t startRow = takeFirstRowAsNames ? 1 : 0;
 
     // Attempt to deduce all non-specified types
-    for(size_t i = columnTypes.size(); i < csv.fieldCount; i++)
+    const auto specifiedTypeCount = columnTypes.size();
     {
-        columnTypes.push_back(deduceType(csv, i, startRow, typeDeductionDepth));
+        TRACE_SPAN("csv", "deduce types");
+        for(size_t i = columnTypes.size(); i < csv.fieldCount; i++)
+        {
+            columnTypes.push_back(deduceType(csv, i, startRow, typeDeductionDepth));
+        }
     }
 
     for(int column = 0; column < csv.fieldCount; column++)
     {
+        checkCancellation();
+        reportProgress((double)column / csv.fieldCount, "building columns");
+        TRACE_SPAN("csv", "build column");
+
         const auto typeInfo = columnTypes.at(column);
         const auto missingFieldsPolicy = (typeInfo.deduced || typeInfo.nullable) ? MissingField::AsNull : MissingField::AsZeroValue;
         auto processColumn = [&] (auto &&builder)
         {
             builder.reserve(csv.recordCount);
-            for(int row = startRow; row < csv.recordCount; row++)
+            for(int64_t row = startRow; row < (int64_t)csv.recordCount; row++)
             {
                 const auto &record = csv.records[row];
                 if(column < record.size())
@@ -228,7 +294,15 @@ std::shared_ptr<arrow::Table> csvToArrowTable(const ParsedCsv &csv, HeaderPolicy
                     builder.addMissing();
                 }
             }
-            arrays.push_back(finish(*builder.builder));
+            auto array = finish(*builder.builder);
+            if(narrowDeducedTypes && (size_t)column >= specifiedTypeCount)
+            {
+                // type deduction only looks at the first rows, the narrowest type
+                // can be decided only after all values are known
+                array = narrowNumericArray(array);
+                columnTypes.at(column).type = array->type();
+            }
+            arrays.push_back(array);
         };
 
         visitDataType(typeInfo.type, [&] (auto type)
@@ -392,6 +466,49 @@ struct ColumnWriterFor<arrow::Type::DOUBLE> : ColumnWriter
     }
 };
 
+// narrow numeric types are printed like their int64/double counterparts
+template<arrow::Type::type id>
+struct NarrowNumericColumnWriter : ColumnWriter
+{
+    using ColumnWriter::ColumnWriter;
+    virtual void consumeFromChunk(const arrow::Array &chunk, CsvGenerator &generator)
+    {
+        using Array = typename TypeDescription<id>::Array;
+        const auto value = static_cast<const Array&>(chunk).Value(usedFromChunk);
+        int n = 0;
+        if constexpr(std::is_floating_point_v<decltype(value)>)
+            n = std::snprintf(buffer, std::size(buffer), "%lf", (double)value);
+        else if constexpr(std::is_signed_v<decltype(value)>)
+            n = std::snprintf(buffer, std::size(buffer), "%" PRId64, (int64_t)value);
+        else
+            n = std::snprintf(buffer, std::size(buffer), "%" PRIu64, (uint64_t)value);
+        generator.writeField(buffer, n);
+    }
+};
+
+template<> struct ColumnWriterFor<arrow::Type::INT8>   : NarrowNumericColumnWriter<arrow::Type::INT8>   { using NarrowNumericColumnWriter::NarrowNumericColumnWriter; };
+template<> struct ColumnWriterFor<arrow::Type::INT16>  : NarrowNumericColumnWriter<arrow::Type::INT16>  { using NarrowNumericColumnWriter::NarrowNumericColumnWriter; };
+template<> struct ColumnWriterFor<arrow::Type::INT32>  : NarrowNumericColumnWriter<arrow::Type::INT32>  { using NarrowNumericColumnWriter::NarrowNumericColumnWriter; };
+template<> struct ColumnWriterFor<arrow::Type::UINT8>  : NarrowNumericColumnWriter<arrow::Type::UINT8>  { using NarrowNumericColumnWriter::NarrowNumericColumnWriter; };
+template<> struct ColumnWriterFor<arrow::Type::UINT16> : NarrowNumericColumnWriter<arrow::Type::UINT16> { using NarrowNumericColumnWriter::NarrowNumericColumnWriter; };
+template<> struct ColumnWriterFor<arrow::Type::UINT32> : NarrowNumericColumnWriter<arrow::Type::UINT32> { using NarrowNumericColumnWriter::NarrowNumericColumnWriter; };
+template<> struct ColumnWriterFor<arrow::Type::UINT64> : NarrowNumericColumnWriter<arrow::Type::UINT64> { using NarrowNumericColumnWriter::NarrowNumericColumnWriter; };
+template<> struct ColumnWriterFor<arrow::Type::FLOAT>  : NarrowNumericColumnWriter<arrow::Type::FLOAT>  { using NarrowNumericColumnWriter::NarrowNumericColumnWriter; };
+
+template<>
+struct ColumnWriterFor<arrow::Type::BOOL> : ColumnWriter
+{
+    using ColumnWriter::ColumnWriter;
+    virtual void consumeFromChunk(const arrow::Array &chunk, CsvGenerator &generator)
+    {
+        const auto value = static_cast<const arrow::BooleanArray&>(chunk).Value(usedFromChunk);
+        if(value)
+            generator.writeField("true", 4);
+        else
+            generator.writeField("false", 5);
+    }
+};
+
 template<>
 struct ColumnWriterFor<arrow::Type::TIMESTAMP> : ColumnWriter
 {
@@ -413,6 +530,7 @@ struct ColumnWriterFor<arrow::Type::TIMESTAMP> : ColumnWriter
 
 void generateCsv(std::ostream &out, const arrow::Table &table, GeneratorHeaderPolicy headerPolicy, GeneratorQuotingPolicy quotingPolicy, char fieldSeparator /*= ','*/, char recordSeparator /*= '\n'*/, char quote /*= '"'*/)
 {
+    TRACE_SPAN("csv", "write");
     CsvGenerator generator{out, quotingPolicy, fieldSeparator, recordSeparator, quote};
 
     std::vector<std::unique_ptr<ColumnWriter>> writers;
@@ -443,7 +561,7 @@ void generateCsv(std::ostream &out, const arrow::Table &table, GeneratorHeaderPo
     }
 
     // write records
-    for(int row = 0; row < table.num_rows(); row++)
+    for(int64_t row = 0; row < table.num_rows(); row++)
     {
         if(row)
             out << recordSeparator;
@@ -570,8 +688,15 @@ std::vector<std::vector<std::string_view>> CsvParser::parseCsvTable()
 {
     std::vector<std::vector<std::string_view>> ret;
 
+    const auto totalSize = std::max<double>(1, (double)(bufferEnd - bufferStart));
     for( ; bufferIterator < bufferEnd; )
     {
+        if(ret.size() % 65536 == 0)
+        {
+            checkCancellation();
+            reportProgress((bufferIterator - bufferStart) / totalSize, "parsing");
+        }
+
         auto parsedRecord = parseRecord();
         lastColumnCount = parsedRecord.size();
         ret.push_back(std::move(parsedRecord));
@@ -583,7 +708,7 @@ std::vector<std::vector<std::string_view>> CsvParser::parseCsvTable()
 std::shared_ptr<arrow::Table> FormatCSV::readString(std::string data, const CsvReadOptions &options) const
 {
     auto csv = parseCsvData(std::move(data), options.fieldSeparator, options.recordSeparator, options.quote);
-    return csvToArrowTable(csv, options.header, options.columnTypes, options.typeDeductionDepth);
+    return csvToArrowTable(csv, options.header, options.columnTypes, options.typeDeductionDepth, options.narrowDeducedTypes);
 }
 
 std::string FormatCSV::writeToString(const arrow::Table &table, const CsvWriteOptions &options) const
@@ -60,7 +60,7 @@ struct DFH_EXPORT CsvParser
 };
 
 DFH_EXPORT ParsedCsv parseCsvData(std::string data, char fieldSeparator = ',', char recordSeparator = '\n', char quote = '"');
-DFH_EXPORT std::shared_ptr<arrow::Table> csvToArrowTable(const ParsedCsv &csv, HeaderPolicy header, std::vector<ColumnType> columnTypes, int typeDeductionDepth);
+DFH_EXPORT std::shared_ptr<arrow::Table> csvToArrowTable(const ParsedCsv &csv, HeaderPolicy header, std::vector<ColumnType> columnTypes, int typeDeductionDepth, bool narrowDeducedTypes = false);
 
 DFH_EXPORT void generateCsv(std::ostream &out, const arrow::Table &table, GeneratorHeaderPolicy headerPolicy, GeneratorQuotingPolicy quotingPolicy, char fieldSeparator = ',', char recordSeparator = '\n', char quote = '"');
 
@@ -76,6 +76,7 @@ struct CsvReadOptions : CsvCommonOptions
     HeaderPolicy header = TakeFirstRowAsHeaders{};
     std::vector<ColumnType> columnTypes = {};
     int typeDeductionDepth = 50;
+    bool narrowDeducedTypes = false; // store deduced numeric columns using the smallest type that holds all values exactly
 };
 
 struct CsvWriteOptions : CsvCommonOptions
@@ -57,6 +57,21 @@ struct DslParser
             [&] (auto &&arg) { return parsePredicate(arg); });
     }
 
+    ast::ColumnReference parseColumnReference(const char *columnName)
+    {
+        if(auto nameItr = columnNamesUsed.find(columnName); 
+            nameItr != columnNamesUsed.end())
+        {
+            return ast::ColumnReference{nameItr->second};
+        }
+
+        const ColumnIndexInTable columnIndex = requiredColumnIndex(columnName);
+        const ColumnReferenceId referenceIndex = (int)columnNamesUsed.size();
+        columnNamesUsed[columnName] = referenceIndex;
+        columnMapping[referenceIndex] = columnIndex;
+        return ast::ColumnReference{referenceIndex};
+    }
+
     ast::Value parseValue(const rapidjson::Value &v)
     {
         if(v.IsObject())
@@ -64,20 +79,7 @@ struct DslParser
             const auto obj = v.GetObject();
             if(obj.HasMember("column") && obj["column"].IsString())
             {
-                const auto columnName = obj["column"].GetString();
-                if(auto nameItr = columnNamesUsed.find(columnName); 
-                    nameItr != columnNamesUsed.end())
-                {
-                    return ast::ColumnReference{nameItr->second};
-                }
-                else
-                {
-                    const ColumnIndexInTable columnIndex = requiredColumnIndex(columnName);
-                    const ColumnReferenceId referenceIndex = (int)columnNamesUsed.size();
-                    columnNamesUsed[columnName] = referenceIndex;
-                    columnMapping[referenceIndex] = columnIndex;
-                    return ast::ColumnReference{referenceIndex};
-                }
+                return parseColumnReference(obj["column"].GetString());
             }
             else if(obj.HasMember("timestampNs") && obj["timestampNs"].IsInt64())
             {
@@ -100,6 +102,10 @@ struct DslParser
                 auto onFalse = parseValue(obj["onFalse"]);
                 return ast::Condition{predicate, onTrue, onFalse};
             }
+            else if(obj.HasMember("predicate") || obj.HasMember("boolean"))
+            {
+                return ast::PredicateValue{parsePredicate(v)};
+            }
         }
         else if(v.IsFloat())
         {
@@ -147,6 +153,11 @@ struct DslParser
                 return PredicateOperation{predFromValueOperator, std::move(operands)};
             }
         }
+        else if(const auto column = v.FindMember("column"); 
+            column != v.MemberEnd() && column->value.IsString())
+        {
+            return parseColumnReference(column->value.GetString());
+        }
 
         throw std::runtime_error("Failed to parse LQuery predicate from: " + toJsonString(v));
     }
@@ -161,6 +172,30 @@ struct DslParser
         auto doc = parseJSON(dslJsonText);
         return parseValue(doc);
     }
+
+    std::vector<ast::NamedValue> parseNamedValues(const rapidjson::Value &v)
+    {
+        if(!v.IsArray())
+            throw std::runtime_error("cannot parse named values from non-list json element: " + toJsonString(v));
+
+        const auto elements = v.GetArray();
+        std::vector<ast::NamedValue> ret;
+        ret.reserve(elements.Size());
+        for(auto &&elem : elements)
+        {
+            if(!elem.IsObject() || !elem.HasMember("name") || !elem["name"].IsString() || !elem.HasMember("value"))
+                throw std::runtime_error("Failed to parse LQuery named value from: " + toJsonString(elem));
+
+            ret.emplace_back(elem["name"].GetString(), parseValue(elem["value"]));
+        }
+        return ret;
+    }
+
+    std::vector<ast::NamedValue> parseNamedValues(const char *dslJsonText)
+    {
+        auto doc = parseJSON(dslJsonText);
+        return parseNamedValues(doc);
+    }
 };
 
 }
@@ -213,6 +248,8 @@ namespace ast
             {"lt" , PredicateFromValueOperator::Lesser },
             {"eq" , PredicateFromValueOperator::Equal },
             {"startsWith" , PredicateFromValueOperator::StartsWith },
+            {"endsWith" , PredicateFromValueOperator::EndsWith },
+            {"contains" , PredicateFromValueOperator::Contains },
             {"matches" , PredicateFromValueOperator::Matches },
         };
 
@@ -236,10 +273,54 @@ namespace ast
         return std::make_pair(parser.columnMapping, std::move(val));
     }
 
+    std::pair<ColumnMapping, std::vector<NamedValue>> parseNamedValues(const arrow::Table &table, const char *lqueryJsonText)
+    {
+        DslParser parser{table};
+        auto vals = parser.parseNamedValues(lqueryJsonText);
+        return std::make_pair(parser.columnMapping, std::move(vals));
+    }
+
+    ExpressionSummary summarizeExpression(const char *lqueryJsonText)
+    {
+        ExpressionSummary ret;
+        const auto visit = [&] (const rapidjson::Value &v, auto &self) -> void
+        {
+            if(v.IsArray())
+            {
+                for(auto &&elem : v.GetArray())
+                    self(elem, self);
+            }
+            else if(v.IsObject())
+            {
+                if(const auto column = v.FindMember("column"); column != v.MemberEnd() && column->value.IsString())
+                    ret.columnNames.insert(column->value.GetString());
+                if(const auto operation = v.FindMember("operation"); operation != v.MemberEnd() && operation->value.IsString())
+                {
+                    const auto op = valueOperatorFromName(operation->value.GetString());
+                    ret.divides |= op == ValueOperator::Divide || op == ValueOperator::Modulo;
+                }
+                for(auto &&member : v.GetObject())
+                    self(member.value, self);
+            }
+        };
+
+        const auto doc = parseJSON(lqueryJsonText);
+        visit(doc, visit);
+        if(doc.IsArray())
+            for(auto &&elem : doc.GetArray())
+                if(elem.IsObject() && elem.HasMember("name") && elem["name"].IsString())
+                    ret.valueNames.push_back(elem["name"].GetString());
+        return ret;
+    }
+
     Condition::Condition(const Predicate &p, const Value &onTrue, const Value &onFalse)
         : predicate(p)
         , onTrue(onTrue)
         , onFalse(onFalse)
     {}
 
+    PredicateValue::PredicateValue(const Predicate &p)
+        : predicate(p)
+    {}
+
 }
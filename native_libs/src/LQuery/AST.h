@@ -5,6 +5,8 @@
 
 #include <array>
 #include <memory>
+#include <set>
+#include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -29,7 +31,7 @@ struct HeapHolder
     HeapHolder(const T &t) : ptr(std::make_unique<T>(t)) {};
     HeapHolder(T &&t) : ptr(std::make_unique<T>(std::move(t))) {};
     
-    HeapHolder(const HeapHolder &rhs) : ptr(ptr ? std::make_unique<T>(*rhs.ptr) : nullptr) {};
+    HeapHolder(const HeapHolder &rhs) : ptr(rhs.ptr ? std::make_unique<T>(*rhs.ptr) : nullptr) {};
     HeapHolder(HeapHolder &&rhs) : ptr(std::move(rhs.ptr)) {};
 
     T * operator->() const { return ptr.get(); }
@@ -85,8 +87,16 @@ namespace ast
         HeapHolder<Value> onTrue, onFalse;
     };
 
+    // predicate used as a value: yields boolean column
+    struct PredicateValue
+    {
+        PredicateValue(const Predicate &p);
+
+        HeapHolder<Predicate> predicate;
+    };
+
     using ValueOperation = OperationNode<ValueOperator, Value>;
-    using ValueBase = variant<Literal<int64_t>, Literal<double>, Literal<std::string>, Literal<Timestamp>, ColumnReference, ValueOperation, Condition>;
+    using ValueBase = variant<Literal<int64_t>, Literal<double>, Literal<std::string>, Literal<Timestamp>, ColumnReference, ValueOperation, Condition, PredicateValue>;
 
     struct Value : ValueBase
     {
@@ -104,7 +114,7 @@ namespace ast
     {
         Greater, Lesser,  // works for int/real
         Equal, // works for all types
-        StartsWith, Matches // works for strings
+        StartsWith, EndsWith, Contains, Matches // works for strings
     };
 
 
@@ -112,12 +122,36 @@ namespace ast
 
     using PredicateFromValueOperation = OperationNode<PredicateFromValueOperator, Value>;
     
-    using PredicateBase = variant<PredicateOperation, PredicateFromValueOperation>;
+    // boolean column can be directly used as a predicate
+    using PredicateBase = variant<PredicateOperation, PredicateFromValueOperation, ColumnReference>;
     struct Predicate : PredicateBase
     {
         using PredicateBase::variant;
     };
 
+    struct NamedValue
+    {
+        NamedValue(std::string name, Value value) : name(std::move(name)), value(std::move(value)) {}
+
+        std::string name;
+        Value value;
+    };
+
     DFH_EXPORT std::pair<ColumnMapping, Predicate> parsePredicate(const arrow::Table &table, const char *lqueryJsonText);
     DFH_EXPORT std::pair<ColumnMapping, Value> parseValue(const arrow::Table &table, const char *lqueryJsonText);
+
+    // Parses a list of named values: [{"name": "foo", "value": <value>}, ...]
+    // All values share a single column mapping.
+    DFH_EXPORT std::pair<ColumnMapping, std::vector<NamedValue>> parseNamedValues(const arrow::Table &table, const char *lqueryJsonText);
+
+    // What can be told about the expression (predicate, value or list of named values)
+    // before knowing the table it will be evaluated against.
+    struct ExpressionSummary
+    {
+        std::set<std::string> columnNames; // referenced columns
+        std::vector<std::string> valueNames; // for list of named values
+        bool divides = false; // has division or modulo, that might fail for rows that were meant to be filtered out
+    };
+
+    DFH_EXPORT ExpressionSummary summarizeExpression(const char *lqueryJsonText);
 }
@@ -1,12 +1,173 @@
 #include "Functions.h"
 
-// #include <string_view>
-// #include <arrow/buffer.h>
-// #include <arrow/table.h>
-// 
-// #include "Core/ArrowUtilities.h"
-// #include "AST.h"
-// #include "Core/Common.h"
-// 
-// using namespace std::literals;
-// 
+#include <algorithm>
+
+#include <arrow/buffer.h>
+
+namespace
+{
+    // Calls predicate for each row index and packs results into the bitmap,
+    // writing whole bytes at a time.
+    template<typename Predicate>
+    void fillBitmap(int64_t length, uint8_t *outBitmap, Predicate &&predicate)
+    {
+        const auto fullBytes = length / 8;
+        for(int64_t byteIndex = 0; byteIndex < fullBytes; byteIndex++)
+        {
+            const auto base = byteIndex * 8;
+            uint8_t byte = 0;
+            for(int bit = 0; bit < 8; bit++)
+                byte |= uint8_t(predicate(base + bit)) << bit;
+            outBitmap[byteIndex] = byte;
+        }
+
+        if(const auto remaining = length % 8)
+        {
+            const auto base = fullBytes * 8;
+            uint8_t byte = 0;
+            for(int bit = 0; bit < remaining; bit++)
+                byte |= uint8_t(predicate(base + bit)) << bit;
+            outBitmap[fullBytes] = byte;
+        }
+    }
+
+    // Loads up to 8 bytes as a single word, zero-padding the rest.
+    uint64_t loadWord(const uint8_t *data, int32_t length)
+    {
+        uint64_t ret = 0;
+        std::memcpy(&ret, data, length);
+        return ret;
+    }
+
+    // Compares `length` bytes, the first (at most) 8 of them as a single word.
+    // For short patterns (the typical case) this is all that is needed.
+    struct PatternMatcher
+    {
+        const uint8_t *pattern;
+        int32_t length;
+        int32_t headLength;
+        uint64_t head;
+
+        explicit PatternMatcher(std::string_view pattern)
+            : pattern(reinterpret_cast<const uint8_t *>(pattern.data()))
+            , length((int32_t)pattern.size())
+            , headLength(std::min<int32_t>(length, 8))
+            , head(loadWord(this->pattern, headLength))
+        {}
+
+        bool matchesAt(const uint8_t *data) const
+        {
+            if(headLength == 8)
+            {
+                uint64_t word;
+                std::memcpy(&word, data, 8);
+                if(word != head)
+                    return false;
+            }
+            else if(loadWord(data, headLength) != head)
+                return false;
+
+            return length <= 8
+                || std::memcmp(data + 8, pattern + 8, length - 8) == 0;
+        }
+    };
+
+    struct StringArrayView
+    {
+        const int32_t *offsets;
+        const uint8_t *values;
+
+        explicit StringArrayView(const arrow::StringArray &array)
+            : offsets(array.raw_value_offsets())
+            , values(array.value_data() ? array.value_data()->data() : nullptr)
+        {}
+
+        int32_t length(int64_t index) const { return offsets[index + 1] - offsets[index]; }
+        const uint8_t *data(int64_t index) const { return values + offsets[index]; }
+    };
+}
+
+void EqualTo::execBatch(const arrow::StringArray &array, std::string_view pattern, uint8_t *outBitmap)
+{
+    const StringArrayView strings{array};
+    const PatternMatcher matcher{pattern};
+    fillBitmap(array.length(), outBitmap, [&] (int64_t i)
+    {
+        // length check is a cheap prefilter, most rows won't get past it
+        return strings.length(i) == matcher.length
+            && matcher.matchesAt(strings.data(i));
+    });
+}
+
+void StartsWith::execBatch(const arrow::StringArray &array, std::string_view pattern, uint8_t *outBitmap)
+{
+    const StringArrayView strings{array};
+    const PatternMatcher matcher{pattern};
+    fillBitmap(array.length(), outBitmap, [&] (int64_t i)
+    {
+        return strings.length(i) >= matcher.length
+            && matcher.matchesAt(strings.data(i));
+    });
+}
+
+void EndsWith::execBatch(const arrow::StringArray &array, std::string_view pattern, uint8_t *outBitmap)
+{
+    const StringArrayView strings{array};
+    const PatternMatcher matcher{pattern};
+    fillBitmap(array.length(), outBitmap, [&] (int64_t i)
+    {
+        const auto length = strings.length(i);
+        return length >= matcher.length
+            && matcher.matchesAt(strings.data(i) + length - matcher.length);
+    });
+}
+
+void Contains::execBatch(const arrow::StringArray &array, std::string_view pattern, uint8_t *outBitmap)
+{
+    const StringArrayView strings{array};
+    const auto patternData = reinterpret_cast<const uint8_t *>(pattern.data());
+    const auto patternLength = (int32_t)pattern.size();
+    if(patternLength == 0)
+    {
+        fillBitmap(array.length(), outBitmap, [&] (int64_t i) { return true; });
+        return;
+    }
+
+    // Candidates are found by looking for the pattern's first byte with memchr
+    // (vectorized by the standard library), then filtered by the last byte.
+    // Only then the remaining middle part is compared.
+    const auto first = patternData[0];
+    const auto last = patternData[patternLength - 1];
+    const auto middleLength = std::max<int32_t>(patternLength - 2, 0);
+    fillBitmap(array.length(), outBitmap, [&] (int64_t i)
+    {
+        const auto length = strings.length(i);
+        if(length < patternLength)
+            return false;
+
+        auto itr = strings.data(i);
+        const auto candidatesEnd = itr + length - patternLength + 1;
+        while(itr < candidatesEnd)
+        {
+            itr = static_cast<const uint8_t *>(std::memchr(itr, first, candidatesEnd - itr));
+            if(!itr)
+                return false;
+            if(itr[patternLength - 1] == last
+                && std::memcmp(itr + 1, patternData + 1, middleLength) == 0)
+                return true;
+            ++itr;
+        }
+        return false;
+    });
+}
+
+void Matches::execBatch(const arrow::StringArray &array, std::string_view pattern, uint8_t *outBitmap)
+{
+    const StringArrayView strings{array};
+    const std::regex regex{ std::string(pattern) };
+    fillBitmap(array.length(), outBitmap, [&] (int64_t i)
+    {
+        const auto begin = reinterpret_cast<const char *>(strings.data(i));
+        return std::regex_match(begin, begin + strings.length(i), regex);
+    });
+}
@@ -2,6 +2,8 @@
 
 
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <regex>
 #include <string>
 #include <string_view>
@@ -61,9 +63,18 @@ using namespace std::literals;
             COMPLAIN_ABOUT_OPERAND_TYPES;                                                                \
     } 
 
+// String predicates may additionally provide `execBatch` that evaluates the
+// predicate for a whole string array against a constant pattern. Such kernels
+// work directly on the offsets and values buffers and write the results as
+// a bitmap (one bit per row).
+
 struct GreaterThan { BINARY_REL_OPERATOR(> ); FAIL_ON_STRING(bool); };
 struct LessThan    { BINARY_REL_OPERATOR(< ); FAIL_ON_STRING(bool); };
-struct EqualTo     { BINARY_REL_OPERATOR(== ); };
+struct EqualTo
+{
+    BINARY_REL_OPERATOR(== );
+    static void execBatch(const arrow::StringArray &array, std::string_view pattern, uint8_t *outBitmap);
+};
 struct StartsWith
 {
     static bool exec(const std::string_view &lhs, const std::string_view &rhs)
@@ -77,6 +88,39 @@ struct StartsWith
     {
         COMPLAIN_ABOUT_OPERAND_TYPES;
     }
+
+    static void execBatch(const arrow::StringArray &array, std::string_view pattern, uint8_t *outBitmap);
+};
+struct EndsWith
+{
+    static bool exec(const std::string_view &lhs, const std::string_view &rhs)
+    {
+        return lhs.length() >= rhs.length()
+            && std::memcmp(lhs.data() + lhs.length() - rhs.length(), rhs.data(), rhs.length()) == 0;
+    }
+
+    template<typename Lhs, typename Rhs>
+    static bool exec(const Lhs &lhs, const Rhs &rhs)
+    {
+        COMPLAIN_ABOUT_OPERAND_TYPES;
+    }
+
+    static void execBatch(const arrow::StringArray &array, std::string_view pattern, uint8_t *outBitmap);
+};
+struct Contains
+{
+    static bool exec(const std::string_view &lhs, const std::string_view &rhs)
+    {
+        return lhs.find(rhs) != std::string_view::npos;
+    }
+
+    template<typename Lhs, typename Rhs>
+    static bool exec(const Lhs &lhs, const Rhs &rhs)
+    {
+        COMPLAIN_ABOUT_OPERAND_TYPES;
+    }
+
+    static void execBatch(const arrow::StringArray &array, std::string_view pattern, uint8_t *outBitmap);
 };
 struct Matches
 {
@@ -91,6 +135,9 @@ struct Matches
     {
         COMPLAIN_ABOUT_OPERAND_TYPES;
     }
+
+    // compiles the regex just once for the whole array
+    static void execBatch(const arrow::StringArray &array, std::string_view pattern, uint8_t *outBitmap);
 };
 
 
@@ -4,6 +4,10 @@
 #include <arrow/buffer.h>
 #include <arrow/table.h>
 #include <regex>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <utility>
 
 #include "Core/ArrowUtilities.h"
 #include "AST.h"
@@ -12,6 +16,33 @@
 
 using namespace std::literals;
 
+namespace
+{
+    // Pool for buffers of values computed by the interpreter. Intermediate results
+    // are short-lived, so by default they reuse the scratch memory. The result of the
+    // top-level node becomes the output column, so it must come from the regular pool
+    // (see Interpreter::outputPool).
+    thread_local arrow::MemoryPool *resultPool = nullptr;
+
+    arrow::MemoryPool *currentResultPool()
+    {
+        return resultPool ? resultPool : scratchMemoryPool();
+    }
+
+    struct ResultPoolScope
+    {
+        arrow::MemoryPool *previous;
+
+        explicit ResultPoolScope(arrow::MemoryPool *pool)
+            : previous(std::exchange(resultPool, pool))
+        {}
+        ~ResultPoolScope()
+        {
+            resultPool = previous;
+        }
+    };
+}
+
 //namespace
 //{
 
@@ -20,6 +51,7 @@ using namespace std::literals;
     struct ArrayOperand 
     {
         std::shared_ptr<arrow::Buffer> buffer;
+        bool scratch = false; // buffer must not outlive the evaluation
 
         auto mutable_data() { return reinterpret_cast<T *>(buffer->mutable_data()); }
         auto data() const { return reinterpret_cast<const T*>(buffer->data()); }
@@ -29,7 +61,9 @@ using namespace std::literals;
         {}
         explicit ArrayOperand(size_t length)
         {
-            buffer = allocateBuffer<T>(length).first;
+            const auto pool = currentResultPool();
+            buffer = allocateBuffer<T>(length, pool).first;
+            scratch = pool == scratchMemoryPool();
         }
 
         //T &operator[](size_t index) { return mutable_data()[index]; }
@@ -63,30 +97,23 @@ using namespace std::literals;
     struct ArrayOperand<std::string>
     {
         const arrow::StringArray *array;
-//         std::shared_ptr<arrow::Buffer> bufferOffsets;
-//         std::shared_ptr<arrow::Buffer> bufferData;
-     
+        const int32_t *offsets;
+        const uint8_t *values;
+
         explicit ArrayOperand(const arrow::Array *array)
             : array(static_cast<const arrow::StringArray *>(array))
-//             , bufferOffsets(array->value_offsets())
-//             , bufferData(array->value_data())
-        {
-//             const auto &arrayS = static_cast<const arrow::StringArray&>(array);
-//             bufferOffsets = arrayS.value_offsets();
-//             bufferData = arrayS.value_data();
-        }
+            , offsets(this->array->raw_value_offsets())
+            , values(this->array->value_data() ? this->array->value_data()->data() : nullptr)
+        {}
         explicit ArrayOperand(size_t length)
         {
             throw std::runtime_error("not implemented: building string column in interpreter");
-//             bufferOffsets = allocateBuffer<int32_t>(length);
-//             bufferData = allocateBuffer<uint8_t>(0);
         }
 
         std::string_view load(size_t index) const
         {
-            int32_t length;
-            auto ptr = array->GetValue(index, &length);
-            return std::string_view(reinterpret_cast<const char*>(ptr), length);
+            const auto start = offsets[index];
+            return std::string_view(reinterpret_cast<const char*>(values + start), offsets[index + 1] - start);
         }
 
         void store(size_t index, const std::string &value)
@@ -132,7 +159,7 @@ using namespace std::literals;
     }
 
     template<typename Operation, typename ... Operands>
-    auto exec(int64_t count, const Operands & ...operands)
+    auto execGeneric(int64_t count, const Operands & ...operands)
     {
         using OperationResult = decltype(Operation::exec(getValue(operands, 0)...));
 
@@ -154,6 +181,106 @@ using namespace std::literals;
         }
     }
 
+    template<typename Operation>
+    using BatchStringKernel = decltype(Operation::execBatch(std::declval<const arrow::StringArray &>(), std::string_view{}, std::declval<uint8_t *>()));
+
+    template<typename Operation, typename ... Operands>
+    auto exec(int64_t count, const Operands & ...operands)
+    {
+        return execGeneric<Operation>(count, operands...);
+    }
+
+    // string column against string literal: use batch kernel if operation provides one
+    template<typename Operation>
+    auto exec(int64_t count, const ArrayOperand<std::string> &lhs, const std::string &rhs)
+    {
+        if constexpr(is_detected_v<BatchStringKernel, Operation>)
+        {
+            ArrayOperand<bool> ret{ (size_t)count };
+            Operation::execBatch(*lhs.array, rhs, ret.mutable_data());
+            return ret;
+        }
+        else
+            return execGeneric<Operation>(count, lhs, rhs);
+    }
+
+// Textual key that identifies a subexpression structurally -- two nodes with
+// the same key evaluate to the same result within a single table.
+std::string subexpressionKey(const ast::Predicate &predicate);
+std::string subexpressionKey(const ast::Value &value)
+{
+    const auto operandsKey = [] (auto &&operands)
+    {
+        std::string ret = "(";
+        for(auto &&operand : operands)
+            ret += subexpressionKey(operand) + ",";
+        return ret + ")";
+    };
+
+    return visit(overloaded{
+        [&] (const ast::ColumnReference &col)    { return fmt::format("c{}", col.columnRefId); },
+        [&] (const ast::ValueOperation &op)      { return fmt::format("v{}{}", (int)op.what, operandsKey(op.operands)); },
+        [&] (const ast::Literal<int64_t> &l)     { return fmt::format("i{}", l.literal); },
+        [&] (const ast::Literal<double> &l)      { return fmt::format("d{}", l.literal); },
+        [&] (const ast::Literal<std::string> &l) { return fmt::format("s{}:{}", l.literal.size(), l.literal); },
+        [&] (const ast::Literal<Timestamp> &l)   { return fmt::format("t{}", l.literal.toStorage()); },
+        [&] (const ast::Condition &condition)    
+        {
+            return fmt::format("?({},{},{})", subexpressionKey(*condition.predicate), 
+                subexpressionKey(*condition.onTrue), subexpressionKey(*condition.onFalse));
+        },
+        [&] (const ast::PredicateValue &p)       { return fmt::format("?{}", subexpressionKey(*p.predicate)); }
+        }, (const ast::ValueBase &) value);
+}
+std::string subexpressionKey(const ast::Predicate &predicate)
+{
+    const auto operandsKey = [] (auto &&operands)
+    {
+        std::string ret = "(";
+        for(auto &&operand : operands)
+            ret += subexpressionKey(operand) + ",";
+        return ret + ")";
+    };
+
+    return visit(overloaded{
+        [&] (const ast::PredicateFromValueOperation &op) { return fmt::format("p{}{}", (int)op.what, operandsKey(op.operands)); },
+        [&] (const ast::PredicateOperation &op)          { return fmt::format("b{}{}", (int)op.what, operandsKey(op.operands)); },
+        [&] (const ast::ColumnReference &col)            { return fmt::format("c{}", col.columnRefId); }
+        }, (const ast::PredicateBase &) predicate);
+}
+
+void collectColumnReferences(const ast::Predicate &predicate, std::set<ColumnReferenceId> &out);
+void collectColumnReferences(const ast::Value &value, std::set<ColumnReferenceId> &out)
+{
+    visit(overloaded{
+        [&] (const ast::ColumnReference &col) { out.insert(col.columnRefId); },
+        [&] (const ast::ValueOperation &op)
+        {
+            for(auto &&operand : op.operands)
+                collectColumnReferences(operand, out);
+        },
+        [&] (const ast::Condition &condition)
+        {
+            collectColumnReferences(*condition.predicate, out);
+            collectColumnReferences(*condition.onTrue, out);
+            collectColumnReferences(*condition.onFalse, out);
+        },
+        [&] (const ast::PredicateValue &p) { collectColumnReferences(*p.predicate, out); },
+        [&] (auto &&literal) {}
+        }, (const ast::ValueBase &) value);
+}
+void collectColumnReferences(const ast::Predicate &predicate, std::set<ColumnReferenceId> &out)
+{
+    visit(overloaded{
+        [&] (const ast::ColumnReference &col) { out.insert(col.columnRefId); },
+        [&] (auto &&op)
+        {
+            for(auto &&operand : op.operands)
+                collectColumnReferences(operand, out);
+        }
+        }, (const ast::PredicateBase &) predicate);
+}
+
 struct Interpreter
 {
     Interpreter(const arrow::Table &table, const ColumnMapping &mapping)
@@ -175,6 +302,21 @@ struct Interpreter
 
     using Field = variant<int64_t, double, std::string, Timestamp, ArrayOperand<int64_t>, ArrayOperand<double>, ArrayOperand<std::string>, ArrayOperand<Timestamp>>;
 
+    // Results of already evaluated operations, so the subexpressions shared
+    // between several evaluated values are computed only once.
+    std::unordered_map<std::string, Field> evaluatedValues;
+    std::unordered_map<std::string, ArrayOperand<bool>> evaluatedPredicates;
+
+    // Pool for the result of the next evaluated node. Set to the regular pool before
+    // evaluating an output value; nested nodes (evaluated first) reset it to scratch,
+    // then the top-level node allocates its result from the pool it was given.
+    arrow::MemoryPool *outputPool = scratchMemoryPool();
+
+    ResultPoolScope takeOutputPool()
+    {
+        return ResultPoolScope{ std::exchange(outputPool, scratchMemoryPool()) };
+    }
+
     Field fieldFromColumn(const arrow::Column &column)
     {
         const auto data = column.data();
@@ -186,7 +328,28 @@ struct Interpreter
         {
             using ArrowType = typename std::remove_pointer_t<decltype(array)>::TypeClass;
             using T = typename TypeDescription<ArrowType::type_id>::ValueType;
-            return ArrayOperand<T>(array);
+            using WideT = WidenedType<T>;
+            if constexpr(std::is_same_v<T, bool>)
+            {
+                // Boolean columns are bit-packed, in value context they
+                // are expanded to 0/1 integers.
+                ArrayOperand<int64_t> ret{ (size_t)array->length() };
+                for(int64_t i = 0; i < array->length(); i++)
+                    ret.store(i, array->Value(i));
+                return ret;
+            }
+            else if constexpr(std::is_same_v<T, WideT>)
+            {
+                return ArrayOperand<T>(array);
+            }
+            else
+            {
+                // Narrow numeric columns are promoted to int64/double, so
+                // the operations need to be implemented only for these.
+                ArrayOperand<WideT> ret{ (size_t)array->length() };
+                std::copy_n(array->raw_values(), array->length(), ret.mutable_data());
+                return ret;
+            }
         });
     }
     std::vector<Field> evaluateOperands(const std::vector<ast::Value> &operands)
@@ -210,6 +373,25 @@ struct Interpreter
     }
 
     Field evaluateValue(const ast::Value &value)
+    {
+        const auto poolScope = takeOutputPool();
+
+        // literals and column references are cheap, no point in caching them
+        const auto &valueBase = (const ast::ValueBase &) value;
+        if(!holds_alternative<ast::ValueOperation>(valueBase) && !holds_alternative<ast::Condition>(valueBase)
+            && !holds_alternative<ast::PredicateValue>(valueBase))
+            return evaluateValueUncached(value);
+
+        auto key = subexpressionKey(value);
+        if(auto itr = evaluatedValues.find(key); itr != evaluatedValues.end())
+            return itr->second;
+
+        auto ret = evaluateValueUncached(value);
+        evaluatedValues.emplace(std::move(key), ret);
+        return ret;
+    }
+
+    Field evaluateValueUncached(const ast::Value &value)
     {
         return visit(overloaded{
             [&] (const ast::ColumnReference &col)    -> Field { return fieldFromColumn(*columns[col.columnRefId]); },
@@ -259,12 +441,51 @@ struct Interpreter
                     return exec<Condition>(table.num_rows(), mask, t, f);
                 }, onTrue, onFalse);
             },
+            [&] (const ast::PredicateValue &p)       -> Field 
+            {
+                // nested in other value, predicate result is treated as 0/1 integer
+                const auto mask = this->evaluate(*p.predicate);
+                ArrayOperand<int64_t> ret{ (size_t)table.num_rows() };
+                for(int64_t i = 0; i < table.num_rows(); i++)
+                    ret.store(i, mask.load(i));
+                return ret;
+            },
             //[&] (const ast::Literal<std::string> &l) -> Field { return l.literal; },
             [&] (auto &&t) -> Field { throw std::runtime_error("not implemented: value node of type "s + typeid(decltype(t)).name()); }
             }, (const ast::ValueBase &) value);
     }
 
+    ArrayOperand<bool> maskFromColumn(const arrow::Column &column)
+    {
+        if(column.type()->id() != arrow::Type::BOOL)
+            THROW("column `{}` of type {} cannot be used as a predicate, boolean column is required", column.name(), column.type()->ToString());
+
+        const auto data = column.data();
+        if(data->num_chunks() != 1)
+            throw std::runtime_error("not implemented: processing of chunked arrays");
+
+        // copy the bits, so the mask does not depend on the array offset
+        // (nulls are cleared when producing the final result)
+        const auto &array = static_cast<const arrow::BooleanArray &>(*data->chunk(0));
+        ArrayOperand<bool> ret{ (size_t)array.length() };
+        for(int64_t i = 0; i < array.length(); i++)
+            ret.store(i, array.Value(i));
+        return ret;
+    }
+
     ArrayOperand<bool> evaluate(const ast::Predicate &p)
+    {
+        const auto poolScope = takeOutputPool();
+        auto key = subexpressionKey(p);
+        if(auto itr = evaluatedPredicates.find(key); itr != evaluatedPredicates.end())
+            return itr->second;
+
+        auto ret = evaluateUncached(p);
+        evaluatedPredicates.emplace(std::move(key), ret);
+        return ret;
+    }
+
+    ArrayOperand<bool> evaluateUncached(const ast::Predicate &p)
     {
         return visit(overloaded{
             [&] (const ast::PredicateFromValueOperation &elem) -> ArrayOperand<bool>
@@ -288,6 +509,14 @@ struct Interpreter
                 return visit(
                     [&] (auto &&lhs, auto &&rhs) { return exec<StartsWith>(table.num_rows(), lhs, rhs);},
                     getOperand(operands, 0), getOperand(operands, 1));
+            case ast::PredicateFromValueOperator::EndsWith:
+                return visit(
+                    [&] (auto &&lhs, auto &&rhs) { return exec<EndsWith>(table.num_rows(), lhs, rhs);},
+                    getOperand(operands, 0), getOperand(operands, 1));
+            case ast::PredicateFromValueOperator::Contains:
+                return visit(
+                    [&] (auto &&lhs, auto &&rhs) { return exec<Contains>(table.num_rows(), lhs, rhs);},
+                    getOperand(operands, 0), getOperand(operands, 1));
             case ast::PredicateFromValueOperator::Matches:
                 return visit(
                     [&] (auto &&lhs, auto &&rhs) { return exec<Matches>(table.num_rows(), lhs, rhs);},
@@ -310,6 +539,10 @@ struct Interpreter
             default:
                 throw std::runtime_error("not implemented: predicate operator " + std::to_string((int)op.what));
             }
+        },
+            [&] (const ast::ColumnReference &col) -> ArrayOperand<bool>
+        {
+            return maskFromColumn(*columns[col.columnRefId]);
         }
             }, (const ast::PredicateBase &) p);
     }
@@ -319,19 +552,26 @@ struct Interpreter
 
 std::shared_ptr<arrow::Buffer> execute(const arrow::Table &table, const ast::Predicate &predicate, ColumnMapping mapping)
 {
-    Interpreter interpreter{table, mapping};
-    auto ret = interpreter.evaluate(predicate);
+    auto ret = [&]
+    {
+        TRACE_SPAN("interpreter", "evaluate predicate");
+        Interpreter interpreter{table, mapping};
+        return interpreter.evaluate(predicate);
+    }();
 
+    TRACE_SPAN("interpreter", "apply null mask");
     for(auto && [refid, columnIndex] : mapping)
     {
         const auto column = table.column(columnIndex);
         if(column->null_count() == 0)
             continue;
 
-        int i = 0;
-        iterateOverGeneric(*column, 
-            [&] (auto &&) { i++;              }, 
-            [&]           { ret.store(i++, false); });
+        iterateOverValidityRuns(*column, [&] (bool valid, int64_t start, int64_t length)
+        {
+            if(!valid)
+                for(int64_t i = start; i < start + length; i++)
+                    ret.store(i, false);
+        });
     }
 
     return ret.buffer;
@@ -341,19 +581,30 @@ template<typename T>
 auto arrayFrom(const int64_t &length, const ArrayOperand<T> &arrayProto, std::shared_ptr<arrow::Buffer> nullBuffer)
 {
     constexpr auto id = ValueTypeToId<T>();
-    if constexpr(std::is_arithmetic_v<T> || std::is_same_v<Timestamp, T>)
+    if constexpr(std::is_same_v<T, bool> || std::is_arithmetic_v<T> || std::is_same_v<Timestamp, T>)
     {
-        const auto type = getTypeSingleton<id>();
-        return std::make_shared<typename TypeDescription<id>::Array>(type, length, arrayProto.buffer, nullBuffer, -1);
+        // Results shared with other expressions may come from the cache, still in the scratch memory.
+        auto buffer = arrayProto.buffer;
+        if(arrayProto.scratch)
+        {
+            std::shared_ptr<arrow::Buffer> copy;
+            checkStatus(buffer->Copy(0, buffer->size(), memoryPool(), &copy));
+            buffer = copy;
+        }
+
+        if constexpr(std::is_same_v<T, bool>)
+            return std::make_shared<arrow::BooleanArray>(length, buffer, nullBuffer, -1);
+        else
+            return std::make_shared<typename TypeDescription<id>::Array>(getTypeSingleton<id>(), length, buffer, nullBuffer, -1);
     }
     else
     {
-        arrow::StringBuilder builder;
+        arrow::StringBuilder builder{memoryPool()};
         checkStatus(builder.Reserve(length));
 
         if(nullBuffer)
         {
-            for(int i = 0; i < length; i++)
+            for(int64_t i = 0; i < length; i++)
             {
                 if(arrow::BitUtil::GetBit(nullBuffer->data(), i))
                 {
@@ -366,7 +617,7 @@ auto arrayFrom(const int64_t &length, const ArrayOperand<T> &arrayProto, std::sh
         }
         else
         {
-            for(int i = 0; i < length; i++)
+            for(int64_t i = 0; i < length; i++)
             {
                 const auto sv = arrayProto.load(i);
                 checkStatus(builder.Append(sv.data(), (int)sv.size()));
@@ -392,18 +643,18 @@ auto arrayFrom(const int64_t &length, const T &constant, std::shared_ptr<arrow::
     }
     else
     {
-        arrow::StringBuilder builder;
+        arrow::StringBuilder builder{memoryPool()};
         checkStatus(builder.Reserve(length));
 
         const auto stringSize = (int32_t)constant.size();
         if(!nullBuffer)
         {
-            for(int i = 0; i < length; i++)
+            for(int64_t i = 0; i < length; i++)
                 checkStatus(builder.Append(constant.data(), stringSize));
         }
         else
         {
-            for(int i = 0; i < length; i++)
+            for(int64_t i = 0; i < length; i++)
             {
                 if(arrow::BitUtil::GetBit(nullBuffer->data(), i))
                     checkStatus(builder.Append(constant.data(), stringSize));
@@ -416,34 +667,121 @@ auto arrayFrom(const int64_t &length, const T &constant, std::shared_ptr<arrow::
     }
 }
 
-std::shared_ptr<arrow::Array> execute(const arrow::Table &table, const ast::Value &value, ColumnMapping mapping)
+// Builds validity bitmaps for the results: a row is valid only if all columns
+// used by the expression are non-null in that row. Bitmaps are shared between
+// expressions that reference the same set of columns.
+struct NullMaskCache
 {
-    Interpreter interpreter{table, mapping};
-    auto field = interpreter.evaluateValue(value);
+    const arrow::Table &table;
+    const ColumnMapping &mapping;
+    std::unordered_map<ColumnReferenceId, std::shared_ptr<arrow::Buffer>> columnMasks;
+    std::map<std::set<ColumnReferenceId>, std::shared_ptr<arrow::Buffer>> combinedMasks;
+
+    NullMaskCache(const arrow::Table &table, const ColumnMapping &mapping)
+        : table(table), mapping(mapping)
+    {}
 
+    // nullptr when column has no nulls
+    std::shared_ptr<arrow::Buffer> columnMask(ColumnReferenceId refId)
+    {
+        if(auto itr = columnMasks.find(refId); itr != columnMasks.end())
+            return itr->second;
 
-    bool usedNullableColumns = false;
-    BitmaskGenerator bitmask{table.num_rows(), true};
+        const auto column = table.column(mapping.at(refId));
+        std::shared_ptr<arrow::Buffer> ret;
+        if(column->null_count() != 0)
+        {
+            BitmaskGenerator bitmask{table.num_rows(), true};
+            iterateOverValidityRuns(*column, [&] (bool valid, int64_t start, int64_t length)
+            {
+                if(!valid)
+                    for(int64_t i = start; i < start + length; i++)
+                        bitmask.clear(i);
+            });
+            ret = bitmask.buffer;
+        }
 
-    for(auto && [refid, columnIndex] : mapping)
+        columnMasks[refId] = ret;
+        return ret;
+    }
+
+    // nullptr when none of given columns has nulls
+    std::shared_ptr<arrow::Buffer> maskFor(const std::set<ColumnReferenceId> &refIds)
     {
-        const auto column = table.column(columnIndex);
-        if(column->null_count() == 0)
-            continue;
- 
-        usedNullableColumns = true;
+        if(auto itr = combinedMasks.find(refIds); itr != combinedMasks.end())
+            return itr->second;
+
+        std::vector<std::shared_ptr<arrow::Buffer>> masks;
+        for(auto refId : refIds)
+            if(auto mask = columnMask(refId))
+                masks.push_back(mask);
+
+        std::shared_ptr<arrow::Buffer> ret;
+        if(masks.size() == 1)
+        {
+            ret = masks.front();
+        }
+        else if(masks.size() > 1)
+        {
+            BitmaskGenerator bitmask{table.num_rows(), true};
+            const auto byteCount = arrow::BitUtil::BytesForBits(table.num_rows());
+            for(auto &mask : masks)
+            {
+                const auto maskData = mask->data();
+                for(int64_t i = 0; i < byteCount; i++)
+                    bitmask.data[i] &= maskData[i];
+            }
+            ret = bitmask.buffer;
+        }
 
-        int64_t i = 0;
-        iterateOverGeneric(*column, 
-            [&] (auto &&) { i++;}, 
-            [&]           { bitmask.clear(i++); });
+        combinedMasks[refIds] = ret;
+        return ret;
     }
+};
 
-    const auto nullBufferToBeUsed = usedNullableColumns ? bitmask.buffer : nullptr;
+// Predicate on the top level of value yields boolean column, anything else
+// goes through the interpreter's fields.
+std::shared_ptr<arrow::Array> evaluateToArray(Interpreter &interpreter, const ast::Value &value, std::shared_ptr<arrow::Buffer> nullBuffer)
+{
+    TRACE_SPAN("interpreter", "evaluate value");
+    const auto length = interpreter.table.num_rows();
+    interpreter.outputPool = memoryPool();
+    if(auto predicateValue = get_if<ast::PredicateValue>(&(const ast::ValueBase &) value))
+        return arrayFrom(length, interpreter.evaluate(*predicateValue->predicate), nullBuffer);
 
+    auto field = interpreter.evaluateValue(value);
     return visit(
         [&] (auto &&i) -> std::shared_ptr<arrow::Array>
         {
-            return arrayFrom(table.num_rows(), i, nullBufferToBeUsed);
+            return arrayFrom(length, i, nullBuffer);
         }, field);
 }
+
+std::shared_ptr<arrow::Array> execute(const arrow::Table &table, const ast::Value &value, ColumnMapping mapping)
+{
+    Interpreter interpreter{table, mapping};
+
+    std::set<ColumnReferenceId> usedColumns;
+    for(auto && [refid, columnIndex] : mapping)
+        usedColumns.insert(refid);
+
+    NullMaskCache nullMasks{table, mapping};
+    const auto nullBufferToBeUsed = nullMasks.maskFor(usedColumns);
+    return evaluateToArray(interpreter, value, nullBufferToBeUsed);
+}
+
+std::vector<std::shared_ptr<arrow::Array>> execute(const arrow::Table &table, const std::vector<ast::NamedValue> &values, ColumnMapping mapping)
+{
+    // Single interpreter for all values, so the columns are consolidated once
+    // and common subexpressions are evaluated once.
+    Interpreter interpreter{table, mapping};
+    NullMaskCache nullMasks{table, mapping};
+
+    return transformToVector(values, [&] (const ast::NamedValue &namedValue)
+    {
+        std::set<ColumnReferenceId> usedColumns;
+        collectColumnReferences(namedValue.value, usedColumns);
+        const auto nullBufferToBeUsed = nullMasks.maskFor(usedColumns);
+        return evaluateToArray(interpreter, namedValue.value, nullBufferToBeUsed);
+    });
+}
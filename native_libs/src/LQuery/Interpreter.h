@@ -18,4 +18,5 @@ namespace ast
 using ArrayMask = std::vector<unsigned char>;
 
 std::shared_ptr<arrow::Buffer> execute(const arrow::Table &table, const ast::Predicate &predicate, ColumnMapping mapping);
-std::shared_ptr<arrow::Array> execute(const arrow::Table &table, const ast::Value &value, ColumnMapping mapping);
\ No newline at end of file
+std::shared_ptr<arrow::Array> execute(const arrow::Table &table, const ast::Value &value, ColumnMapping mapping);
+std::vector<std::shared_ptr<arrow::Array>> execute(const arrow::Table &table, const std::vector<ast::NamedValue> &values, ColumnMapping mapping);
\ No newline at end of file
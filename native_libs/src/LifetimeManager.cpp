@@ -1,5 +1,71 @@
 #include "LifetimeManager.h"
 
+#include <algorithm>
+#include <bitset>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+    const void * const Tombstone = reinterpret_cast<const void *>(uintptr_t{1});
+    constexpr size_t InitialCapacity = 16;
+
+    uint64_t hashAddress(const void *address)
+    {
+        // objects are at least 8-aligned, Fibonacci hashing spreads the remaining bits
+        return (uint64_t(reinterpret_cast<uintptr_t>(address)) >> 3) * 0x9E3779B97F4A7C15ull;
+    }
+
+    // Fibonacci hash is good only in its high bits (the low ones depend only on the low bits
+    // of the address, e.g. the lowest is always 0 for 16-aligned objects). The top 6 bits
+    // pick the shard, the slot index is taken from the bits right below them.
+    size_t homeSlot(const void *address, size_t mask)
+    {
+        const auto indexBits = std::bitset<64>(mask).count();
+        return size_t((hashAddress(address) << 6) >> (64 - indexBits));
+    }
+
+    using Slot = LifetimeManager::Slot;
+
+    // Linear probing. Calls f for each slot with the given address, until f returns true.
+    // Returns slot for which f returned true, or nullptr.
+    template<typename Function>
+    Slot *probe(std::vector<Slot> &slots, const void *address, Function &&f)
+    {
+        if(slots.empty())
+            return nullptr;
+
+        const auto mask = slots.size() - 1;
+        for(auto index = homeSlot(address, mask); ; index = (index + 1) & mask)
+        {
+            auto &slot = slots[index];
+            if(slot.address == nullptr)
+                return nullptr;
+            if(slot.address == address && f(slot))
+                return &slot;
+        }
+    }
+
+    Slot &emptySlotFor(std::vector<Slot> &slots, const void *address)
+    {
+        const auto mask = slots.size() - 1;
+        for(auto index = homeSlot(address, mask); ; index = (index + 1) & mask)
+        {
+            auto &slot = slots[index];
+            if(slot.address == nullptr || slot.address == Tombstone)
+                return slot;
+        }
+    }
+
+    [[noreturn]] void throwNotRegistered(const void *address)
+    {
+        std::ostringstream out;
+        out << "Cannot find storage for pointer " << address << " -- was it previously registered?";
+        throw std::runtime_error(out.str());
+    }
+}
+
 LifetimeManager::LifetimeManager()
 {
 }
@@ -7,3 +73,176 @@ LifetimeManager::LifetimeManager()
 LifetimeManager::~LifetimeManager()
 {
 }
+
+LifetimeManager::Shard &LifetimeManager::shardFor(const void *address) const
+{
+    // top bits of the hash, the ones below pick slot within the shard
+    return shards[hashAddress(address) >> 58];
+}
+
+void LifetimeManager::add(const void *address, const std::type_info &type, std::shared_ptr<const void> object)
+{
+    auto &shard = shardFor(address);
+    std::unique_lock<std::mutex> lock{ shard.mx };
+    addLocked(shard, address, type, std::move(object));
+}
+
+void LifetimeManager::addLocked(Shard &shard, const void *address, const std::type_info &type, std::shared_ptr<const void> object)
+{
+    if(auto slot = probe(shard.slots, address, [&] (Slot &s) { return *s.type == type; }))
+    {
+        ++slot->ownershipCount;
+        return;
+    }
+
+    // keep load factor below 3/4, rehashing also drops tombstones
+    if((shard.usedCount + 1) * 4 > shard.slots.size() * 3)
+    {
+        auto newCapacity = std::max(InitialCapacity, shard.slots.size());
+        while((shard.liveCount + 1) * 2 > newCapacity)
+            newCapacity *= 2;
+
+        std::vector<Slot> newSlots(newCapacity);
+        for(auto &slot : shard.slots)
+            if(slot.address != nullptr && slot.address != Tombstone)
+                emptySlotFor(newSlots, slot.address) = std::move(slot);
+
+        shard.slots = std::move(newSlots);
+        shard.usedCount = shard.liveCount;
+    }
+
+    auto &slot = emptySlotFor(shard.slots, address);
+    if(slot.address == nullptr)
+        ++shard.usedCount;
+    ++shard.liveCount;
+    slot.address = address;
+    slot.type = &type;
+    slot.object = std::move(object);
+    slot.ownershipCount = 1;
+}
+
+void LifetimeManager::addMany(const std::type_info &type, std::vector<std::shared_ptr<const void>> objects)
+{
+    // Shards are locked one at a time, grouping by shard saves relocking.
+    std::vector<size_t> order(objects.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&] (size_t lhs, size_t rhs)
+    {
+        return &shardFor(objects[lhs].get()) < &shardFor(objects[rhs].get());
+    });
+
+    Shard *lockedShard = nullptr;
+    std::unique_lock<std::mutex> lock;
+    for(auto index : order)
+    {
+        const auto address = objects[index].get();
+        auto &shard = shardFor(address);
+        if(&shard != lockedShard)
+        {
+            lock = std::unique_lock<std::mutex>{ shard.mx };
+            lockedShard = &shard;
+        }
+        addLocked(shard, address, type, std::move(objects[index]));
+    }
+}
+
+std::shared_ptr<const void> LifetimeManager::access(const void *address, const std::type_info &type) const
+{
+    auto &shard = shardFor(address);
+    std::unique_lock<std::mutex> lock{ shard.mx };
+
+    bool foundAddress = false;
+    const auto slot = probe(shard.slots, address, [&] (Slot &s)
+    {
+        foundAddress = true;
+        return *s.type == type;
+    });
+    if(slot)
+        return slot->object;
+
+    if(foundAddress)
+    {
+        std::ostringstream out;
+        out << "Pointer " << address << " was registered with a different type than requested " << type.name();
+        throw std::runtime_error(out.str());
+    }
+    throwNotRegistered(address);
+}
+
+bool LifetimeManager::releaseLocked(Shard &shard, const void *address, std::shared_ptr<const void> &released)
+{
+    const auto slot = probe(shard.slots, address, [] (Slot &) { return true; });
+    if(!slot)
+        return false;
+
+    if(--slot->ownershipCount == 0)
+    {
+        released = std::move(slot->object);
+        slot->address = Tombstone;
+        slot->type = nullptr;
+        --shard.liveCount;
+    }
+    return true;
+}
+
+void LifetimeManager::releaseOwnership(const void *ptr)
+{
+    // Destroying the object can take time, so it is done after the lock is released.
+    std::shared_ptr<const void> released;
+    auto &shard = shardFor(ptr);
+    std::unique_lock<std::mutex> lock{ shard.mx };
+    const auto known = releaseLocked(shard, ptr, released);
+    lock.unlock();
+
+    if(!known)
+        throwNotRegistered(ptr);
+}
+
+void LifetimeManager::releaseOwnership(const void *const *ptrs, int64_t count)
+{
+    std::vector<std::shared_ptr<const void>> released; // destroyed once locks are released
+    const void *unknownAddress = nullptr;
+
+    std::vector<int64_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&] (int64_t lhs, int64_t rhs)
+    {
+        return &shardFor(ptrs[lhs]) < &shardFor(ptrs[rhs]);
+    });
+
+    Shard *lockedShard = nullptr;
+    std::unique_lock<std::mutex> lock;
+    for(auto index : order)
+    {
+        const auto address = ptrs[index];
+        auto &shard = shardFor(address);
+        if(&shard != lockedShard)
+        {
+            lock = std::unique_lock<std::mutex>{ shard.mx };
+            lockedShard = &shard;
+        }
+
+        std::shared_ptr<const void> object;
+        if(!releaseLocked(shard, address, object))
+            unknownAddress = address;
+        else if(object)
+            released.push_back(std::move(object));
+    }
+    if(lock)
+        lock.unlock();
+
+    released.clear();
+    if(unknownAddress)
+        throwNotRegistered(unknownAddress);
+}
+
+size_t LifetimeManager::registeredCount() const
+{
+    size_t ret = 0;
+    for(auto &shard : shards)
+    {
+        std::unique_lock<std::mutex> lock{ shard.mx };
+        ret += shard.liveCount;
+    }
+    return ret;
+}
@@ -1,56 +1,59 @@
 #pragma once
 
-// NOTE: this a third-party C++17 std::any implementation - providing nonstd::any. 
-// When C++17 is available, it will default to std::any, otherwise it will provide
-// its own header-only implementation with the same interface.
-//
-// To be removed and replaced with std::any when C++17 complaint library is available
-// on Mac platforms we want to be compiled upon.
-#include <nonstd/any.hpp>
-
+#include <cstdint>
 #include <memory>
 #include <mutex>
-#include <sstream>
+#include <typeinfo>
 #include <vector>
-#include <unordered_map>
 
 #include "Core/Common.h"
 
-// TODO? could get rid of most headers by using pimpl
-
 // Class is meant as a helper for managing std::shared_ptr lifetimes when they are shared
 // with a foreign language through C API.
 // Each time when shared_ptr is moved to foreign code it should be done through `addOwnership`
 // When foreign code is done with the pointer, `releaseOwnership` should be called.
 //
-// Storage is thread-safe (internally synchronized with a lock).
-//
-// Technically there's nothing shared_ptr specific in storage (it uses type-erased any),
-// if needed it can be adjusted to work with other kinds of types with similar semantics.
+// Storage is thread-safe. Addresses are spread over independently locked shards,
+// so that concurrent calls rarely contend. Each shard is an open-addressing table of typed slots:
+// registering the same object again only bumps the slot's ownership count.
 class DFH_EXPORT LifetimeManager
 {
-    mutable std::mutex mx;
-    std::unordered_multimap<const void *, nonstd::any> storage; // address => shared_ptr<T>
+public:
+    struct Slot
+    {
+        const void *address = nullptr; // nullptr for never used slot, Tombstone for released one
+        const std::type_info *type = nullptr; // type of the shared_ptr given to addOwnership
+        std::shared_ptr<const void> object;
+        int64_t ownershipCount = 0;
+    };
 
-    // Looks up the pointer and calls the given function with storage iterator (while having the storage lock).
-    template<typename Function>
-    auto access(const void *ptr, Function &&f) const
+private:
+    struct alignas(64) Shard
     {
-        std::unique_lock<std::mutex> lock{ mx };
-        if(auto itr = storage.find(ptr); itr != storage.end())
-        {
-            return f(itr);
-        }
+        std::mutex mx;
+        std::vector<Slot> slots; // capacity is zero or power of two
+        size_t usedCount = 0; // slots that are not empty, including tombstones
+        size_t liveCount = 0;
+    };
 
-        std::ostringstream out;
-        out << "Cannot find storage for pointer " << ptr << " -- was it previously registered?";
-        throw std::runtime_error(out.str());
-    }
+    static constexpr size_t ShardCount = 64;
+    mutable Shard shards[ShardCount];
+
+    Shard &shardFor(const void *address) const;
+
+    void add(const void *address, const std::type_info &type, std::shared_ptr<const void> object);
+    static void addLocked(Shard &shard, const void *address, const std::type_info &type, std::shared_ptr<const void> object);
+    static bool releaseLocked(Shard &shard, const void *address, std::shared_ptr<const void> &released); // false if address is unknown
+    void addMany(const std::type_info &type, std::vector<std::shared_ptr<const void>> objects);
+    std::shared_ptr<const void> access(const void *address, const std::type_info &type) const;
 
 public:
     LifetimeManager();
     ~LifetimeManager();
 
+    LifetimeManager(const LifetimeManager &) = delete;
+    LifetimeManager &operator=(const LifetimeManager &) = delete;
+
     template<typename T>
     T *addOwnership(std::shared_ptr<T> ptr)
     {
@@ -59,28 +62,39 @@ public:
             return nullptr;
 
         auto ret = ptr.get();
-        std::unique_lock<std::mutex> lock{ mx };
-        storage.emplace(ret, std::move(ptr));
+        add(ret, typeid(T), std::move(ptr));
         return ret;
     }
-    void releaseOwnership(const void *ptr)
+
+    // Registers all objects at once, locking each shard only once. Returns their addresses in the same order.
+    template<typename T>
+    std::vector<T *> addOwnership(std::vector<std::shared_ptr<T>> ptrs)
     {
-        access(ptr, [this] (auto itr)
+        std::vector<T *> ret;
+        ret.reserve(ptrs.size());
+        std::vector<std::shared_ptr<const void>> objects;
+        objects.reserve(ptrs.size());
+        for(auto &ptr : ptrs)
         {
-            // TODO should separate retrieving any from storage and deleting it
-            // deleting can take time and lock is not needed then
-            storage.erase(itr);
-        });
+            ret.push_back(ptr.get());
+            if(ptr)
+                objects.push_back(std::move(ptr));
+        }
+        addMany(typeid(T), std::move(objects));
+        return ret;
     }
 
+    void releaseOwnership(const void *ptr);
+
+    // Releases a single ownership of each address. All known addresses are released
+    // even if some are not, then an exception is thrown.
+    void releaseOwnership(const void *const *ptrs, int64_t count);
+
     // NOTE: be careful, as this does not handle shared_ptr casting (type should exactly match)
     template<typename T>
     std::shared_ptr<T> accessOwned(const void *ptr) const
     {
-        return access(ptr, [&] (auto itr)
-        {
-            return nonstd::any_cast<std::shared_ptr<T>>(itr->second);
-        });
+        return std::const_pointer_cast<T>(std::static_pointer_cast<const T>(access(ptr, typeid(T))));
     }
     template<typename T>
     std::shared_ptr<T> accessOwned(const T *ptr) const
@@ -102,6 +116,7 @@ public:
         return ret;
     }
 
+    size_t registeredCount() const; // count of distinct registered objects
 
     // TODO reconsider at some stage more explicit global state
     static auto &instance()
@@ -3,6 +3,7 @@
 #include <bitset>
 #include <cassert>
 #include <iostream>
+#include <limits>
 #include <numeric>
 #include <vector>
 
@@ -65,15 +66,13 @@ struct FilteredArrayBuilder
             std::tie(offsets, offsetsData) = allocateBuffer<int32_t>(length + 1);
             offsetsData[0] = 0;
 
-            int64_t totalStringLength = 0;
-            for(auto &chunk : array.chunks())
-            {
-                const auto &array = dynamic_cast<const arrow::StringArray&>(*chunk);
-                const auto dataLength = array.value_offset(array.length()) - array.value_offset(0);
-                totalStringLength += dataLength;
-            }
-
-            std::tie(values, valueData) = allocateBuffer<uint8_t>(totalStringLength);
+            std::tie(values, valueData) = allocateBuffer<uint8_t>(totalStringLength(array));
+        }
+        else if constexpr(id == arrow::Type::BOOL)
+        {
+            const auto valueByteCount = arrow::BitUtil::BytesForBits(length);
+            std::tie(values, valueData) = allocateBuffer<uint8_t>(valueByteCount);
+            std::memset(valueData, 0, valueByteCount);
         }
         else
         {
@@ -92,7 +91,7 @@ struct FilteredArrayBuilder
 //     }
 
     template<bool nullable>
-    FORCE_INLINE void addElem(const Array &array, const T *arrayValues, int arrayIndex)
+    FORCE_INLINE void addElem(const Array &array, const T *arrayValues, int64_t arrayIndex)
     {
         if(!nullable || array.IsValid(arrayIndex))
         {
@@ -105,7 +104,7 @@ struct FilteredArrayBuilder
     };
 
     template<unsigned char maskCode, bool nullable>
-    void addStatic8(const Array &array, const T *arrayValues, int arrayIndex)
+    void addStatic8(const Array &array, const T *arrayValues, int64_t arrayIndex)
     {
         // Note: it will be fast even if we call dynamic variant - compiler can easily propagate const
 //          for(int bit = 0; bit < 8; ++bit)
@@ -121,14 +120,14 @@ struct FilteredArrayBuilder
     }
 
     template<bool nullable>
-    FORCE_INLINE void addDynamic1(unsigned char maskCode, const Array &array, const T *arrayValues, int arrayIndex, int bitIndex)
+    FORCE_INLINE void addDynamic1(unsigned char maskCode, const Array &array, const T *arrayValues, int64_t arrayIndex, int bitIndex)
     {
         if((maskCode & (1 << bitIndex)) != 0)
             addElem<nullable>(array, arrayValues, arrayIndex);
     }
 
     template<bool nullable>
-    void addDynamic8(unsigned char maskCode, const Array &array, const T *arrayValues, int arrayIndex)
+    void addDynamic8(unsigned char maskCode, const Array &array, const T *arrayValues, int64_t arrayIndex)
     {
         for(int bit = 0; bit < 8; ++bit)
             addDynamic1<nullable>(maskCode, array, arrayValues, arrayIndex + bit, bit);
@@ -148,7 +147,7 @@ struct FilteredArrayBuilder
         {
             const auto sourceOffsets = array.raw_value_offsets();
 
-            for(int i = 0; i < N; i++)
+            for(int64_t i = 0; i < N; i++)
             {
                 if(arrow::BitUtil::GetBit(mask, processedCount))
                 {
@@ -168,6 +167,27 @@ struct FilteredArrayBuilder
                 ++processedCount;
             }
         }
+        else if constexpr(id == arrow::Type::BOOL)
+        {
+            // values are bit-packed, so they are copied bit by bit
+            for(int64_t i = 0; i < N; i++)
+            {
+                if(arrow::BitUtil::GetBit(mask, processedCount))
+                {
+                    if(!nullable || array.IsValid(i))
+                    {
+                        if(array.Value(i))
+                            arrow::BitUtil::SetBit(valueData, addedCount);
+                    }
+                    else
+                    {
+                        arrow::BitUtil::ClearBit(nullData, addedCount);
+                    }
+                    ++addedCount;
+                }
+                ++processedCount;
+            }
+        }
         else
         {
             const auto arrayValues = array.raw_values();
@@ -255,12 +275,50 @@ struct FilteredArrayBuilder
     {
         if constexpr(id == arrow::Type::STRING)
             return std::make_shared<Array>(length, offsets, values, bitmask, arrow::kUnknownNullCount);
+        else if constexpr(id == arrow::Type::BOOL)
+            return std::make_shared<Array>(length, values, bitmask, arrow::kUnknownNullCount);
         else
             return std::make_shared<Array>(type, length, values, bitmask, arrow::kUnknownNullCount);
     }
 
+    static int64_t totalStringLength(const arrow::ChunkedArray &array)
+    {
+        int64_t ret = 0;
+        for(auto &chunk : array.chunks())
+        {
+            const auto &array = dynamic_cast<const arrow::StringArray&>(*chunk);
+            ret += array.value_offset(array.length()) - array.value_offset(0);
+        }
+        return ret;
+    }
+
     static std::shared_ptr<arrow::Column> makeFiltered(const unsigned char * const mask, int64_t length, const arrow::Column &column)
     {
+        if constexpr(id == arrow::Type::STRING)
+        {
+            // String offsets are 32-bit, so the filtered data might not fit into a single array.
+            // In such case each source chunk (whose data fits by definition) is filtered separately.
+            if(totalStringLength(*column.data()) > std::numeric_limits<int32_t>::max())
+            {
+                std::vector<std::shared_ptr<arrow::Array>> filteredChunks;
+                int64_t processedCount = 0;
+                for(auto &&chunk : column.data()->chunks())
+                {
+                    int64_t chunkLength = 0;
+                    for(int64_t i = 0; i < chunk->length(); i++)
+                        chunkLength += arrow::BitUtil::GetBit(mask, processedCount + i);
+
+                    const arrow::ChunkedArray singleChunk{arrow::ArrayVector{chunk}};
+                    FilteredArrayBuilder fab{mask, chunkLength, singleChunk};
+                    fab.processedCount = processedCount;
+                    fab.addInternal(singleChunk);
+                    filteredChunks.push_back(chunkLength ? fab.finish() : chunk->Slice(0, 0));
+                    processedCount += chunk->length();
+                }
+                return std::make_shared<arrow::Column>(column.field(), filteredChunks);
+            }
+        }
+
         FilteredArrayBuilder fab{mask, length, *column.data()};
         fab.addInternal(column);
         auto retArr = fab.finish();
@@ -352,7 +410,7 @@ std::shared_ptr<arrow::Column> interpolateNA(std::shared_ptr<arrow::Column> colu
     return visitType(*column->type(), [&] (auto id) -> std::shared_ptr<arrow::Column>
     {
         // Interpolation is currently defined only for arithmetic types.
-        if constexpr(id.value == arrow::Type::STRING)
+        if constexpr(id.value == arrow::Type::STRING || id.value == arrow::Type::BOOL)
         {
             throw std::runtime_error("column `"+ column->name() + "` cannot be interpolated: wrong type: `" + column->type()->ToString() + "`");
         }
@@ -383,10 +441,12 @@ std::shared_ptr<arrow::Table> dropNA(std::shared_ptr<arrow::Table> table, const
         if(column->null_count() == 0)
             continue;
 
-        int64_t row = 0;
-        iterateOverGeneric(*column,
-            [&] (auto&&) { row++;                },
-            [&] ()       { bitmask.clear(row++); });
+        iterateOverValidityRuns(*column, [&] (bool valid, int64_t start, int64_t length)
+        {
+            if(!valid)
+                for(int64_t row = start; row < start + length; row++)
+                    bitmask.clear(row);
+        });
     }
 
     return filter(table, *bitmask.buffer);
@@ -412,23 +472,38 @@ std::shared_ptr<arrow::Array> fillNATyped(const Array &array, DynamicField value
             [] (const auto &v) -> std::string_view { throw std::runtime_error("cannot fill string array with value of type "s + typeid(v).name()); }
             }, value);
 
-        arrow::StringBuilder builder;
+        arrow::StringBuilder builder{memoryPool()};
         iterateOver<arrow::Type::STRING>(array,
             [&] (auto &&s) { builder.Append(s.data(), s.size()); },
             [&] () { builder.Append(valueToFill.data(), valueToFill.size()); });
         return finish(builder);
 
     }
+    else if constexpr(std::is_same_v<Array, arrow::BooleanArray>)
+    {
+        // boolean value is given as 0/1 integer (see adjustTypeForFilling)
+        const bool valueToFill = get<int64_t>(value) != 0;
+
+        arrow::BooleanBuilder builder{memoryPool()};
+        checkStatus(builder.Reserve(array.length()));
+        iterateOver<arrow::Type::BOOL>(array,
+            [&] (bool b) { builder.Append(b); },
+            [&] () { builder.Append(valueToFill); });
+        return finish(builder);
+    }
     else
     {
+        // narrow numeric values are given as int64/double (see adjustTypeForFilling)
         using T = typename Array::value_type;
-        auto valueToFill = get<T>(value);
+        using WideT = WidenedType<T>;
+        const auto valueToFill = static_cast<T>(get<WideT>(value));
         auto [buffer, data] = allocateBuffer<T>(array.length());
-        int row = 0;
         std::memcpy(data, array.raw_values(), buffer->size());
-        iterateOver<ArrayTypeDescription<Array>::id>(array,
-            [&] (auto &&) { ++row; },
-            [&, data=data] () { data[row++] = valueToFill; });
+        iterateOverValidityRuns(array, [&, data=data] (bool valid, int64_t start, int64_t length)
+        {
+            if(!valid)
+                std::fill_n(data + start, length, valueToFill);
+        });
 
         return std::make_shared<Array>(array.type(), array.length(), buffer, nullptr);
     }
@@ -497,7 +572,11 @@ std::shared_ptr<arrow::Table> fillNA(std::shared_ptr<arrow::Table> table, const
 std::shared_ptr<arrow::Table> filter(std::shared_ptr<arrow::Table> table, const char *dslJsonText)
 {
     auto [mapping, predicate] = ast::parsePredicate(*table, dslJsonText);
-    const auto maskBuffer = execute(*table, predicate, mapping);
+    const auto maskBuffer = [&]
+    {
+        TRACE_SPAN("filter", "evaluate mask");
+        return execute(*table, predicate, mapping);
+    }();
     return filter(table, *maskBuffer);
 }
 
@@ -506,31 +585,75 @@ std::shared_ptr<arrow::Table> filter(std::shared_ptr<arrow::Table> table, const
     const unsigned char * const maskData = maskBuffer.data();
     const auto oldRowCount = table->num_rows();
 
-    int newRowCount = 0;
-    for(int i = 0; i < oldRowCount; i++)
-        newRowCount += arrow::BitUtil::GetBit(maskData, i);
-
-    std::vector<std::shared_ptr<arrow::Column>> newColumns;
+    int64_t newRowCount = 0;
+    {
+        TRACE_SPAN("filter", "count rows");
+        for(int64_t i = 0; i < oldRowCount; i++)
+            newRowCount += arrow::BitUtil::GetBit(maskData, i);
+    }
 
-    for(int columnIndex = 0; columnIndex < table->num_columns(); columnIndex++)
+    // columns are filtered independently of each other
+    TRACE_SPAN("filter", "filter columns");
+    std::vector<std::shared_ptr<arrow::Column>> newColumns(table->num_columns());
+    parallelForEach(table->num_columns(), [&] (int64_t columnIndex)
     {
-        const auto column = table->column(columnIndex);
-        const auto filteredColumn = visitType(*column->type(), [&] (auto id) -> std::shared_ptr<arrow::Column>
+        TRACE_SPAN("filter", "filter column");
+        const auto column = table->column((int)columnIndex);
+        newColumns[columnIndex] = visitType(*column->type(), [&] (auto id) -> std::shared_ptr<arrow::Column>
         {
             return FilteredArrayBuilder<id.value>::makeFiltered(maskData, newRowCount, *column);
         });
-        newColumns.push_back(filteredColumn);
-    }
+    });
 
     return arrow::Table::Make(table->schema(), newColumns);
 }
 
+std::shared_ptr<arrow::Table> filter(std::shared_ptr<arrow::Table> table, const arrow::Column &mask)
+{
+    if(mask.type()->id() != arrow::Type::BOOL)
+        THROW("cannot filter using column `{}` of type {}: boolean column is required", mask.name(), mask.type()->ToString());
+    if(mask.length() != table->num_rows())
+        THROW("cannot filter using column `{}`: it has {} rows, table has {}", mask.name(), mask.length(), table->num_rows());
+
+    BitmaskGenerator bitmask{table->num_rows(), false};
+    int64_t row = 0;
+    iterateOver<arrow::Type::BOOL>(mask,
+        [&] (bool value)
+        {
+            if(value)
+                bitmask.set(row);
+            ++row;
+        },
+        [&] { ++row; });
+
+    return filter(table, *bitmask.buffer);
+}
+
 std::shared_ptr<arrow::Array> each(std::shared_ptr<arrow::Table> table, const char *dslJsonText)
 {
     auto [mapping, v] = ast::parseValue(*table, dslJsonText);
     return execute(*table, v, mapping);
 }
 
+std::shared_ptr<arrow::Table> eachMany(std::shared_ptr<arrow::Table> table, const char *dslJsonText, bool appendToInput)
+{
+    auto [mapping, values] = ast::parseNamedValues(*table, dslJsonText);
+    auto arrays = execute(*table, values, mapping);
+
+    std::vector<std::shared_ptr<arrow::Column>> columns;
+    if(appendToInput)
+        columns = getColumns(*table);
+
+    for(int i = 0; i < values.size(); i++)
+    {
+        const auto &array = arrays.at(i);
+        auto field = arrow::field(values.at(i).name, array->type(), array->null_count());
+        columns.push_back(std::make_shared<arrow::Column>(field, array));
+    }
+
+    return tableFromColumns(columns);
+}
+
 DFH_EXPORT std::shared_ptr<arrow::Column> shift(std::shared_ptr<arrow::Column> column, int64_t offset)
 {
     if(offset == 0)
@@ -592,6 +715,33 @@ struct ConvertTo<arrow::Type::DOUBLE>
     template<typename T>
     double operator() (T)                        const { throw std::runtime_error(__FUNCTION__ + ": invalid conversion"s); }
 };
+// narrow numeric types are filled with int64/double values
+template<> struct ConvertTo<arrow::Type::INT8>   : ConvertTo<arrow::Type::INT64>  {};
+template<> struct ConvertTo<arrow::Type::INT16>  : ConvertTo<arrow::Type::INT64>  {};
+template<> struct ConvertTo<arrow::Type::INT32>  : ConvertTo<arrow::Type::INT64>  {};
+template<> struct ConvertTo<arrow::Type::UINT8>  : ConvertTo<arrow::Type::INT64>  {};
+template<> struct ConvertTo<arrow::Type::UINT16> : ConvertTo<arrow::Type::INT64>  {};
+template<> struct ConvertTo<arrow::Type::UINT32> : ConvertTo<arrow::Type::INT64>  {};
+template<> struct ConvertTo<arrow::Type::UINT64> : ConvertTo<arrow::Type::INT64>  {};
+template<> struct ConvertTo<arrow::Type::FLOAT>  : ConvertTo<arrow::Type::DOUBLE> {};
+// booleans are filled with 0/1 integers
+template<>
+struct ConvertTo<arrow::Type::BOOL>
+{
+    int64_t operator() (int64_t value)            const { return value != 0; }
+    int64_t operator() (double value)             const { return value != 0; }
+    int64_t operator() (const std::string &value) const { return (*this)(std::string_view(value)); }
+    int64_t operator() (std::string_view value)   const 
+    {
+        if(value == "true" || value == "1")
+            return 1;
+        if(value == "false" || value == "0")
+            return 0;
+        throw std::runtime_error(__FUNCTION__ + ": invalid conversion of `"s + std::string(value) + "` to boolean");
+    }
+    template<typename T>
+    int64_t operator() (T)                        const { throw std::runtime_error(__FUNCTION__ + ": invalid conversion"s); }
+};
 template<>
 struct ConvertTo<arrow::Type::TIMESTAMP>
 {
@@ -623,15 +773,39 @@ DFH_EXPORT std::shared_ptr<arrow::Table> groupBy(std::shared_ptr<arrow::Table> t
         std::vector<int64_t> nullRows;
 
         int64_t row = 0;
-        iterateOver<keyTypeID.value>(*keyColumn,
-            [&] (auto &&value)
+        const auto handleNull = [&] ()
+        {
+            nullRows.push_back(row++);
+        };
+        {
+            TRACE_SPAN("groupBy", "hash keys");
+            if constexpr(hasFixedWidthValues<keyTypeID.value>)
             {
-                keyToRows[value].push_back(row++);
-            },
-            [&] ()
+                using StorageT = typename TypeDescription<keyTypeID.value>::StorageValueType;
+                iterateOverRuns<keyTypeID.value>(*keyColumn,
+                    [&] (const StorageT *values, int64_t length)
+                    {
+                        for(int64_t i = 0; i < length; i++)
+                            keyToRows[KeyT(values[i])].push_back(row++);
+                    },
+                    [&] (int64_t length)
+                    {
+                        for(int64_t i = 0; i < length; i++)
+                            handleNull();
+                    });
+            }
+            else
             {
-                nullRows.push_back(row++);
-            });
+                iterateOver<keyTypeID.value>(*keyColumn,
+                    [&] (auto &&value)
+                    {
+                        keyToRows[value].push_back(row++);
+                    },
+                    handleNull);
+            }
+        }
+
+        TRACE_SPAN("groupBy", "gather");
 
         Permutation permutation(N);
         auto target = permutation.begin();
@@ -696,8 +870,8 @@ std::shared_ptr<arrow::Column> splitOn(const arrow::Column &column, std::string_
     if(column.type()->id() != arrow::Type::STRING)
         THROW("cannot split on column `{}` of type `{}`: type string required", column.name(), column.type()->ToString());
 
-    auto stringBuilder = std::make_shared<arrow::StringBuilder>();
-    arrow::ListBuilder listBuilder{ nullptr, stringBuilder };
+    auto stringBuilder = std::make_shared<arrow::StringBuilder>(memoryPool());
+    arrow::ListBuilder listBuilder{ memoryPool(), stringBuilder };
 
     auto onNull = [&]()
     {
@@ -751,14 +925,14 @@ struct Ungrouper
     }
     void operator()(const ObservedType &t, ListElemView list) const
     {
-        for(int i = 0; i < list.length; ++i)
+        for(int64_t i = 0; i < list.length; ++i)
         {
             append(*builder, t);
         }
     }
     void operator()(const std::nullptr_t &t, ListElemView list) const
     {
-        for(int i = 0; i < list.length; ++i)
+        for(int64_t i = 0; i < list.length; ++i)
         {
             builder->AppendNull();
         }
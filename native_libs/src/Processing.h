@@ -31,7 +31,9 @@ DFH_EXPORT std::shared_ptr<arrow::Table> fillNA(std::shared_ptr<arrow::Table> ta
 
 DFH_EXPORT std::shared_ptr<arrow::Table> filter(std::shared_ptr<arrow::Table> table, const char *dslJsonText);
 DFH_EXPORT std::shared_ptr<arrow::Table> filter(std::shared_ptr<arrow::Table> table, const arrow::Buffer &maskBuffer);
+DFH_EXPORT std::shared_ptr<arrow::Table> filter(std::shared_ptr<arrow::Table> table, const arrow::Column &mask); // boolean column, null is treated as false
 DFH_EXPORT std::shared_ptr<arrow::Array> each(std::shared_ptr<arrow::Table> table, const char *dslJsonText);
+DFH_EXPORT std::shared_ptr<arrow::Table> eachMany(std::shared_ptr<arrow::Table> table, const char *dslJsonText, bool appendToInput = false); // evaluates list of named values in one go
 DFH_EXPORT std::shared_ptr<arrow::Column> shift(std::shared_ptr<arrow::Column> column, int64_t offset);
 
 DFH_EXPORT DynamicField adjustTypeForFilling(DynamicField valueGivenByUser, const arrow::DataType &type);
@@ -297,14 +297,3 @@ void PythonInterpreter::setEnvironment()
     Py_SetPath(widenString(pythonPath.c_str()).data());
 }
 #endif
-
-namespace
-{
-    struct AutomaticallyCreateInterpreter
-    {
-        AutomaticallyCreateInterpreter()
-        {
-            PythonInterpreter::instance();
-        }
-    } guardian;
-}
@@ -8,6 +8,12 @@ struct DFH_EXPORT PythonInterpreter
     PythonInterpreter();
     ~PythonInterpreter();
 
+    // Interpreter is started by the first call, on the calling thread, which then holds the GIL
+    // for the rest of the program: Python may be used only on that thread, so the first call
+    // should come from the thread making all the Learn/Plotter calls. Objects released elsewhere
+    // must not decref (see NumpyBuffer). The interpreter is finalized at exit, possibly before
+    // other static objects (like LifetimeManager) are destroyed: anything that may still hold
+    // Python references then must check Py_IsInitialized() before decref.
     static PythonInterpreter &instance();
     static std::string libraryName();
 #ifndef _WIN32
@@ -17,7 +23,8 @@ struct DFH_EXPORT PythonInterpreter
     pybind11::object toPyDateTime(Timestamp timestamp) const;
 };
 
-// TLDR: If .cpp file uses numpy it must contain this macro.
+// TLDR: If .cpp file uses numpy it must contain this macro and call
+// `initializeNumpy()` before touching Python.
 //
 // NOTE: [MWU]
 // NumPy uses not entirely fortunate approach that upon initialization call
@@ -34,16 +41,23 @@ struct DFH_EXPORT PythonInterpreter
 // Perhaps someone smarter (or with more time to spend on this) can devise a 
 // solution that works on all 3 supported platforms and is not as ugly as this
 // macro-based workaround.
+//
+// Initialization is done on the first call rather than when the library is
+// loaded, so that programs not using Python don't pay for starting the
+// interpreter and importing numpy. Function-local static makes it thread-safe;
+// if it throws, the next call tries again.
 #define COMPILATION_UNIT_USING_NUMPY                  \
 namespace                                             \
 {                                                     \
-    struct NumpyGuard                                 \
+    void initializeNumpy()                            \
     {                                                 \
-        NumpyGuard()                                  \
+        static const bool initialized = []            \
         {                                             \
             PythonInterpreter::instance();            \
             if(_import_array() < 0)                   \
                 throw pybind11::error_already_set();  \
-        }                                             \
-    } numpyGuard;                                     \
+            return true;                              \
+        }();                                          \
+        (void)initialized;                            \
+    }                                                 \
 }
\ No newline at end of file
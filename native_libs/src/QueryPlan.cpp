@@ -0,0 +1,402 @@
+#include "QueryPlan.h"
+
+#include <optional>
+#include <set>
+#include <sstream>
+
+#include <arrow/buffer.h>
+#include <arrow/table.h>
+
+#include "Core/ArrowUtilities.h"
+#include "LQuery/AST.h"
+#include "LQuery/Interpreter.h"
+#include "Processing.h"
+
+namespace
+{
+    using ColumnNames = std::optional<std::set<std::string>>; // nullopt stands for all columns
+
+    struct Step
+    {
+        plan::Node node;
+        ColumnNames liveBefore; // columns the step and the following ones need
+        ColumnNames liveAfter; // columns the following steps need
+    };
+
+    QueryPlanPtr makePlan(QueryPlanPtr input, plan::Node node)
+    {
+        if(!input)
+            THROW("query plan must start with a scan");
+        return std::make_shared<QueryPlan>(QueryPlan{ std::move(input), std::move(node) });
+    }
+
+    std::vector<plan::Node> linearize(const QueryPlan &plan)
+    {
+        std::vector<plan::Node> ret;
+        for(auto node = &plan; node; node = node->input.get())
+            ret.push_back(node->node);
+        std::reverse(ret.begin(), ret.end());
+        return ret;
+    }
+
+    bool isRowWise(const plan::Node &node)
+    {
+        return holds_alternative<plan::Map>(node) || holds_alternative<plan::Select>(node);
+    }
+
+    // Limit goes before row-wise steps, so they process fewer rows. Limit after sort makes it top-K.
+    void pushDownLimits(std::vector<plan::Node> &nodes)
+    {
+        for(bool changed = true; changed; )
+        {
+            changed = false;
+            for(size_t i = 1; i < nodes.size(); i++)
+            {
+                const auto limit = get_if<plan::Limit>(&nodes[i]);
+                if(!limit)
+                    continue;
+
+                if(auto previousLimit = get_if<plan::Limit>(&nodes[i - 1]))
+                {
+                    previousLimit->count = std::min(previousLimit->count, limit->count);
+                    nodes.erase(nodes.begin() + i);
+                    changed = true;
+                }
+                else if(auto sort = get_if<plan::Sort>(&nodes[i - 1]))
+                {
+                    sort->limit = sort->limit < 0 ? limit->count : std::min(sort->limit, limit->count);
+                    nodes.erase(nodes.begin() + i);
+                    changed = true;
+                }
+                else if(isRowWise(nodes[i - 1]))
+                {
+                    std::swap(nodes[i - 1], nodes[i]);
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    void addTo(ColumnNames &names, const std::set<std::string> &toAdd)
+    {
+        if(names)
+            names->insert(toAdd.begin(), toAdd.end());
+    }
+
+    ColumnNames neededBefore(const plan::Node &node, ColumnNames neededAfter)
+    {
+        return visit(overloaded{
+            [&] (const plan::Scan &) { return neededAfter; },
+            [&] (const plan::Filter &filter)
+            {
+                addTo(neededAfter, ast::summarizeExpression(filter.predicateJson.c_str()).columnNames);
+                return neededAfter;
+            },
+            [&] (const plan::Map &map)
+            {
+                const auto summary = ast::summarizeExpression(map.namedValuesJson.c_str());
+                if(neededAfter)
+                    for(auto &name : summary.valueNames)
+                        neededAfter->erase(name);
+                addTo(neededAfter, summary.columnNames);
+                return neededAfter;
+            },
+            [&] (const plan::Select &select)
+            {
+                std::set<std::string> ret;
+                for(auto &name : select.columnNames)
+                    if(!neededAfter || neededAfter->count(name))
+                        ret.insert(name);
+                return ColumnNames{ ret };
+            },
+            [&] (const plan::Sort &sort)
+            {
+                for(auto &key : sort.keys)
+                    addTo(neededAfter, { key.columnName });
+                return neededAfter;
+            },
+            [&] (const plan::Limit &) { return neededAfter; },
+            [&] (const plan::Aggregate &aggregate)
+            {
+                std::set<std::string> ret{ aggregate.keyColumnName };
+                for(auto &[name, functions] : aggregate.aggregates)
+                    ret.insert(name);
+                return ColumnNames{ ret };
+            }
+            }, node);
+    }
+
+    std::vector<Step> optimize(const QueryPlan &plan)
+    {
+        auto nodes = linearize(plan);
+        pushDownLimits(nodes);
+
+        std::vector<Step> ret(nodes.size());
+        ColumnNames needed; // everything is needed at the end
+        for(auto i = nodes.size(); i-- > 0; )
+        {
+            ret[i].liveAfter = needed;
+            needed = neededBefore(nodes[i], needed);
+            ret[i].liveBefore = needed;
+            ret[i].node = std::move(nodes[i]);
+        }
+        return ret;
+    }
+
+    std::shared_ptr<arrow::Table> project(const std::shared_ptr<arrow::Table> &table, const ColumnNames &names)
+    {
+        if(!names)
+            return table;
+
+        std::vector<std::shared_ptr<arrow::Column>> columns;
+        for(auto &column : getColumns(*table))
+            if(names->count(column->name()))
+                columns.push_back(column);
+
+        // table without columns would lose its row count
+        if(columns.empty() && table->num_columns())
+            columns.push_back(table->column(0));
+        if((int)columns.size() == table->num_columns())
+            return table;
+        return tableFromColumns(columns, arrow::schema(transformToVector(columns, [] (auto &&column) { return column->field(); })));
+    }
+
+    int64_t countSetBits(const uint8_t *bitmap, int64_t length)
+    {
+        int64_t ret = 0;
+        for(int64_t i = 0; i < length; i++)
+            ret += arrow::BitUtil::GetBit(bitmap, i);
+        return ret;
+    }
+
+    // Rows of the table that passed filters evaluated so far. Filters and maps are evaluated
+    // against the whole table, its rows are compacted only when the next step needs it.
+    struct PendingRows
+    {
+        std::shared_ptr<arrow::Table> table;
+        std::shared_ptr<arrow::Buffer> mask; // nullptr if all rows passed
+        int64_t passedCount = 0;
+
+        // With few rows passing it is cheaper to compact than to keep evaluating the rest.
+        static constexpr int64_t CompactWhenPassedShareBelow = 4; // i.e. below 1/4
+
+        void compact(const ColumnNames &names)
+        {
+            table = project(table, names);
+            if(mask)
+            {
+                table = filter(table, *mask);
+                mask = nullptr;
+            }
+        }
+
+        void addFilter(const std::string &predicateJson, const ColumnNames &liveBefore, const ColumnNames &liveAfter)
+        {
+            // predicate is evaluated also for rows earlier filters rejected, as in addMap
+            if(mask && ast::summarizeExpression(predicateJson.c_str()).divides)
+                compact(liveBefore);
+
+            auto [mapping, predicate] = ast::parsePredicate(*table, predicateJson.c_str());
+            auto newMask = execute(*table, predicate, mapping);
+
+            const auto rowCount = table->num_rows();
+            if(mask)
+            {
+                const auto byteCount = arrow::BitUtil::BytesForBits(rowCount);
+                auto [combined, combinedData] = allocateBuffer<uint8_t>(byteCount);
+                for(int64_t i = 0; i < byteCount; i++)
+                    combinedData[i] = newMask->data()[i] & mask->data()[i];
+                newMask = combined;
+            }
+            mask = newMask;
+            passedCount = countSetBits(mask->data(), rowCount);
+
+            if(passedCount * CompactWhenPassedShareBelow < rowCount)
+                compact(liveAfter);
+            else
+                table = project(table, liveAfter);
+        }
+
+        void addMap(const std::string &namedValuesJson, const ColumnNames &liveBefore, const ColumnNames &liveAfter)
+        {
+            // values for filtered out rows would be computed, that must not crash on e.g. division by zero
+            if(mask && ast::summarizeExpression(namedValuesJson.c_str()).divides)
+                compact(liveBefore);
+
+            auto parsed = ast::parseNamedValues(*table, namedValuesJson.c_str());
+            auto &values = parsed.second;
+            if(liveAfter)
+                values.erase(std::remove_if(values.begin(), values.end(), [&] (auto &&value) { return liveAfter->count(value.name) == 0; }), values.end());
+
+            const auto arrays = execute(*table, values, parsed.first);
+            auto columns = getColumns(*table);
+            for(size_t i = 0; i < values.size(); i++)
+            {
+                const auto field = arrow::field(values[i].name, arrays[i]->type(), arrays[i]->null_count());
+                const auto column = std::make_shared<arrow::Column>(field, arrays[i]);
+                const auto sameName = std::find_if(columns.begin(), columns.end(), [&] (auto &&c) { return c->name() == values[i].name; });
+                if(sameName != columns.end())
+                    *sameName = column;
+                else
+                    columns.push_back(column);
+            }
+            table = project(tableFromColumns(columns), liveAfter);
+        }
+
+        void addLimit(int64_t count)
+        {
+            if(!mask)
+            {
+                table = slice(table, 0, std::min(count, table->num_rows()));
+                return;
+            }
+
+            // rows past the count-th passing one are dropped, the mask stays valid for the rest
+            int64_t end = 0;
+            for(int64_t passed = 0; end < table->num_rows() && passed < count; end++)
+                passed += arrow::BitUtil::GetBit(mask->data(), end);
+            table = slice(table, 0, end);
+            passedCount = std::min(passedCount, count);
+        }
+    };
+
+    std::string describe(const ColumnNames &names)
+    {
+        if(!names)
+            return "all";
+
+        std::string ret;
+        for(auto &name : *names)
+            ret += (ret.empty() ? "" : ", ") + name;
+        return ret;
+    }
+}
+
+QueryPlanPtr planScan(std::shared_ptr<arrow::Table> table)
+{
+    return std::make_shared<QueryPlan>(QueryPlan{ nullptr, plan::Scan{ std::move(table) } });
+}
+
+QueryPlanPtr planFilter(QueryPlanPtr input, std::string predicateJson)
+{
+    ast::summarizeExpression(predicateJson.c_str()); // fail early on malformed JSON
+    return makePlan(std::move(input), plan::Filter{ std::move(predicateJson) });
+}
+
+QueryPlanPtr planMap(QueryPlanPtr input, std::string namedValuesJson)
+{
+    ast::summarizeExpression(namedValuesJson.c_str());
+    return makePlan(std::move(input), plan::Map{ std::move(namedValuesJson) });
+}
+
+QueryPlanPtr planSelect(QueryPlanPtr input, std::vector<std::string> columnNames)
+{
+    return makePlan(std::move(input), plan::Select{ std::move(columnNames) });
+}
+
+QueryPlanPtr planSort(QueryPlanPtr input, std::vector<plan::SortKey> keys)
+{
+    if(keys.empty())
+        THROW("no column to sort by");
+    return makePlan(std::move(input), plan::Sort{ std::move(keys) });
+}
+
+QueryPlanPtr planLimit(QueryPlanPtr input, int64_t count)
+{
+    if(count < 0)
+        THROW("limit must not be negative, got {}", count);
+    return makePlan(std::move(input), plan::Limit{ count });
+}
+
+QueryPlanPtr planAggregate(QueryPlanPtr input, std::string keyColumnName, std::vector<std::pair<std::string, std::vector<AggregateFunction>>> aggregates)
+{
+    return makePlan(std::move(input), plan::Aggregate{ std::move(keyColumnName), std::move(aggregates) });
+}
+
+std::shared_ptr<arrow::Table> executePlan(const QueryPlan &plan)
+{
+    const auto steps = optimize(plan);
+
+    PendingRows rows;
+    for(auto &step : steps)
+    {
+        checkCancellation();
+        visit(overloaded{
+            [&] (const plan::Scan &scan)
+            {
+                rows.table = project(scan.table, step.liveAfter);
+                rows.passedCount = rows.table->num_rows();
+            },
+            [&] (const plan::Filter &filter)
+            {
+                TRACE_SPAN("plan", "filter");
+                rows.addFilter(filter.predicateJson, step.liveBefore, step.liveAfter);
+            },
+            [&] (const plan::Map &map)
+            {
+                TRACE_SPAN("plan", "map");
+                rows.addMap(map.namedValuesJson, step.liveBefore, step.liveAfter);
+            },
+            [&] (const plan::Select &select)
+            {
+                const auto columns = transformToVector(select.columnNames, [&] (auto &&name) { return getColumn(*rows.table, name); });
+                rows.table = project(tableFromColumns(columns), step.liveAfter);
+            },
+            [&] (const plan::Sort &sort)
+            {
+                TRACE_SPAN("plan", "sort");
+                rows.compact(step.liveBefore);
+                const auto sortBy = transformToVector(sort.keys, [&] (const plan::SortKey &key)
+                {
+                    return SortBy{ getColumn(*rows.table, key.columnName), key.order, key.nulls };
+                });
+                rows.table = sort.limit >= 0
+                    ? sortTableTop(rows.table, sortBy, sort.limit)
+                    : sortTable(rows.table, sortBy);
+                rows.table = project(rows.table, step.liveAfter);
+                rows.passedCount = rows.table->num_rows();
+            },
+            [&] (const plan::Limit &limit)
+            {
+                rows.addLimit(limit.count);
+            },
+            [&] (const plan::Aggregate &aggregate)
+            {
+                TRACE_SPAN("plan", "aggregate");
+                rows.compact(step.liveBefore);
+                std::vector<std::pair<std::shared_ptr<arrow::Column>, std::vector<AggregateFunction>>> toAggregate;
+                for(auto &[name, functions] : aggregate.aggregates)
+                    toAggregate.emplace_back(getColumn(*rows.table, name), functions);
+                rows.table = project(abominableGroupAggregate(getColumn(*rows.table, aggregate.keyColumnName), toAggregate), step.liveAfter);
+                rows.passedCount = rows.table->num_rows();
+            }
+            }, step.node);
+    }
+
+    rows.compact(std::nullopt);
+    return rows.table;
+}
+
+std::string explainPlan(const QueryPlan &plan)
+{
+    std::ostringstream out;
+    for(auto &step : optimize(plan))
+    {
+        visit(overloaded{
+            [&] (const plan::Scan &scan)        { out << "scan " << scan.table->num_rows() << " rows"; },
+            [&] (const plan::Filter &filter)    { out << "filter " << filter.predicateJson; },
+            [&] (const plan::Map &map)          { out << "map " << map.namedValuesJson; },
+            [&] (const plan::Select &select)    { out << "select " << select.columnNames.size() << " columns"; },
+            [&] (const plan::Sort &sort)
+            {
+                out << (sort.limit >= 0 ? "top " + std::to_string(sort.limit) : std::string("sort")) << " by";
+                for(auto &key : sort.keys)
+                    out << " " << key.columnName << (key.order == SortOrder::Ascending ? " asc" : " desc");
+            },
+            [&] (const plan::Limit &limit)      { out << "limit " << limit.count; },
+            [&] (const plan::Aggregate &aggregate) { out << "aggregate by " << aggregate.keyColumnName; }
+            }, step.node);
+        out << " -> columns: " << describe(step.liveAfter) << "\n";
+    }
+    return out.str();
+}
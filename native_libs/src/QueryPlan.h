@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "variant.h"
+#include "Core/Common.h"
+#include "Analysis.h"
+#include "Sort.h"
+
+namespace arrow
+{
+    class Table;
+}
+
+// Deferred pipeline of table operations. Building a plan only records operations,
+// executing it runs them after rewriting the plan, so that:
+//  - columns not needed by later operations are dropped as early as possible,
+//    and map values that nothing uses are not evaluated at all;
+//  - consecutive filters and maps are evaluated against the same, not yet filtered
+//    table, with rows compacted once when the pipeline can't be continued this way,
+//    instead of materializing the whole table after each operation;
+//  - limit is moved before maps and turns preceding sort into partial (top-K) sort.
+//
+// Plans are immutable, each builder function returns a new plan sharing its input.
+namespace plan
+{
+    struct Scan
+    {
+        std::shared_ptr<arrow::Table> table;
+    };
+    struct Filter
+    {
+        std::string predicateJson; // LQuery predicate
+    };
+    struct Map
+    {
+        std::string namedValuesJson; // LQuery named values, they replace columns of the same name or are appended
+    };
+    struct Select
+    {
+        std::vector<std::string> columnNames;
+    };
+    struct SortKey
+    {
+        std::string columnName;
+        SortOrder order = SortOrder::Ascending;
+        NullPosition nulls = NullPosition::Before;
+    };
+    struct Sort
+    {
+        std::vector<SortKey> keys;
+        int64_t limit = -1; // set by optimizer when sort is followed by limit
+    };
+    struct Limit
+    {
+        int64_t count;
+    };
+    struct Aggregate
+    {
+        std::string keyColumnName;
+        std::vector<std::pair<std::string, std::vector<AggregateFunction>>> aggregates; // column name => functions
+    };
+
+    using Node = variant<Scan, Filter, Map, Select, Sort, Limit, Aggregate>;
+}
+
+struct QueryPlan
+{
+    std::shared_ptr<const QueryPlan> input; // nullptr only for scan
+    plan::Node node;
+};
+
+using QueryPlanPtr = std::shared_ptr<const QueryPlan>;
+
+DFH_EXPORT QueryPlanPtr planScan(std::shared_ptr<arrow::Table> table);
+DFH_EXPORT QueryPlanPtr planFilter(QueryPlanPtr input, std::string predicateJson);
+DFH_EXPORT QueryPlanPtr planMap(QueryPlanPtr input, std::string namedValuesJson);
+DFH_EXPORT QueryPlanPtr planSelect(QueryPlanPtr input, std::vector<std::string> columnNames);
+DFH_EXPORT QueryPlanPtr planSort(QueryPlanPtr input, std::vector<plan::SortKey> keys);
+DFH_EXPORT QueryPlanPtr planLimit(QueryPlanPtr input, int64_t count);
+DFH_EXPORT QueryPlanPtr planAggregate(QueryPlanPtr input, std::string keyColumnName, std::vector<std::pair<std::string, std::vector<AggregateFunction>>> aggregates);
+
+DFH_EXPORT std::shared_ptr<arrow::Table> executePlan(const QueryPlan &plan);
+DFH_EXPORT std::string explainPlan(const QueryPlan &plan); // steps after optimization, one per line
@@ -0,0 +1,274 @@
+#include "Sampling.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+#include <arrow/array.h>
+#include <arrow/table.h>
+
+#include "Core/ArrowUtilities.h"
+#include "Core/ThreadPool.h"
+
+namespace
+{
+    // SplitMix64 generator. Unlike standard distributions, it gives the same numbers on every platform.
+    struct Random
+    {
+        uint64_t state;
+
+        explicit Random(uint64_t seed)
+            : state(seed)
+        {}
+
+        uint64_t next()
+        {
+            auto z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        // Modulo bias is negligible for bounds far below 2^64.
+        uint64_t below(uint64_t bound)
+        {
+            return next() % bound;
+        }
+    };
+
+    // Independent generator for each part of the work, so that parts can be processed in any order.
+    Random streamFor(uint64_t seed, uint64_t stream)
+    {
+        return Random{ Random{ seed ^ (stream * 0xD1B54A32D192ED03ull) }.next() };
+    }
+
+    void shuffle(int64_t *values, int64_t length, Random &random)
+    {
+        for(auto i = length - 1; i > 0; i--)
+            std::swap(values[i], values[random.below(i + 1)]);
+    }
+
+    // Fixed rather than taken from execution context, as it affects the result.
+    constexpr int64_t BlockSize = 64 * 1024;
+    constexpr int64_t MaxBucketCount = 256;
+
+    void validateFraction(double testFraction)
+    {
+        if(!(testFraction >= 0 && testFraction <= 1))
+            THROW("test fraction must be in [0, 1], got {}", testFraction);
+    }
+
+    // Sweeps rows once, giving both parts in ascending order.
+    SplitIndices splitByMask(const std::vector<uint8_t> &inTest, int64_t testCount)
+    {
+        const auto length = (int64_t)inTest.size();
+        SplitIndices ret;
+        ret.test.reserve(testCount);
+        ret.train.reserve(length - testCount);
+        for(int64_t i = 0; i < length; i++)
+            (inTest[i] ? ret.test : ret.train).push_back(i);
+        return ret;
+    }
+
+    // Dense code of each row's label, in order of first appearance. Null is a label too.
+    std::vector<int32_t> labelCodes(const arrow::Column &labels, int32_t &outLabelCount)
+    {
+        std::vector<int32_t> ret;
+        ret.reserve(labels.length());
+        int32_t nullCode = -1;
+        outLabelCount = 0;
+        const auto onNull = [&]
+        {
+            if(nullCode < 0)
+                nullCode = outLabelCount++;
+            ret.push_back(nullCode);
+        };
+
+        visitType(*labels.type(), [&] (auto id)
+        {
+            if constexpr(id.value == arrow::Type::TIMESTAMP)
+                THROW("timestamp column {} can't be used as labels", labels.name());
+            else
+            {
+                std::unordered_map<typename TypeDescription<id.value>::ObservedType, int32_t> codes;
+                iterateOver<id.value>(labels,
+                    [&] (auto &&label)
+                    {
+                        auto [itr, inserted] = codes.try_emplace(label, outLabelCount);
+                        if(inserted)
+                            outLabelCount++;
+                        ret.push_back(itr->second);
+                    },
+                    onNull);
+            }
+        });
+        return ret;
+    }
+}
+
+// Rows are first sent to random buckets, block by block, then each bucket is shuffled.
+// As each row's bucket is uniform and independent of others, and each bucket gets a
+// uniformly random order, the result is a uniform permutation. Blocks and buckets are
+// processed in parallel.
+Permutation randomPermutation(int64_t length, uint64_t seed)
+{
+    if(length < 0)
+        THROW("permutation length must not be negative, got {}", length);
+
+    Permutation ret(length);
+    if(length <= BlockSize)
+    {
+        std::iota(ret.begin(), ret.end(), 0);
+        auto random = streamFor(seed, 0);
+        shuffle(ret.data(), length, random);
+        return ret;
+    }
+
+    const auto blockCount = (length + BlockSize - 1) / BlockSize;
+    const auto bucketCount = std::min(blockCount, MaxBucketCount);
+    std::vector<uint8_t> bucketOf(length);
+    std::vector<int64_t> positions(blockCount * bucketCount); // counts of [block][bucket], then write positions
+    parallelForEach(blockCount, [&] (int64_t block)
+    {
+        auto random = streamFor(seed, 1 + block);
+        const auto counts = positions.data() + block * bucketCount;
+        for(auto i = block * BlockSize; i < std::min(length, (block + 1) * BlockSize); i++)
+        {
+            bucketOf[i] = (uint8_t)random.below(bucketCount);
+            counts[bucketOf[i]]++;
+        }
+    });
+
+    // buckets are laid out one after another, within each bucket blocks are in order
+    std::vector<int64_t> bucketStarts(bucketCount + 1);
+    int64_t position = 0;
+    for(int64_t bucket = 0; bucket < bucketCount; bucket++)
+    {
+        bucketStarts[bucket] = position;
+        for(int64_t block = 0; block < blockCount; block++)
+        {
+            const auto count = positions[block * bucketCount + bucket];
+            positions[block * bucketCount + bucket] = position;
+            position += count;
+        }
+    }
+    bucketStarts[bucketCount] = length;
+
+    parallelForEach(blockCount, [&] (int64_t block)
+    {
+        const auto nextPosition = positions.data() + block * bucketCount;
+        for(auto i = block * BlockSize; i < std::min(length, (block + 1) * BlockSize); i++)
+            ret[nextPosition[bucketOf[i]]++] = i;
+    });
+    parallelForEach(bucketCount, [&] (int64_t bucket)
+    {
+        auto random = streamFor(seed, 1 + blockCount + bucket);
+        shuffle(ret.data() + bucketStarts[bucket], bucketStarts[bucket + 1] - bucketStarts[bucket], random);
+    });
+    return ret;
+}
+
+SplitIndices trainTestSplit(int64_t length, double testFraction, uint64_t seed)
+{
+    validateFraction(testFraction);
+    const auto testCount = (int64_t)std::ceil(length * testFraction);
+    const auto permutation = randomPermutation(length, seed);
+
+    std::vector<uint8_t> inTest(length);
+    for(int64_t i = 0; i < testCount; i++)
+        inTest[permutation[i]] = true;
+    return splitByMask(inTest, testCount);
+}
+
+SplitIndices stratifiedTrainTestSplit(const arrow::Column &labels, double testFraction, uint64_t seed)
+{
+    validateFraction(testFraction);
+    int32_t labelCount = 0;
+    const auto codes = labelCodes(labels, labelCount);
+    const auto length = (int64_t)codes.size();
+
+    // rows grouped by label (counting sort), then a random part of each group goes to test
+    std::vector<int64_t> groupStarts(labelCount + 1);
+    for(auto code : codes)
+        groupStarts[code + 1]++;
+    std::partial_sum(groupStarts.begin(), groupStarts.end(), groupStarts.begin());
+
+    std::vector<int64_t> grouped(length);
+    auto nextPosition = groupStarts;
+    for(int64_t i = 0; i < length; i++)
+        grouped[nextPosition[codes[i]]++] = i;
+
+    std::vector<uint8_t> inTest(length);
+    int64_t testCount = 0;
+    for(int32_t label = 0; label < labelCount; label++)
+    {
+        const auto group = grouped.data() + groupStarts[label];
+        const auto groupLength = groupStarts[label + 1] - groupStarts[label];
+        const auto groupTestCount = (int64_t)std::llround(groupLength * testFraction);
+
+        auto random = streamFor(seed, label);
+        shuffle(group, groupLength, random);
+        for(int64_t i = 0; i < groupTestCount; i++)
+            inTest[group[i]] = true;
+        testCount += groupTestCount;
+    }
+    return splitByMask(inTest, testCount);
+}
+
+SplitIndices kFoldSplit(int64_t length, int32_t foldCount, int32_t foldIndex, bool shuffle, uint64_t seed)
+{
+    if(foldCount < 2 || foldCount > length)
+        THROW("fold count must be between 2 and row count {}, got {}", length, foldCount);
+    if(foldIndex < 0 || foldIndex >= foldCount)
+        THROW("fold index {} out of range for {} folds", foldIndex, foldCount);
+
+    const auto baseSize = length / foldCount;
+    const auto extraRows = length % foldCount;
+    const auto testStart = foldIndex * baseSize + std::min<int64_t>(foldIndex, extraRows);
+    const auto testEnd = testStart + baseSize + (foldIndex < extraRows);
+
+    if(!shuffle)
+    {
+        SplitIndices ret;
+        ret.test.resize(testEnd - testStart);
+        std::iota(ret.test.begin(), ret.test.end(), testStart);
+        ret.train.resize(length - ret.test.size());
+        std::iota(ret.train.begin(), ret.train.begin() + testStart, 0);
+        std::iota(ret.train.begin() + testStart, ret.train.end(), testEnd);
+        return ret;
+    }
+
+    // all folds of the same seed come from the same permutation, so they don't overlap
+    const auto permutation = randomPermutation(length, seed);
+    std::vector<uint8_t> inTest(length);
+    for(auto i = testStart; i < testEnd; i++)
+        inTest[permutation[i]] = true;
+    return splitByMask(inTest, testEnd - testStart);
+}
+
+std::shared_ptr<arrow::Column> indicesToColumn(const Permutation &indices, std::string name)
+{
+    auto [buffer, data] = allocateBuffer<int64_t>(indices.size());
+    std::copy(indices.begin(), indices.end(), data);
+    auto array = std::make_shared<arrow::Int64Array>(indices.size(), buffer);
+    return toColumn(array, std::move(name));
+}
+
+Permutation indicesFromColumn(const arrow::Column &indices, int64_t rowCount)
+{
+    if(indices.type()->id() != arrow::Type::INT64)
+        THROW("row indices must be int64, column {} has type {}", indices.name(), indices.type()->ToString());
+
+    Permutation ret;
+    ret.reserve(indices.length());
+    iterateOver<arrow::Type::INT64>(indices,
+        [&] (int64_t index)
+        {
+            if(index < 0 || index >= rowCount)
+                THROW("row index {} out of range for {} rows", index, rowCount);
+            ret.push_back(index);
+        },
+        [&] { THROW("row indices must not contain nulls"); });
+    return ret;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "Core/Common.h"
+#include "Sort.h"
+
+namespace arrow
+{
+    class Column;
+}
+
+// Row index sets for sampling and splitting tables. They are meant to be passed to `permute`,
+// so that rows are gathered only when a part is actually needed: e.g. k folds of a wide table
+// are materialized one at a time instead of making k copies upfront.
+//
+// Results depend only on the seed, not on the number of threads used to compute them.
+
+// Uniformly random order of [0, length).
+DFH_EXPORT Permutation randomPermutation(int64_t length, uint64_t seed);
+
+// Both parts list row indices in ascending order, which keeps the gathers sequential.
+struct SplitIndices
+{
+    Permutation train;
+    Permutation test;
+};
+
+// Test part is a random ceil(length * testFraction) rows.
+DFH_EXPORT SplitIndices trainTestSplit(int64_t length, double testFraction, uint64_t seed);
+
+// Each class (null being one too) is split separately, so that classes have the same shares
+// in both parts. Test part gets the fraction of each class, rounded to the nearest row.
+DFH_EXPORT SplitIndices stratifiedTrainTestSplit(const arrow::Column &labels, double testFraction, uint64_t seed);
+
+// Fold foldIndex of foldCount: test part is the foldIndex-th of consecutive parts of rows (after
+// shuffling, if requested), train part is the rest. First length % foldCount folds have an extra row.
+DFH_EXPORT SplitIndices kFoldSplit(int64_t length, int32_t foldCount, int32_t foldIndex, bool shuffle, uint64_t seed);
+
+DFH_EXPORT std::shared_ptr<arrow::Column> indicesToColumn(const Permutation &indices, std::string name = "index");
+DFH_EXPORT Permutation indicesFromColumn(const arrow::Column &indices, int64_t rowCount); // throws if any index is null or not below rowCount
@@ -2,6 +2,7 @@
 
 #include <numeric>
 #include "Core/ArrowUtilities.h"
+#include "Processing.h"
 
 template<typename F>
 auto dispatch(SortOrder order, F &&f)
@@ -44,15 +45,12 @@ struct ColumnPermuter
 
     std::shared_ptr<arrow::Array> operator()() const
     {
-        if(column->length() > std::numeric_limits<int32_t>::max())
-            throw std::runtime_error("not implemented: too big array");
-
         using T = typename TypeDescription<ArrowType::type_id>::StorageValueType;
 
-        const auto length = (int32_t)column->length();
+        const auto length = (int64_t)indices.size(); // partial permutations yield fewer rows
 
         const ChunkAccessor chunks{ *column->data() };
-        if constexpr(!nullable && (id == arrow::Type::INT64 || id == arrow::Type::DOUBLE))
+        if constexpr(!nullable && hasFixedWidthValues<id> && std::is_arithmetic_v<typename TypeDescription<id>::ObservedType>)
         {
             FixedSizeArrayBuilder<id, nullable> b{ type, length };
             {
@@ -116,7 +114,12 @@ std::shared_ptr<arrow::Column> permuteInner(std::shared_ptr<arrow::Column> colum
 std::shared_ptr<arrow::Table> permuteInner(std::shared_ptr<arrow::Table> table, const Permutation &indices)
 {
     auto oldColumns = getColumns(*table);
-    auto newColumns = transformToVector(oldColumns, [&](auto &&col) { return permuteInner(col, indices); });
+    std::vector<std::shared_ptr<arrow::Column>> newColumns(oldColumns.size());
+    parallelForEach(oldColumns.size(), [&] (int64_t i)
+    {
+        TRACE_SPAN("sort", "permute column");
+        newColumns[i] = permuteInner(oldColumns[i], indices);
+    });
     return arrow::Table::Make(table->schema(), newColumns);
 }
 
@@ -128,27 +131,38 @@ bool isPermuteId(const Permutation &indices)
     return true;
 }
 
+// Strict weak ordering of rows by a single sort key.
 template<arrow::Type::type id, bool nullable, SortOrder order, NullPosition nulls>
-void sortPermutationInner(Permutation &indices, const arrow::Column &sortBy)
+struct RowOrder
 {
+    using ElementType = typename TypeDescription<id>::ObservedType;
+    using ActualObservedType = std::conditional_t<nullable, std::optional<ElementType>, ElementType>;
+
     // Note: Measures shown that it is usually much faster to copy data into vector
     // rather than keep it in array and each time lookup index for the given chunk.
     //
     // For now this is simple and fast enough.
-    using ElementType = typename TypeDescription<id>::ObservedType;
-    using ActualObservedType = std::conditional_t<nullable, std::optional<ElementType>, ElementType>;
+    // TODO: special faster path (no-copy) can be provided for single chunk columns
+    // however gains will rather be limited, as sorting and permuting data dominates
+    ScratchVector<ActualObservedType> valuesAsVector;
+
+    explicit RowOrder(const arrow::Column &sortBy)
+    {
+        valuesAsVector.reserve(sortBy.length());
+        for(auto &&chunk : sortBy.data()->chunks())
+            toVector(valuesAsVector, *chunk);
+    }
 
-    const auto compareRawValues = [](ElementType lhs, ElementType rhs)
+    static bool compareRawValues(const ElementType &lhs, const ElementType &rhs)
     {
         if constexpr(order == SortOrder::Ascending)
             return lhs < rhs;
         else
             return lhs > rhs;
-    };
+    }
 
-    const auto compareValues = [=](auto &&lhs, auto &&rhs)
+    static bool compareValues(const ActualObservedType &lhs, const ActualObservedType &rhs)
     {
-
         if constexpr(nullable)
         {
             const auto lhsValid = lhs.has_value();
@@ -168,16 +182,28 @@ void sortPermutationInner(Permutation &indices, const arrow::Column &sortBy)
         {
             return compareRawValues(lhs, rhs);
         }
-    };
+    }
 
-    // TODO: special faster path (no-copy) can be provided for single chunk columns
-    // however gains will rather be limited, as sorting and permuting data dominates
-    const auto valuesAsVector = toVector<ActualObservedType>(sortBy);
+    // a single pass over many rows takes long, so cancellation is checked every few comparisons
+    // (algorithms copy comparators, so the count is kept here and they capture this by reference)
+    static constexpr uint32_t CancellationCheckInterval = 64 * 1024;
+    mutable uint32_t comparisonCount = 0;
+
+    bool operator()(int64_t lhsIndex, int64_t rhsIndex) const
+    {
+        if(++comparisonCount % CancellationCheckInterval == 0)
+            checkCancellation();
+        return compareValues(valuesAsVector[lhsIndex], valuesAsVector[rhsIndex]);
+    }
+};
+
+template<arrow::Type::type id, bool nullable, SortOrder order, NullPosition nulls>
+void sortPermutationInner(Permutation &indices, const arrow::Column &sortBy)
+{
+    const RowOrder<id, nullable, order, nulls> before{ sortBy };
     std::stable_sort(indices.begin(), indices.end(), [&](int64_t lhsIndex, int64_t rhsIndex)
     {
-        const auto &lhs = valuesAsVector[lhsIndex];
-        const auto &rhs = valuesAsVector[rhsIndex];
-        return compareValues(lhs, rhs);
+        return before(lhsIndex, rhsIndex);
     });
 }
 
@@ -199,29 +225,111 @@ void sortPermutation(Permutation &indices, const arrow::Column &sortBy, SortOrde
     });
 }
 
-std::vector<int64_t> sortPermutation(std::vector<SortBy> sortBy)
+// Stable sort of the given rows by all keys, the least significant key being sorted by first.
+void sortPermutation(Permutation &indices, const std::vector<SortBy> &sortBy)
+{
+    for(size_t i = 0; i < sortBy.size(); i++)
+    {
+        checkCancellation();
+        reportProgress((double)i / sortBy.size(), "sorting");
+        TRACE_SPAN("sort", "sort by key");
+        const auto &key = sortBy[sortBy.size() - 1 - i];
+        sortPermutation(indices, *key.column, key.order, key.nulls);
+    }
+}
+
+Permutation sortPermutation(const std::vector<SortBy> &sortBy)
+{
+    if(sortBy.empty())
+        throw std::runtime_error("no column to sort by");
+
+    Permutation indices(sortBy.front().column->length());
+    std::iota(indices.begin(), indices.end(), int64_t{0});
+    sortPermutation(indices, sortBy);
+    return indices;
+}
+
+// Leaves in indices only the rows that may be among the first count ones, judging by the
+// leading key alone. With no further keys these are exactly the first count rows, in order.
+template<arrow::Type::type id, bool nullable, SortOrder order, NullPosition nulls>
+void selectTopInner(Permutation &indices, const arrow::Column &sortBy, int64_t count, bool onlyKey)
+{
+    const RowOrder<id, nullable, order, nulls> before{ sortBy };
+    if(onlyKey)
+    {
+        // ties are broken by the row index, so the result is the same as of the stable sort
+        std::partial_sort(indices.begin(), indices.begin() + count, indices.end(), [&](int64_t lhsIndex, int64_t rhsIndex)
+        {
+            return before(lhsIndex, rhsIndex) || (!before(rhsIndex, lhsIndex) && lhsIndex < rhsIndex);
+        });
+        indices.resize(count);
+        return;
+    }
+
+    if(count == 0)
+    {
+        indices.clear();
+        return;
+    }
+
+    // rows tied with the last selected one on the leading key are kept, further keys decide among them
+    std::nth_element(indices.begin(), indices.begin() + count - 1, indices.end(), [&](int64_t lhsIndex, int64_t rhsIndex)
+    {
+        return before(lhsIndex, rhsIndex);
+    });
+    const auto boundary = indices[count - 1];
+    const auto candidatesEnd = std::partition(indices.begin() + count, indices.end(), [&](int64_t index)
+    {
+        return !before(boundary, index);
+    });
+    indices.resize(candidatesEnd - indices.begin());
+    std::sort(indices.begin(), indices.end()); // stable sort by all keys then breaks ties by the row index
+}
+
+// Indices of the first count rows in the sort order. Rows are selected by the leading key
+// in O(N log count), only the selected ones (and their ties) are then fully sorted.
+Permutation sortPermutationTop(const std::vector<SortBy> &sortBy, int64_t count)
 {
     if(sortBy.empty())
         throw std::runtime_error("no column to sort by");
 
-    Permutation indices = iotaVector<int64_t>(sortBy.front().column->length());
+    Permutation indices(sortBy.front().column->length());
+    std::iota(indices.begin(), indices.end(), int64_t{0});
+    count = std::clamp<int64_t>(count, 0, indices.size());
 
-    std::reverse(sortBy.begin(), sortBy.end());
-    for(auto &sortBy : sortBy)
     {
-        sortPermutation(indices, *sortBy.column, sortBy.order, sortBy.nulls);
+        TRACE_SPAN("sort", "partial sort");
+        const auto &leading = sortBy.front();
+        visitType(*leading.column->type(), [&] (auto id)
+        {
+            dispatch(leading.nulls, [&] (auto nullPosition)
+            {
+                dispatch(leading.order, [&] (auto orderC)
+                {
+                    dispatch(leading.column->null_count() != 0, [&] (auto hasNullsC)
+                    {
+                        selectTopInner<id.value, hasNullsC.value, orderC.value, nullPosition.value>(indices, *leading.column, count, sortBy.size() == 1);
+                    });
+                });
+            });
+        });
     }
 
+    if(sortBy.size() > 1)
+    {
+        sortPermutation(indices, sortBy);
+        indices.resize(count);
+    }
     return indices;
 }
-
 }
 
 
 std::shared_ptr<arrow::Array> permuteToArray(const std::shared_ptr<arrow::Column> &column, const Permutation &indices)
 {
+    // indices may select only some rows, identity prefix is then just a slice
     if(isPermuteId(indices) && column->data()->num_chunks() == 1)
-        return column->data()->chunk(0);
+        return slice(column->data()->chunk(0), 0, indices.size());
 
     return permuteInnerToArray(column, indices);
 }
@@ -229,7 +337,7 @@ std::shared_ptr<arrow::Array> permuteToArray(const std::shared_ptr<arrow::Column
 std::shared_ptr<arrow::Column> permute(const std::shared_ptr<arrow::Column> &column, const Permutation &indices)
 {
     if(isPermuteId(indices))
-        return column;
+        return (int64_t)indices.size() == column->length() ? column : slice(column, 0, indices.size());
 
     return permuteInner(column, indices);
 }
@@ -237,7 +345,7 @@ std::shared_ptr<arrow::Column> permute(const std::shared_ptr<arrow::Column> &col
 std::shared_ptr<arrow::Table> permute(const std::shared_ptr<arrow::Table> &table, const Permutation &indices)
 {
     if(isPermuteId(indices))
-        return table;
+        return (int64_t)indices.size() == table->num_rows() ? table : slice(table, 0, indices.size());
 
     return permuteInner(table, indices);
 }
@@ -245,5 +353,18 @@ std::shared_ptr<arrow::Table> permute(const std::shared_ptr<arrow::Table> &table
 std::shared_ptr<arrow::Table> sortTable(const std::shared_ptr<arrow::Table> &table, const std::vector<SortBy> &sortBy)
 {
     auto permutation = sortPermutation(sortBy);
+    reportProgress(0, "permuting");
     return permute(table, permutation);
 }
+
+std::shared_ptr<arrow::Table> sortTableTop(const std::shared_ptr<arrow::Table> &table, const std::vector<SortBy> &sortBy, int64_t count)
+{
+    if(count >= table->num_rows())
+        return sortTable(table, sortBy);
+
+    auto permutation = sortPermutationTop(sortBy, count);
+    reportProgress(0, "permuting");
+    if(isPermuteId(permutation))
+        return slice(table, 0, permutation.size());
+    return permuteInner(table, permutation);
+}
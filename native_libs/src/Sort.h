@@ -3,6 +3,7 @@
 #include <memory>
 #include <vector>
 #include "Core/Common.h"
+#include "Core/ScratchArena.h"
 
 namespace arrow
 {
@@ -22,7 +23,7 @@ enum class NullPosition : uint8_t
     Before, After
 };
 
-using Permutation = std::vector<int64_t>; // [new index] -> old index
+using Permutation = ScratchVector<int64_t>; // [new index] -> old index, may select only some of the rows
 
 DFH_EXPORT std::shared_ptr<arrow::Array> permuteToArray(const std::shared_ptr<arrow::Column> &column, const Permutation &indices);
 DFH_EXPORT std::shared_ptr<arrow::Column> permute(const std::shared_ptr<arrow::Column> &column, const Permutation &indices);
@@ -41,3 +42,6 @@ struct SortBy
 
 DFH_EXPORT std::shared_ptr<arrow::Table> sortTable(const std::shared_ptr<arrow::Table> &table, const std::vector<SortBy> &sortBy);
 
+// First count rows of the sorted table, without ordering the remaining ones (top-K).
+DFH_EXPORT std::shared_ptr<arrow::Table> sortTableTop(const std::shared_ptr<arrow::Table> &table, const std::vector<SortBy> &sortBy, int64_t count);
+
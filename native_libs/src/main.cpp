@@ -8,14 +8,19 @@
 #include <unordered_set>
 
 #include "Core/ArrowUtilities.h"
+#include "Core/BulkTransfer.h"
 #include "Core/Common.h"
 #include "Core/Error.h"
 #include "Core/Logger.h"
+#include "Core/ScratchArena.h"
 #include "Analysis.h"
 #include "Processing.h"
+#include "QueryPlan.h"
+#include "Sampling.h"
 #include "Sort.h"
 #include "LifetimeManager.h"
 #include "ValueHolder.h"
+#include "IO/ArrowCData.h"
 #include "IO/csv.h"
 #include "IO/Feather.h"
 #include "IO/IO.h"
@@ -83,8 +88,22 @@ std::shared_ptr<arrow::DataType> idToDataType(arrow::Type::type id)
 {
     switch(id)
     {
+    case arrow::Type::INT8:
+        return getTypeSingleton<arrow::Type::INT8>();
+    case arrow::Type::INT16:
+        return getTypeSingleton<arrow::Type::INT16>();
     case arrow::Type::INT32:
         return getTypeSingleton<arrow::Type::INT32>();
+    case arrow::Type::UINT8:
+        return getTypeSingleton<arrow::Type::UINT8>();
+    case arrow::Type::UINT16:
+        return getTypeSingleton<arrow::Type::UINT16>();
+    case arrow::Type::UINT32:
+        return getTypeSingleton<arrow::Type::UINT32>();
+    case arrow::Type::UINT64:
+        return getTypeSingleton<arrow::Type::UINT64>();
+    case arrow::Type::FLOAT:
+        return getTypeSingleton<arrow::Type::FLOAT>();
     case arrow::Type::INT64:
         return getTypeSingleton<arrow::Type::INT64>();
     case arrow::Type::DOUBLE:
@@ -93,6 +112,8 @@ std::shared_ptr<arrow::DataType> idToDataType(arrow::Type::type id)
         return getTypeSingleton<arrow::Type::STRING>();
     case arrow::Type::TIMESTAMP:
         return getTypeSingleton<arrow::Type::TIMESTAMP>();
+    case arrow::Type::BOOL:
+        return getTypeSingleton<arrow::Type::BOOL>();
     default:
     {
         std::ostringstream out;
@@ -155,6 +176,39 @@ extern "C"
     {
         Logger::instance().enabled.store(verbose);
     }
+    // 0 means using all hardware threads
+    DFH_EXPORT void setThreadCount(int32_t threadCount, const char **outError) noexcept
+    {
+        LOG("{}", threadCount);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            ExecutionContext::setGlobalThreadCount(threadCount);
+        };
+    }
+    DFH_EXPORT int32_t getThreadCount(const char **outError) noexcept
+    {
+        LOG("");
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            return (int32_t)ExecutionContext::global().threadCount;
+        };
+    }
+    DFH_EXPORT void setMorselSize(int64_t morselSize, const char **outError) noexcept
+    {
+        LOG("{}", morselSize);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            ExecutionContext::setGlobalMorselSize(morselSize);
+        };
+    }
+    DFH_EXPORT int64_t getMorselSize(const char **outError) noexcept
+    {
+        LOG("");
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            return ExecutionContext::global().morselSize;
+        };
+    }
 }
 
 // DATATYPE
@@ -272,6 +326,39 @@ extern "C"
     COMMON_BUILDER(String);
     COMMON_BUILDER(TimestampTag);
 
+    // Appends count values, validityBitmap has bit per value (set if valid) and may be null when all are valid.
+#define NUMERIC_BUILDER(TYPENAME) \
+    DFH_EXPORT void builder##TYPENAME##AppendValues(TypeDescriptionForTag<TYPENAME>::BuilderType *builder, const TypeDescriptionForTag<TYPENAME>::CType *values, int64_t count, const uint8_t *validityBitmap, const char **outError) noexcept \
+    {                                                                                                                                                       \
+        LOG("@{}: {} values :: {}", (void*)builder, count, #TYPENAME); \
+        return TRANSLATE_EXCEPTION(outError)                                                                                                               \
+        {                                                                                                                                                   \
+            appendValues(*builder, values, count, validityBitmap);                                                                                         \
+        };                                                                                                                                                   \
+    }
+
+    NUMERIC_BUILDER(UInt8);
+    NUMERIC_BUILDER(UInt16);
+    NUMERIC_BUILDER(UInt32);
+    NUMERIC_BUILDER(UInt64);
+    NUMERIC_BUILDER(Int8);
+    NUMERIC_BUILDER(Int16);
+    NUMERIC_BUILDER(Int32);
+    NUMERIC_BUILDER(Int64);
+    NUMERIC_BUILDER(Float);
+    NUMERIC_BUILDER(Double);
+    NUMERIC_BUILDER(TimestampTag);
+
+    // Appends count strings, i-th one is data[offsets[i], offsets[i+1]) -- so there are count+1 offsets.
+    DFH_EXPORT void builderStringAppendValues(arrow::StringBuilder *builder, const int32_t *offsets, const char *data, int64_t count, const uint8_t *validityBitmap, const char **outError) noexcept
+    {
+        LOG("@{}: {} values", (void*)builder, count);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            appendStrings(*builder, offsets, data, count, validityBitmap);
+        };
+    }
+
     // TODO current string append needlessly allocates std::string for BinaryBuilder::Append argument
 
     DFH_EXPORT int64_t builderLength(arrow::ArrayBuilder *builder) noexcept
@@ -467,6 +554,14 @@ extern "C"
         {                                                                                                                                \
             return asSpecificArray<TYPENAME>(array)->raw_values();                                                                       \
         };                                                                                                                               \
+    }                                                                                                                                    \
+    DFH_EXPORT void array##TYPENAME##CopyValues(arrow::Array *array, int64_t from, int64_t to, TypeDescriptionForTag<TYPENAME>::CType *outValues, const char **outError) noexcept \
+    {                                                                                                                                    \
+        LOG("@{} [{}, {})", (void*)array, from, to);                                                                                     \
+        return TRANSLATE_EXCEPTION(outError)                                                                                             \
+        {                                                                                                                                \
+            copyValues(*asSpecificArray<TYPENAME>(array), from, to, outValues);                                                          \
+        };                                                                                                                               \
     }
 
     NUMERIC_ARRAY_METHODS(UInt8);
@@ -494,6 +589,25 @@ extern "C"
         };
     }
 
+    // Strings [from, to) are copied in two steps: offsets first, so that the caller
+    // learns how big data buffer is needed (the last offset), then the data.
+    DFH_EXPORT int64_t arrayStringCopyOffsets(arrow::Array *array, int64_t from, int64_t to, int32_t *outOffsets, const char **outError) noexcept
+    {
+        LOG("@{} [{}, {})", (void*)array, from, to);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            return copyStringOffsets(*asSpecificArray<String>(array), from, to, outOffsets);
+        };
+    }
+    DFH_EXPORT void arrayStringCopyData(arrow::Array *array, int64_t from, int64_t to, char *outData, const char **outError) noexcept
+    {
+        LOG("@{} [{}, {})", (void*)array, from, to);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            copyStringData(*asSpecificArray<String>(array), from, to, outData);
+        };
+    }
+
 
     // NOTE: needs release
     DFH_EXPORT arrow::Buffer *primitiveArrayValueBuffer(arrow::Array *array, const char **outError) noexcept
@@ -552,6 +666,16 @@ extern "C"
         };
     }
 
+    // Writes validity bitmap of elements [from, to) (bit set if valid), returns null count of the range.
+    DFH_EXPORT int64_t arrayCopyValidity(arrow::Array *array, int64_t from, int64_t to, uint8_t *outBitmap, const char **outError) noexcept
+    {
+        LOG("@{} [{}, {})", (void*)array, from, to);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            return copyValidity(*array, from, to, outBitmap);
+        };
+    }
+
     DFH_EXPORT int64_t arrayLength(arrow::Array *array) noexcept
     {
         LOG("@{}", (void*)array);
@@ -724,10 +848,7 @@ extern "C"
         return TRANSLATE_EXCEPTION(outError)
         {
             const auto length = (to-from) / step;
-            if(length >= std::numeric_limits<int32_t>::max())
-                throw std::runtime_error("not implemented: element count exceeding a single chunk");
-
-            FixedSizeArrayBuilder<arrow::Type::INT64, false> builder{static_cast<int32_t>(length)};
+            FixedSizeArrayBuilder<arrow::Type::INT64, false> builder{length};
             for(int64_t i = from; i < to; i += step)
                 builder.Append(i);
 
@@ -1079,6 +1200,16 @@ extern "C"
             return LifetimeManager::instance().addOwnership(ret);
         };
     }
+    DFH_EXPORT arrow::Table *tableFilterByColumn(arrow::Table *table, arrow::Column *mask, const char **outError) noexcept
+    {
+        LOG("@{} @{}", (void*)table, (void*)mask);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            auto managedTable = LifetimeManager::instance().accessOwned(table);
+            auto ret = filter(managedTable, *mask);
+            return LifetimeManager::instance().addOwnership(ret);
+        };
+    }
     DFH_EXPORT arrow::ChunkedArray *tableMapToChunkedArray(arrow::Table *table, const char *lqueryJSON, const char **outError) noexcept
     {
         LOG("@{} @{}", (void*)table, (void*)lqueryJSON);
@@ -1102,6 +1233,16 @@ extern "C"
             return LifetimeManager::instance().addOwnership(ret);
         };
     }
+    DFH_EXPORT arrow::Table *tableMapToTable(arrow::Table *table, const char *lqueryJSON, bool appendToInput, const char **outError) noexcept
+    {
+        LOG("@{} @{} {}", (void*)table, (void*)lqueryJSON, appendToInput);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            auto managedTable = LifetimeManager::instance().accessOwned(table);
+            auto ret = eachMany(managedTable, lqueryJSON, appendToInput);
+            return LifetimeManager::instance().addOwnership(ret);
+        };
+    }
 //     DFH_EXPORT arrow::Table *tableDropNABy(arrow::Table *table, const int32_t *indices, int32_t columnCount, const char **outError) noexcept
 //     {
 //         LOG("@{} column count={}", (void*)table, columnCount);
@@ -1303,11 +1444,12 @@ extern "C"
     }
 }
 
-arrow::Table *readTableFromCSVFileContentsHelper(std::string data, const char **columnNames, int32_t columnNamesPolicy, int8_t *columnTypes, int8_t *columnIsNullableTypes, int32_t columnTypeInfoCount)
+arrow::Table *readTableFromCSVFileContentsHelper(std::string data, const char **columnNames, int32_t columnNamesPolicy, int8_t *columnTypes, int8_t *columnIsNullableTypes, int32_t columnTypeInfoCount, bool narrowDeducedTypes)
 {
     CsvReadOptions opts;
     opts.header = headerPolicyFromC(columnNamesPolicy, columnNames);
     opts.columnTypes = columnTypesFromC(columnTypeInfoCount, columnTypes, columnIsNullableTypes);
+    opts.narrowDeducedTypes = narrowDeducedTypes;
 
     auto table = FormatCSV{}.readString(std::move(data), opts);
     LOG("table has size {}x{}", table->num_columns(), table->num_rows());
@@ -1315,6 +1457,147 @@ arrow::Table *readTableFromCSVFileContentsHelper(std::string data, const char **
 }
 
 
+// SAMPLING
+extern "C"
+{
+    // Row indices are returned as int64 columns (that need release), tables are gathered
+    // from them only when needed, through tableTakeRows.
+    DFH_EXPORT arrow::Column *randomPermutation(int64_t length, uint64_t seed, const char **outError) noexcept
+    {
+        LOG("length={} seed={}", length, seed);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            return LifetimeManager::instance().addOwnership(indicesToColumn(randomPermutation(length, seed)));
+        };
+    }
+    DFH_EXPORT void trainTestSplit(int64_t length, double testFraction, uint64_t seed, arrow::Column **outTrain, arrow::Column **outTest, const char **outError) noexcept
+    {
+        LOG("length={} test fraction={} seed={}", length, testFraction, seed);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            auto split = trainTestSplit(length, testFraction, seed);
+            *outTrain = LifetimeManager::instance().addOwnership(indicesToColumn(split.train));
+            *outTest = LifetimeManager::instance().addOwnership(indicesToColumn(split.test));
+        };
+    }
+    DFH_EXPORT void stratifiedTrainTestSplit(arrow::Column *labels, double testFraction, uint64_t seed, arrow::Column **outTrain, arrow::Column **outTest, const char **outError) noexcept
+    {
+        LOG("@{} test fraction={} seed={}", (void*)labels, testFraction, seed);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            auto split = stratifiedTrainTestSplit(*labels, testFraction, seed);
+            *outTrain = LifetimeManager::instance().addOwnership(indicesToColumn(split.train));
+            *outTest = LifetimeManager::instance().addOwnership(indicesToColumn(split.test));
+        };
+    }
+    DFH_EXPORT void kFoldSplit(int64_t length, int32_t foldCount, int32_t foldIndex, int8_t shuffle, uint64_t seed, arrow::Column **outTrain, arrow::Column **outTest, const char **outError) noexcept
+    {
+        LOG("length={} fold {} of {} shuffle={} seed={}", length, foldIndex, foldCount, shuffle, seed);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            auto split = kFoldSplit(length, foldCount, foldIndex, shuffle, seed);
+            *outTrain = LifetimeManager::instance().addOwnership(indicesToColumn(split.train));
+            *outTest = LifetimeManager::instance().addOwnership(indicesToColumn(split.test));
+        };
+    }
+    DFH_EXPORT arrow::Table *tableTakeRows(arrow::Table *table, arrow::Column *indices, const char **outError) noexcept
+    {
+        LOG("@{} @{}", (void*)table, (void*)indices);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            auto managedTable = LifetimeManager::instance().accessOwned(table);
+            const auto rowIndices = indicesFromColumn(*indices, managedTable->num_rows());
+            return LifetimeManager::instance().addOwnership(permute(managedTable, rowIndices));
+        };
+    }
+}
+
+// QUERY PLAN
+extern "C"
+{
+    // Plans are built step by step, each call returns a new plan (that needs release)
+    // and leaves the input plan unchanged. Nothing is computed until planExecute.
+    DFH_EXPORT const QueryPlan *planScan(arrow::Table *table, const char **outError) noexcept
+    {
+        LOG("@{}", (void*)table);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            return LifetimeManager::instance().addOwnership(planScan(LifetimeManager::instance().accessOwned(table)));
+        };
+    }
+    DFH_EXPORT const QueryPlan *planFilter(const QueryPlan *plan, const char *lqueryJSON, const char **outError) noexcept
+    {
+        LOG("@{} @{}", (void*)plan, (void*)lqueryJSON);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            return LifetimeManager::instance().addOwnership(planFilter(LifetimeManager::instance().accessOwned(plan), lqueryJSON));
+        };
+    }
+    DFH_EXPORT const QueryPlan *planMap(const QueryPlan *plan, const char *lqueryJSON, const char **outError) noexcept
+    {
+        LOG("@{} @{}", (void*)plan, (void*)lqueryJSON);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            return LifetimeManager::instance().addOwnership(planMap(LifetimeManager::instance().accessOwned(plan), lqueryJSON));
+        };
+    }
+    DFH_EXPORT const QueryPlan *planSelect(const QueryPlan *plan, int32_t columnCount, const char **columnNames, const char **outError) noexcept
+    {
+        LOG("@{} column count={}", (void*)plan, columnCount);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            std::vector<std::string> names(columnNames, columnNames + columnCount);
+            return LifetimeManager::instance().addOwnership(planSelect(LifetimeManager::instance().accessOwned(plan), std::move(names)));
+        };
+    }
+    DFH_EXPORT const QueryPlan *planSort(const QueryPlan *plan, int32_t columnCount, const char **columnNames, SortOrder *columnOrders, NullPosition *nullPositions, const char **outError) noexcept
+    {
+        LOG("@{} column count={}", (void*)plan, columnCount);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            std::vector<plan::SortKey> keys;
+            for(int i = 0; i < columnCount; i++)
+                keys.push_back(plan::SortKey{ columnNames[i], columnOrders[i], nullPositions[i] });
+            return LifetimeManager::instance().addOwnership(planSort(LifetimeManager::instance().accessOwned(plan), std::move(keys)));
+        };
+    }
+    DFH_EXPORT const QueryPlan *planLimit(const QueryPlan *plan, int64_t count, const char **outError) noexcept
+    {
+        LOG("@{} count={}", (void*)plan, count);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            return LifetimeManager::instance().addOwnership(planLimit(LifetimeManager::instance().accessOwned(plan), count));
+        };
+    }
+    DFH_EXPORT const QueryPlan *planAggregate(const QueryPlan *plan, const char *keyColumnName, int32_t aggregatedColumnsCount, const char **aggregatedColumnNames, int8_t *aggregateCountPerColumn, AggregateFunction **aggregatesPerColumn, const char **outError) noexcept
+    {
+        LOG("@{} key={}", (void*)plan, keyColumnName);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            std::vector<std::pair<std::string, std::vector<AggregateFunction>>> aggregates;
+            for(int i = 0; i < aggregatedColumnsCount; i++)
+                aggregates.emplace_back(aggregatedColumnNames[i], vectorFromC(aggregatesPerColumn[i], aggregateCountPerColumn[i]));
+            return LifetimeManager::instance().addOwnership(planAggregate(LifetimeManager::instance().accessOwned(plan), keyColumnName, std::move(aggregates)));
+        };
+    }
+    DFH_EXPORT arrow::Table *planExecute(const QueryPlan *plan, const char **outError) noexcept
+    {
+        LOG("@{}", (void*)plan);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            return LifetimeManager::instance().addOwnership(executePlan(*plan));
+        };
+    }
+    DFH_EXPORT const char *planExplain(const QueryPlan *plan, const char **outError) noexcept
+    {
+        LOG("@{}", (void*)plan);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            return returnedString.store(explainPlan(*plan));
+        };
+    }
+}
+
 // IO
 extern "C"
 {
@@ -1328,23 +1611,24 @@ extern "C"
         };
     }
 
-    DFH_EXPORT arrow::Table *readTableFromCSVFileContents(const char *data, const char **columnNames, int32_t columnNamesPolicy, int8_t *columnTypes, int8_t *columnIsNullableTypes, int32_t columnTypeInfoCount, const char **outError)
+    // narrowDeducedTypes: when non-zero, columns with deduced types use the smallest numeric type holding all their values
+    DFH_EXPORT arrow::Table *readTableFromCSVFileContents(const char *data, const char **columnNames, int32_t columnNamesPolicy, int8_t *columnTypes, int8_t *columnIsNullableTypes, int32_t columnTypeInfoCount, int8_t narrowDeducedTypes, const char **outError)
     {
-        LOG("size={} names={}, namesPolicyCode={}, typeInfoCount={}", std::strlen(data), (void*)columnNames, columnNamesPolicy, columnTypeInfoCount);
+        LOG("size={} names={}, namesPolicyCode={}, typeInfoCount={}, narrow={}", std::strlen(data), (void*)columnNames, columnNamesPolicy, columnTypeInfoCount, narrowDeducedTypes);
         return TRANSLATE_EXCEPTION(outError)
         {
             std::string buffer{ data };
-            return readTableFromCSVFileContentsHelper(std::move(data), columnNames, columnNamesPolicy, columnTypes, columnIsNullableTypes, columnTypeInfoCount);
+            return readTableFromCSVFileContentsHelper(std::move(data), columnNames, columnNamesPolicy, columnTypes, columnIsNullableTypes, columnTypeInfoCount, narrowDeducedTypes != 0);
         };
     }
 
-    DFH_EXPORT arrow::Table *readTableFromCSVFile(const char *filename, const char **columnNames, int32_t columnNamesPolicy, int8_t *columnTypes, int8_t *columnIsNullableTypes, int32_t columnTypeInfoCount, const char **outError)
+    DFH_EXPORT arrow::Table *readTableFromCSVFile(const char *filename, const char **columnNames, int32_t columnNamesPolicy, int8_t *columnTypes, int8_t *columnIsNullableTypes, int32_t columnTypeInfoCount, int8_t narrowDeducedTypes, const char **outError)
     {
-        LOG("@{} names={}, namesPolicyCode={}, typeInfoCount={}", filename, (void*)columnNames, columnNamesPolicy, columnTypeInfoCount);
+        LOG("@{} names={}, namesPolicyCode={}, typeInfoCount={}, narrow={}", filename, (void*)columnNames, columnNamesPolicy, columnTypeInfoCount, narrowDeducedTypes);
         return TRANSLATE_EXCEPTION(outError)
         {
             auto buffer = getFileContents(filename);
-            return readTableFromCSVFileContentsHelper(std::move(buffer ), columnNames, columnNamesPolicy, columnTypes, columnIsNullableTypes, columnTypeInfoCount);
+            return readTableFromCSVFileContentsHelper(std::move(buffer ), columnNames, columnNamesPolicy, columnTypes, columnIsNullableTypes, columnTypeInfoCount, narrowDeducedTypes != 0);
         };
     }
 
@@ -1428,6 +1712,68 @@ extern "C"
     }
 }
 
+// C DATA INTERFACE
+extern "C"
+{
+    // Out structures are allocated by the caller and must be released through their release callback.
+    DFH_EXPORT void arrayExportToC(arrow::Array *array, ArrowArray *outArray, ArrowSchema *outSchema, const char **outError) noexcept
+    {
+        LOG("@{}", (void*)array);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            auto managedArray = LifetimeManager::instance().accessOwned(array);
+            exportField(*arrow::field("", managedArray->type()), outSchema);
+            exportArray(managedArray, outArray);
+        };
+    }
+    DFH_EXPORT void columnExportToC(arrow::Column *column, ArrowArrayStream *outStream, const char **outError) noexcept
+    {
+        LOG("@{}", (void*)column);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            exportColumn(LifetimeManager::instance().accessOwned(column), outStream);
+        };
+    }
+    DFH_EXPORT void tableExportToC(arrow::Table *table, ArrowArrayStream *outStream, const char **outError) noexcept
+    {
+        LOG("@{}", (void*)table);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            exportTable(LifetimeManager::instance().accessOwned(table), outStream);
+        };
+    }
+
+    // Imports take over the given structures, they are left released.
+    // NOTE: needs release
+    DFH_EXPORT arrow::Array *arrayImportFromC(ArrowArray *array, ArrowSchema *schema, const char **outError) noexcept
+    {
+        LOG("@{}", (void*)array);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            const auto field = importField(schema);
+            return LifetimeManager::instance().addOwnership(importArray(array, field->type()));
+        };
+    }
+    // NOTE: needs release
+    DFH_EXPORT arrow::Column *columnImportFromC(ArrowArrayStream *stream, const char **outError) noexcept
+    {
+        LOG("@{}", (void*)stream);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            return LifetimeManager::instance().addOwnership(importColumn(stream));
+        };
+    }
+    // NOTE: needs release
+    DFH_EXPORT arrow::Table *tableImportFromC(ArrowArrayStream *stream, const char **outError) noexcept
+    {
+        LOG("@{}", (void*)stream);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            return LifetimeManager::instance().addOwnership(importTable(stream));
+        };
+    }
+}
+
 // RESOURCE MANAGEMENT
 extern "C"
 {
@@ -1439,5 +1785,211 @@ extern "C"
             LifetimeManager::instance().releaseOwnership(handle);
         };
     }
+
+    DFH_EXPORT void releaseMany(void **handles, int32_t count) noexcept
+    {
+        LOG("@{} count={}", (void*)handles, count);
+        return TRANSLATE_EXCEPTION(nullptr)
+        {
+            LifetimeManager::instance().releaseOwnership(handles, count);
+        };
+    }
+}
+
+
+// MEMORY TRACKING
+namespace
+{
+    // nullptr tag means global statistics
+    AllocationStats allocationStatsFor(const char *tag)
+    {
+        const auto &pool = TrackingMemoryPool::instance();
+        return tag ? pool.tagStats(tag) : pool.globalStats();
+    }
+}
+
+extern "C"
+{
+    DFH_EXPORT int64_t memoryCurrentBytes(const char *tag, const char **outError) noexcept
+    {
+        LOG("{}", tag ? tag : "<global>");
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            return allocationStatsFor(tag).currentBytes;
+        };
+    }
+    DFH_EXPORT int64_t memoryPeakBytes(const char *tag, const char **outError) noexcept
+    {
+        LOG("{}", tag ? tag : "<global>");
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            return allocationStatsFor(tag).peakBytes;
+        };
+    }
+    DFH_EXPORT int64_t memoryTotalBytes(const char *tag, const char **outError) noexcept
+    {
+        LOG("{}", tag ? tag : "<global>");
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            return allocationStatsFor(tag).totalBytes;
+        };
+    }
+    DFH_EXPORT int64_t memoryAllocationCount(const char *tag, const char **outError) noexcept
+    {
+        LOG("{}", tag ? tag : "<global>");
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            return allocationStatsFor(tag).allocationCount;
+        };
+    }
+    DFH_EXPORT int32_t memoryTagCount(const char **outError) noexcept
+    {
+        LOG("");
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            return (int32_t)TrackingMemoryPool::instance().knownTags().size();
+        };
+    }
+    DFH_EXPORT const char *memoryTagName(int32_t index, const char **outError) noexcept
+    {
+        LOG("{}", index);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            const auto tags = TrackingMemoryPool::instance().knownTags();
+            validateIndex(tags, index);
+            return returnedString.store(tags[index]);
+        };
+    }
+    DFH_EXPORT void memoryStatsReset(const char **outError) noexcept
+    {
+        LOG("");
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            TrackingMemoryPool::instance().reset();
+        };
+    }
+    DFH_EXPORT int64_t scratchHighWatermark(const char **outError) noexcept
+    {
+        LOG("");
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            return (int64_t)ScratchArena::highWatermark();
+        };
+    }
+    DFH_EXPORT void setScratchHighWatermark(int64_t bytes, const char **outError) noexcept
+    {
+        LOG("{}", bytes);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            if(bytes < 0)
+                THROW("scratch high watermark must not be negative, got {}", bytes);
+            ScratchArena::setHighWatermark((size_t)bytes);
+        };
+    }
+    DFH_EXPORT int64_t scratchCachedBytes(const char **outError) noexcept
+    {
+        LOG("");
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            return (int64_t)ScratchArena::totalCachedBytes();
+        };
+    }
+}
+
+// CANCELLATION
+extern "C"
+{
+    // NOTE: needs release
+    DFH_EXPORT CancellationToken *cancellationTokenNew(const char **outError) noexcept
+    {
+        LOG("");
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            return LifetimeManager::instance().addOwnership(std::make_shared<CancellationToken>());
+        };
+    }
+    // can be called from any thread, also while the operation is running
+    DFH_EXPORT void cancellationTokenCancel(CancellationToken *token, const char **outError) noexcept
+    {
+        LOG("@{}", (void*)token);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            LifetimeManager::instance().accessOwned(token)->cancel();
+        };
+    }
+    DFH_EXPORT bool cancellationTokenIsCancelled(CancellationToken *token, const char **outError) noexcept
+    {
+        LOG("@{}", (void*)token);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            return LifetimeManager::instance().accessOwned(token)->isCancelled();
+        };
+    }
+    // callback can be null to stop reporting progress
+    DFH_EXPORT void cancellationTokenSetProgressCallback(CancellationToken *token, ProgressCallback callback, void *userData, const char **outError) noexcept
+    {
+        LOG("@{}", (void*)token);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            LifetimeManager::instance().accessOwned(token)->setProgressCallback(callback, userData);
+        };
+    }
+    // Binds the token to the calling thread: all subsequent calls made on this thread will
+    // observe it and fail with "operation was cancelled" error once it is cancelled.
+    // Passing null unbinds.
+    DFH_EXPORT void cancellationTokenBind(CancellationToken *token, const char **outError) noexcept
+    {
+        LOG("@{}", (void*)token);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            CancellationScope::bind(token ? LifetimeManager::instance().accessOwned(token) : nullptr);
+        };
+    }
 }
 
+// TRACING
+extern "C"
+{
+    DFH_EXPORT void traceSetEnabled(bool enabled, const char **outError) noexcept
+    {
+        LOG("{}", enabled);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            Tracing::setEnabled(enabled);
+        };
+    }
+    DFH_EXPORT bool traceIsEnabled(const char **outError) noexcept
+    {
+        LOG("");
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            return Tracing::enabled();
+        };
+    }
+    DFH_EXPORT void traceClear(const char **outError) noexcept
+    {
+        LOG("");
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            Tracing::clear();
+        };
+    }
+    // returns collected spans as Chrome trace-event JSON
+    DFH_EXPORT const char *traceToString(const char **outError) noexcept
+    {
+        LOG("");
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            return returnedString.store(Tracing::toJson());
+        };
+    }
+    DFH_EXPORT void traceWriteToFile(const char *filename, const char **outError) noexcept
+    {
+        LOG("{}", filename);
+        return TRANSLATE_EXCEPTION(outError)
+        {
+            auto out = openFileToWrite(filename);
+            Tracing::writeJson(out);
+        };
+    }
+}
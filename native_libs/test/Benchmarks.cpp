@@ -52,7 +52,7 @@ struct BenchmarkingFixture
 		std::cout << "Run " << measures.size() << " benchmarks:" << std::endl;
 		for(auto &&measure : measures)
 		{
-			std::cout << "  " << measure.name << ":\t" << measure.bestTime().count() / 1000.0 << " ms" << std::endl;
+			std::cout << "  " << measure.name << ":\t" << std::chrono::duration<double, std::milli>(measure.bestTime()).count() << " ms" << std::endl;
 		}
 	}
 };
@@ -1,6 +1,7 @@
 #include "Fixture.h"
 
 #include "Core/ArrowUtilities.h"
+#include <algorithm>
 #include <numeric>
 
 template <typename T>
@@ -64,3 +65,63 @@ std::shared_ptr<arrow::Table> DataGenerator::generateNumericTable(int N)
 
     return tableFromColumns({ intColumn1, intColumn2, intColumn3, intColumn4, doubleColumn1, doubleColumn2, doubleColumn3, doubleColumn4 });
 }
+
+std::shared_ptr<arrow::Column> DataGenerator::generateStringColumn(int64_t N, std::string name, double nullShare, int64_t cardinality, int stringLength)
+{
+    std::uniform_int_distribution<int64_t> valueDistribution{ 0, std::max<int64_t>(cardinality, 1) - 1 };
+    std::bernoulli_distribution nullDistribution{ nullShare };
+
+    arrow::StringBuilder builder{ memoryPool() };
+    checkStatus(builder.Reserve(N));
+    std::string text;
+    for(int64_t i = 0; i < N; i++)
+    {
+        if(nullDistribution(generator))
+        {
+            checkStatus(builder.AppendNull());
+            continue;
+        }
+
+        // distinct values are padded to the same length, so that the length doesn't depend on cardinality
+        text = std::to_string(valueDistribution(generator));
+        if((int)text.size() < stringLength)
+            text.insert(0, stringLength - text.size(), 's');
+        checkStatus(builder.Append(text));
+    }
+
+    const auto arr = finish(builder);
+    return std::make_shared<arrow::Column>(arrow::field(name, arr->type(), arr->null_count()), arr);
+}
+
+std::shared_ptr<arrow::Column> DataGenerator::generateTimestampColumn(int64_t N, std::string name, double nullShare)
+{
+    const auto secondNs = int64_t{ 1'000'000'000 };
+    std::uniform_int_distribution<int64_t> stepDistribution{ secondNs / 2, 3 * secondNs / 2 };
+    auto current = Timestamp{ date::year_month_day{ date::year{ 2000 } / 1 / 1 } }.toStorage();
+    return generateColumn(arrow::Type::TIMESTAMP, N, name, nullShare, [&] (auto &engine)
+    {
+        current += stepDistribution(engine);
+        return current;
+    });
+}
+
+std::shared_ptr<arrow::Table> DataGenerator::generateTable(const GeneratedTableSpec &spec)
+{
+    const auto N = spec.rowCount;
+    const auto nullShareFor = [&] (int index) { return index == 0 ? 0.0 : spec.nullShare; };
+
+    std::vector<std::shared_ptr<arrow::Column>> columns;
+    for(int i = 0; i < spec.intColumns; i++)
+    {
+        std::uniform_int_distribution<int64_t> distribution{ 0, std::max<int64_t>(spec.cardinality, 1) - 1 };
+        columns.push_back(generateColumn(arrow::Type::INT64, N, "int" + std::to_string(i), nullShareFor(i), distribution));
+    }
+    for(int i = 0; i < spec.doubleColumns; i++)
+        columns.push_back(generateColumn(arrow::Type::DOUBLE, N, "double" + std::to_string(i), nullShareFor(i)));
+    for(int i = 0; i < spec.stringColumns; i++)
+        columns.push_back(generateStringColumn(N, "string" + std::to_string(i), nullShareFor(i), spec.cardinality, spec.stringLength));
+    for(int i = 0; i < spec.timestampColumns; i++)
+        columns.push_back(generateTimestampColumn(N, "timestamp" + std::to_string(i), nullShareFor(i)));
+
+    return tableFromColumns(columns);
+}
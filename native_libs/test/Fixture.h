@@ -32,10 +32,26 @@ struct ChunkedFixture
 };
 
 
+// Shape of a synthetic table made by DataGenerator::generateTable.
+struct GeneratedTableSpec
+{
+    int64_t rowCount = 1'000'000;
+    int intColumns = 2;
+    int doubleColumns = 2;
+    int stringColumns = 1;
+    int timestampColumns = 1;
+    double nullShare = 0.1; // applies to all columns but the first of each type
+    int64_t cardinality = 1000; // count of distinct values in int and string columns
+    int stringLength = 16;
+};
+
 struct DataGenerator
 {
     std::mt19937 generator{ std::random_device{}() };
 
+    DataGenerator() = default;
+    explicit DataGenerator(std::mt19937::result_type seed) : generator(seed) {} // gives reproducible data
+
     template<typename Distribution>
     std::shared_ptr<arrow::Column> generateColumn(arrow::Type::type id, int64_t N, std::string name, double nullShare, Distribution distribution)
     {
@@ -68,6 +84,12 @@ struct DataGenerator
 
     std::shared_ptr<arrow::Column> generateColumn(arrow::Type::type id, int64_t N, std::string name, double nullShare = 0.0);
     std::shared_ptr<arrow::Table> generateNumericTable(int N);
+
+    std::shared_ptr<arrow::Column> generateStringColumn(int64_t N, std::string name, double nullShare, int64_t cardinality, int stringLength);
+    std::shared_ptr<arrow::Column> generateTimestampColumn(int64_t N, std::string name, double nullShare); // ascending, about a second apart
+
+    // Columns are named int0, int1, ..., double0, ..., string0, ..., timestamp0, ...
+    std::shared_ptr<arrow::Table> generateTable(const GeneratedTableSpec &spec);
 };
 
 
@@ -1,8 +1,11 @@
 #include <boost/test/unit_test.hpp>
 
 #include "Core/ArrowUtilities.h"
+#include "Python/PythonInterpreter.h"
 #include "../plotter/Matplotlib/Plot.h"
 #include "../learn/Learn.h"
+#include "../learn/Metrics.h"
+#include "../learn/NativeModels.h"
 #include "../learn/SKLearn.h"
 
 BOOST_AUTO_TEST_CASE(DoubleColumnNumpyRoundtrip)
@@ -13,6 +16,74 @@ BOOST_AUTO_TEST_CASE(DoubleColumnNumpyRoundtrip)
     BOOST_CHECK(col->Equals(*col2));
 }
 
+BOOST_AUTO_TEST_CASE(TableToFortranOrderedMatrix)
+{
+    const auto table = tableFromVectors(
+        std::vector<std::optional<int64_t>>{ 1, std::nullopt, 3 },
+        std::vector<std::optional<double>>{ std::nullopt, 2.5, 3.5 },
+        std::vector<double>{ 7, 8, 9 });
+
+    const auto matrix = pybind11::array_t<double>(tableToNpMatrix(*table));
+    BOOST_REQUIRE_EQUAL(matrix.ndim(), 2);
+    BOOST_CHECK_EQUAL(matrix.shape(0), 3);
+    BOOST_CHECK_EQUAL(matrix.shape(1), 3);
+    BOOST_CHECK(matrix.flags() & pybind11::array::f_style);
+
+    const auto at = [&] (int row, int column) { return matrix.at(row, column); };
+    BOOST_CHECK_EQUAL(at(0, 0), 1.0);
+    BOOST_CHECK(std::isnan(at(1, 0)));
+    BOOST_CHECK_EQUAL(at(2, 0), 3.0);
+    BOOST_CHECK(std::isnan(at(0, 1)));
+    BOOST_CHECK_EQUAL(at(1, 1), 2.5);
+    BOOST_CHECK_EQUAL(at(2, 2), 9.0);
+
+    BOOST_CHECK_THROW(tableToNpMatrix(*tableFromVectors(std::vector<std::string>{ "a" })), std::exception);
+}
+
+BOOST_AUTO_TEST_CASE(NumpyToColumnDtypes)
+{
+    PythonInterpreter::instance(); // arrays are created before any library call that would start Python
+    pybind11::array_t<double> doubles(6);
+    for(int i = 0; i < 6; i++)
+        doubles.mutable_at(i) = i == 4 ? std::nan("") : i;
+
+    // contiguous doubles are shared only when requested
+    const auto doublesColumn = npArrayToColumn(doubles, "d", true);
+    const auto doublesChunk = doublesColumn->data()->chunk(0);
+    BOOST_CHECK_EQUAL(static_cast<const void *>(doublesChunk->data()->buffers[1]->data()), doubles.data());
+    BOOST_CHECK_EQUAL_RANGES(toVector<std::optional<double>>(*doublesColumn), std::vector<std::optional<double>>({ 0, 1, 2, 3, std::nullopt, 5 }));
+    const auto copiedColumn = npArrayToColumn(doubles, "d");
+    BOOST_CHECK_NE(static_cast<const void *>(copiedColumn->data()->chunk(0)->data()->buffers[1]->data()), doubles.data());
+    BOOST_CHECK(copiedColumn->Equals(*doublesColumn));
+
+    // big-endian values are converted to native order
+    const pybind11::array bigEndian = doubles.attr("astype")(">f8");
+    BOOST_CHECK_EQUAL_RANGES(toVector<std::optional<double>>(*npArrayToColumn(bigEndian, "d")), std::vector<std::optional<double>>({ 0, 1, 2, 3, std::nullopt, 5 }));
+
+    // no NaNs, no bitmap
+    pybind11::array_t<double> noNaNs(3);
+    std::fill_n(noNaNs.mutable_data(), 3, 1.5);
+    BOOST_CHECK(npArrayToColumn(noNaNs, "d")->data()->chunk(0)->null_bitmap_data() == nullptr);
+
+    // strided view gets copied to be contiguous
+    const pybind11::array strided = doubles[pybind11::slice(0, 6, 2)];
+    BOOST_CHECK_EQUAL_RANGES(toVector<std::optional<double>>(*npArrayToColumn(strided, "s")), std::vector<std::optional<double>>({ 0, 2, std::nullopt }));
+
+    pybind11::array_t<int32_t> ints(3);
+    for(int i = 0; i < 3; i++)
+        ints.mutable_at(i) = 10 * i;
+    const auto intsColumn = npArrayToColumn(ints, "i");
+    BOOST_CHECK_EQUAL(intsColumn->type()->id(), arrow::Type::INT32);
+    BOOST_CHECK_EQUAL_RANGES(toVector<int32_t>(*intsColumn), std::vector<int32_t>({ 0, 10, 20 }));
+
+    pybind11::array_t<bool> bools(10);
+    for(int i = 0; i < 10; i++)
+        bools.mutable_at(i) = i % 3 == 0;
+    const auto boolsColumn = npArrayToColumn(bools, "b");
+    BOOST_CHECK_EQUAL(boolsColumn->type()->id(), arrow::Type::BOOL);
+    BOOST_CHECK_EQUAL_RANGES(toVector<bool>(*boolsColumn), std::vector<bool>({ true, false, false, true, false, false, true, false, false, true }));
+}
+
 struct RegressionFixture
 {
     double coef = 2.0;
@@ -67,4 +138,133 @@ BOOST_FIXTURE_TEST_CASE(LogisticRegression, RegressionFixture)
     auto predictedAt20 = predictAt20(logReg);
     //BOOST_CHECK_EQUAL(predictedAt20, linearMap(20));
 
-}
\ No newline at end of file
+}
+BOOST_FIXTURE_TEST_CASE(NativeLinearRegression, RegressionFixture)
+{
+    learn::LinearRegression model;
+    model.fit(*xs, *ys);
+    BOOST_CHECK(!model.usesFallback());
+    BOOST_REQUIRE_EQUAL(model.coefficients().size(), 1);
+    BOOST_CHECK_CLOSE(model.coefficients()[0], coef, 1e-9);
+    BOOST_CHECK_CLOSE(model.intercept(), intercept, 1e-9);
+    BOOST_CHECK_CLOSE(model.score(*xs, *ys), 1.0, 1e-9);
+    BOOST_CHECK_CLOSE(toVector<double>(*model.predict(*tableFromVectors(newSample))).at(0), linearMap(20), 1e-9);
+
+    // two features, one being a multiple of the other, can't be solved natively
+    learn::LinearRegression collinear;
+    collinear.fit(*tableFromVectors(xsVector, transformToVector(xsVector, [] (double x) { return 2 * x; })), *ys);
+    BOOST_CHECK(collinear.usesFallback());
+
+    // ridge shrinks the coefficient
+    learn::LinearRegression ridge(10.0);
+    ridge.fit(*xs, *ys);
+    BOOST_CHECK_LT(ridge.coefficients()[0], coef);
+
+    // badly scaled features defeat Cholesky, sklearn must then solve the same ridge problem
+    const auto scaledXs = tableFromVectors(std::vector<double>{ 1e10, 2e10, 3e10, 4e10 }, std::vector<double>{ 1, 0, 1, 0 });
+    const auto scaledYs = toColumn<double>({ 1, 2, 4, 3 });
+    learn::LinearRegression scaledRidge(1.0);
+    scaledRidge.fit(*scaledXs, *scaledYs);
+    BOOST_CHECK(scaledRidge.usesFallback());
+    auto sklearnRidge = sklearn::newRidgeRegression(1.0);
+    sklearn::fit(sklearnRidge, *scaledXs, *scaledYs);
+    BOOST_CHECK_EQUAL_RANGES(toVector<double>(*scaledRidge.predict(*scaledXs)), toVector<double>(*sklearn::predict(sklearnRidge, *scaledXs)));
+    BOOST_CHECK_EQUAL(scaledRidge.predictInBatches(*scaledXs, 3)->length(), 4);
+}
+
+BOOST_FIXTURE_TEST_CASE(NativeLogisticRegression, RegressionFixture)
+{
+    std::vector<double> features, labels;
+    for(int i = 1; i <= 10; i++)
+    {
+        features.push_back(i);
+        labels.push_back(i > 5 ? 7.0 : 3.0);
+    }
+
+    learn::LogisticRegression model(1.0);
+    model.fit(*tableFromVectors(features), *toColumn(labels));
+    BOOST_CHECK(!model.usesFallback());
+    BOOST_CHECK_GT(model.coefficients().at(0), 0);
+    // data is symmetric around 5.5, so is the decision boundary
+    BOOST_CHECK_CLOSE(-model.intercept() / model.coefficients().at(0), 5.5, 1e-6);
+    BOOST_CHECK_EQUAL(model.score(*tableFromVectors(features), *toColumn(labels)), 1.0);
+    BOOST_CHECK_EQUAL_RANGES(toVector<double>(*model.predict(*tableFromVectors(features))), labels);
+
+    // more than two classes are handled by sklearn
+    learn::LogisticRegression multiclass(5.25);
+    multiclass.fit(*xs, *ys);
+    BOOST_CHECK(multiclass.usesFallback());
+    BOOST_CHECK_EQUAL(multiclass.predict(*tableFromVectors(newSample))->length(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(OneHotEncoding)
+{
+    const auto column = toColumn<std::optional<std::string>>({ "b", "a", std::nullopt, "b", "c" }, "letter");
+
+    const auto encoded = encodeCategories(*column);
+    BOOST_CHECK_EQUAL_RANGES(encoded.categories, std::vector<std::string>({ "b", "a", "c" }));
+    BOOST_CHECK_EQUAL_RANGES(encoded.codes, std::vector<int32_t>({ 0, 1, -1, 0, 2 }));
+
+    const auto dense = encodeOneHot(*column);
+    BOOST_REQUIRE_EQUAL(dense->num_columns(), 3);
+    BOOST_CHECK_EQUAL(dense->column(1)->name(), "letter: a");
+    BOOST_CHECK_EQUAL_RANGES(toVector<double>(*dense->column(0)), std::vector<double>({ 1, 0, 0, 1, 0 }));
+    BOOST_CHECK_EQUAL_RANGES(toVector<double>(*dense->column(2)), std::vector<double>({ 0, 0, 0, 0, 1 }));
+
+    const auto sparse = encodeOneHotSparse(*column);
+    BOOST_CHECK_EQUAL(sparse.attr("nnz").cast<int64_t>(), 4);
+    const auto shape = sparse.attr("shape").cast<std::pair<int64_t, int64_t>>();
+    BOOST_CHECK_EQUAL(shape.first, 5);
+    BOOST_CHECK_EQUAL(shape.second, 3);
+    BOOST_CHECK_EQUAL(sparse.attr("toarray")().attr("sum")().cast<double>(), 4.0);
+}
+
+BOOST_AUTO_TEST_CASE(ClassificationMetrics)
+{
+    const auto actual = toColumn<std::optional<std::string>>({ "cat", "dog", "cat", "bird", "dog", std::nullopt, "cat" });
+    const auto predicted = toColumn<std::optional<std::string>>({ "cat", "cat", "cat", "bird", "dog", "dog", "dog" });
+
+    const auto matrix = learn::confusionMatrix(*actual, *predicted);
+    BOOST_REQUIRE_EQUAL(matrix.labels.classCount(), 3);
+    BOOST_CHECK_EQUAL_RANGES(get<std::vector<std::string>>(matrix.labels.classes), std::vector<std::string>({ "bird", "cat", "dog" }));
+    // rows are actual classes, the null row is skipped
+    BOOST_CHECK_EQUAL_RANGES(matrix.counts, std::vector<int64_t>({ 1, 0, 0,   0, 2, 1,   0, 1, 1 }));
+
+    const auto table = learn::confusionMatrixTable(matrix);
+    BOOST_REQUIRE_EQUAL(table->num_columns(), 4);
+    BOOST_CHECK_EQUAL(table->column(2)->name(), "cat");
+    BOOST_CHECK_EQUAL_RANGES(toVector<int64_t>(*table->column(2)), std::vector<int64_t>({ 0, 2, 1 }));
+
+    BOOST_CHECK_CLOSE(learn::accuracy(*actual, *predicted), 4.0 / 6, 1e-9);
+
+    const auto metrics = learn::classificationMetrics(*actual, *predicted);
+    const auto [classes, precision, recall, f1, support] = toVectors<std::string, double, double, double, int64_t>(*metrics);
+    BOOST_CHECK_CLOSE(precision[1], 2.0 / 3, 1e-9);
+    BOOST_CHECK_CLOSE(recall[1], 2.0 / 3, 1e-9);
+    BOOST_CHECK_CLOSE(f1[2], 0.5, 1e-9);
+    BOOST_CHECK_EQUAL_RANGES(support, std::vector<int64_t>({ 1, 3, 2 }));
+
+    // numeric labels of different types are compared as numbers
+    BOOST_CHECK_EQUAL(learn::accuracy(*toColumn<int64_t>({ 0, 1, 1 }), *toColumn<double>({ 0.0, 1.0, 0.0 })), 2.0 / 3);
+
+    // three of four positive-negative pairs are ordered correctly, one is tied
+    const auto labels = toColumn<int64_t>({ 0, 0, 1, 1 });
+    const auto scores = toColumn<double>({ 0.1, 0.4, 0.4, 0.8 });
+    BOOST_CHECK_CLOSE(learn::rocAuc(*labels, *scores), 0.875, 1e-9);
+    BOOST_CHECK_THROW(learn::rocAuc(*toColumn<int64_t>({ 1, 1 }), *toColumn<double>({ 0.1, 0.2 })), std::exception);
+}
+
+BOOST_FIXTURE_TEST_CASE(BatchedPrediction, RegressionFixture)
+{
+    auto linReg = sklearn::newLinearRegression();
+    sklearn::fit(linReg, *xs, *ys);
+
+    // 5 rows in batches of 2: two full batches sharing the buffer and a shorter last one
+    const auto whole = toVector<double>(*sklearn::predict(linReg, *xs));
+    const auto batched = sklearn::predict(linReg, *xs, 2);
+    BOOST_CHECK_EQUAL(batched->name(), "Predictions");
+    BOOST_CHECK_EQUAL(batched->null_count(), 0);
+    BOOST_CHECK_EQUAL_RANGES(toVector<double>(*batched), whole);
+
+    BOOST_CHECK_THROW(sklearn::predict(linReg, *xs, 0), std::exception);
+}
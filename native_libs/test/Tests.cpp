@@ -6,26 +6,34 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/algorithm/string.hpp>
 
+#include <atomic>
 #include <chrono>
 #include <fstream>
 #include <numeric>
 #include <random>
+#include <thread>
 
 #include <date/date.h>
 
+#include "IO/ArrowCData.h"
 #include "IO/csv.h"
 #include "IO/IO.h"
 #include "IO/Feather.h"
 #include "Core/ArrowUtilities.h"
 #include "Core/Benchmark.h"
+#include "Core/BulkTransfer.h"
+#include "Core/Error.h"
 #include "optional.h"
 #include "Processing.h"
+#include "QueryPlan.h"
+#include "Sampling.h"
 #include "Sort.h"
 #include "Analysis.h"
 
 #include "Fixture.h"
 #include "Core/Utils.h"
 #include "IO/XLSX.h"
+#include "LifetimeManager.h"
 
 using namespace std::literals;
 using namespace date::literals;
@@ -464,6 +472,35 @@ BOOST_FIXTURE_TEST_CASE(MapTimestampYear, FilteringFixture)
     testMap<std::optional<int64_t>>(jsonQuery, { 2018, 2018, std::nullopt, 2020, std::nullopt });
 }
 
+BOOST_FIXTURE_TEST_CASE(MapToManyColumns, FilteringFixture)
+{
+    // x = a * b, y = a * b + d, z = -a
+    const auto jsonQuery = R"(
+        [
+            {"name": "x", "value": {"operation": "times", "arguments": [{"column": "a"}, {"column": "b"}]}},
+            {"name": "y", "value": {"operation": "plus", "arguments": [
+                {"operation": "times", "arguments": [{"column": "a"}, {"column": "b"}]},
+                {"column": "d"}]}},
+            {"name": "z", "value": {"operation": "negate", "arguments": [{"column": "a"}]}}
+        ])";
+
+    const auto mapped = eachMany(table, jsonQuery);
+    BOOST_REQUIRE_EQUAL(mapped->num_columns(), 3);
+    BOOST_CHECK_EQUAL(mapped->column(0)->name(), "x");
+    BOOST_CHECK_EQUAL(mapped->column(1)->name(), "y");
+    BOOST_CHECK_EQUAL(mapped->column(2)->name(), "z");
+
+    auto [x, y, z] = toVectors<double, std::optional<double>, double>(*mapped);
+    BOOST_CHECK_EQUAL_RANGES(x, std::vector<double>({ -5, 20, 0, 40, -25 }));
+    BOOST_CHECK_EQUAL_RANGES(y, std::vector<std::optional<double>>({ -4, 22, std::nullopt, 44, std::nullopt }));
+    BOOST_CHECK_EQUAL_RANGES(z, std::vector<double>({ 1, -2, -3, 4, -5 }));
+    BOOST_CHECK_EQUAL(mapped->column(0)->null_count(), 0);
+
+    const auto appended = eachMany(table, jsonQuery, true);
+    BOOST_REQUIRE_EQUAL(appended->num_columns(), table->num_columns() + 3);
+    BOOST_CHECK_EQUAL(appended->column(table->num_columns())->name(), "x");
+}
+
 BOOST_FIXTURE_TEST_CASE(FilterGreaterThanLiteral, FilteringFixture)
 {
 	// a > 0
@@ -578,6 +615,62 @@ BOOST_FIXTURE_TEST_CASE(FilterStartsWith3, FilteringFixture)
 	testQuery(jsonQuery, {});
 }
 
+BOOST_FIXTURE_TEST_CASE(FilterEndsWith, FilteringFixture)
+{
+	// c.endsWith "az"
+	const auto jsonQuery = R"(
+		{
+			"predicate": "endsWith",
+			"arguments":
+				[
+					{"column": "c"},
+					"az"
+				]
+		})";
+
+	testQuery(jsonQuery, {2});
+}
+
+BOOST_FIXTURE_TEST_CASE(FilterContains, FilteringFixture)
+{
+	// c.contains "a"
+	testQuery(R"({"predicate": "contains", "arguments": [ {"column": "c"}, "a" ] })", {1, 2});
+	testQuery(R"({"predicate": "contains", "arguments": [ {"column": "c"}, "oo" ] })", {0});
+	testQuery(R"({"predicate": "contains", "arguments": [ {"column": "c"}, "foo bar" ] })", {});
+	testQuery(R"({"predicate": "contains", "arguments": [ {"column": "c"}, "" ] })", {0, 1, 2, 3, 4});
+}
+
+BOOST_AUTO_TEST_CASE(StringPredicateKernels)
+{
+	// long enough to cross byte boundaries of the bitmap and to use multi-word comparisons
+	std::vector<std::string> strings;
+	for(int i = 0; i < 100; i++)
+		strings.push_back(std::string(i % 20, 'x') + (i % 3 ? "needle in a haystack" : "haystack"));
+
+	const auto table = tableFromVectors(strings);
+	const auto check = [&] (const char *predicate, std::string pattern, auto &&expected)
+	{
+		const auto jsonQuery = fmt::format(R"({{"predicate": "{}", "arguments": [ {{"column": "col0"}}, "{}" ] }})", predicate, pattern);
+		const auto filtered = toVector<std::string>(*filter(table, jsonQuery.c_str())->column(0));
+		std::vector<std::string> expectedStrings;
+		for(auto &&s : strings)
+			if(expected(std::string_view(s)))
+				expectedStrings.push_back(s);
+
+		BOOST_TEST_CONTEXT("predicate " << predicate << " with pattern `" << pattern << "`")
+		{
+			BOOST_CHECK_EQUAL_RANGES(filtered, expectedStrings);
+		}
+	};
+
+	const std::string longPattern = "xxxxxneedle in a";
+	check("eq", "xxxneedle in a haystack", [] (std::string_view s) { return s == "xxxneedle in a haystack"; });
+	check("startsWith", longPattern, [&] (std::string_view s) { return s.substr(0, longPattern.size()) == longPattern; });
+	check("endsWith", "a haystack", [] (std::string_view s) { return s.size() >= 10 && s.substr(s.size() - 10) == "a haystack"; });
+	check("contains", "xxneedle", [] (std::string_view s) { return s.find("xxneedle") != std::string_view::npos; });
+	check("contains", "in a hay", [] (std::string_view s) { return s.find("in a hay") != std::string_view::npos; });
+}
+
 BOOST_FIXTURE_TEST_CASE(FilterMatches, FilteringFixture)
 {
 	// c.matches "ba."
@@ -1044,6 +1137,48 @@ BOOST_AUTO_TEST_CASE(MakeNullsArray)
     BOOST_CHECK_EQUAL_RANGES(nullIntsV, nullIntsVExpected);
 }
 
+BOOST_AUTO_TEST_CASE(BulkIteration)
+{
+    // runs of various lengths, crossing 64-bit word boundaries
+    std::vector<std::optional<int64_t>> values;
+    for(int64_t i = 0; i < 1000; i++)
+    {
+        if((i / 7) % 3 == 0 || (i > 300 && i < 500) || i % 97 == 0)
+            values.push_back(std::nullopt);
+        else
+            values.push_back(i);
+    }
+
+    const auto array = toArray(values);
+    for(auto offset : { 0, 3, 64, 129 })
+    {
+        BOOST_TEST_CONTEXT("slice offset " << offset)
+        {
+            const auto sliced = array->Slice(offset);
+            const auto expected = toVector<std::optional<int64_t>>(*sliced);
+
+            std::vector<std::optional<int64_t>> fromRuns;
+            iterateOverRuns<arrow::Type::INT64>(*sliced,
+                [&] (const int64_t *data, int64_t length) { fromRuns.insert(fromRuns.end(), data, data + length); },
+                [&] (int64_t length) { fromRuns.insert(fromRuns.end(), length, std::nullopt); });
+            BOOST_CHECK_EQUAL_RANGES(fromRuns, expected);
+
+            std::vector<std::optional<int64_t>> fromBatches;
+            iterateOverBatches<arrow::Type::INT64>(*sliced, [&] (const int64_t *data, int length, uint64_t validity)
+            {
+                for(int i = 0; i < length; i++)
+                {
+                    if(validity & (uint64_t(1) << i))
+                        fromBatches.push_back(data[i]);
+                    else
+                        fromBatches.push_back(std::nullopt);
+                }
+            });
+            BOOST_CHECK_EQUAL_RANGES(fromBatches, expected);
+        }
+    }
+}
+
 BOOST_AUTO_TEST_CASE(CsvWithUtf8Path)
 {
     using namespace date;
@@ -1122,6 +1257,675 @@ BOOST_AUTO_TEST_CASE(TableFromColumnsWithVaryingLengths)
     BOOST_CHECK_EQUAL_RANGES(doubles2, expectedDoubles2);
 }
 
+BOOST_AUTO_TEST_CASE(ChunkIndexing)
+{
+    std::vector<int64_t> ints{ 0, 1, 2, 3, 4, 5, 6 };
+    const auto array = toArray(ints);
+    const arrow::ChunkedArray chunked{arrow::ArrayVector{array->Slice(0, 2), array->Slice(2, 1), array->Slice(3, 4)}};
+
+    // row indices within chunk must not be truncated to 32 bits
+    const ChunkAccessor accessor{chunked};
+    static_assert(std::is_same_v<decltype(accessor.locate(0).second), int64_t>);
+    static_assert(std::is_same_v<decltype(locateChunk(chunked, 0).second), int64_t>);
+
+    for(int64_t i = 0; i < (int64_t)ints.size(); i++)
+    {
+        const auto [chunk, indexInChunk] = accessor.locate(i);
+        BOOST_CHECK_EQUAL(arrayValueAt<arrow::Type::INT64>(*chunk, indexInChunk), ints[i]);
+        const auto [chunk2, indexInChunk2] = locateChunk(chunked, i);
+        BOOST_CHECK_EQUAL(chunk2.get(), chunk);
+        BOOST_CHECK_EQUAL(indexInChunk2, indexInChunk);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(MemoryTracking)
+{
+    auto &pool = TrackingMemoryPool::instance();
+    const auto globalBefore = pool.globalStats();
+    {
+        MemoryTrackingScope scope{"MemoryTrackingTest"};
+        BOOST_CHECK_EQUAL(MemoryTrackingScope::currentTag(), "MemoryTrackingTest"s);
+
+        auto [buffer, data] = allocateBuffer<int64_t>(1000);
+        const auto stats = pool.tagStats("MemoryTrackingTest");
+        BOOST_CHECK_GE(stats.currentBytes, 8000);
+        BOOST_CHECK_EQUAL(stats.allocationCount, 1);
+        BOOST_CHECK_GE(pool.globalStats().totalBytes, globalBefore.totalBytes + 8000);
+
+        const auto tags = pool.knownTags();
+        BOOST_CHECK(std::find(tags.begin(), tags.end(), "MemoryTrackingTest") != tags.end());
+    }
+    BOOST_CHECK(MemoryTrackingScope::currentTag() == nullptr);
+
+    // buffer is released, tag keeps its peak and cumulative stats
+    const auto stats = pool.tagStats("MemoryTrackingTest");
+    BOOST_CHECK_EQUAL(stats.currentBytes, 0);
+    BOOST_CHECK_GE(stats.peakBytes, 8000);
+    BOOST_CHECK_GE(stats.totalBytes, 8000);
+
+    pool.reset();
+    BOOST_CHECK_EQUAL(pool.tagStats("MemoryTrackingTest").totalBytes, 0);
+    BOOST_CHECK_EQUAL(pool.globalStats().totalBytes, 0);
+
+    // buffers outliving reset (including zero-size ones) are still freed to their tag
+    uint8_t *live = nullptr, *empty = nullptr;
+    {
+        MemoryTrackingScope scope{"MemoryTrackingLive"};
+        BOOST_REQUIRE(pool.Allocate(64, &live).ok());
+        BOOST_REQUIRE(pool.Allocate(0, &empty).ok());
+    }
+    pool.reset();
+    BOOST_CHECK_EQUAL(pool.tagStats("MemoryTrackingLive").currentBytes, 64);
+    pool.Free(empty, 0);
+    pool.Free(live, 64);
+    BOOST_CHECK_EQUAL(pool.tagStats("MemoryTrackingLive").currentBytes, 0);
+    pool.reset();
+    const auto tags = pool.knownTags();
+    BOOST_CHECK(std::find(tags.begin(), tags.end(), "MemoryTrackingLive") == tags.end());
+
+    // allocations made by workers are accounted to the tag of the calling thread
+    {
+        MemoryTrackingScope scope{"MemoryTrackingParallel"};
+        parallelForEach(64, [] (int64_t) { allocateBuffer<int64_t>(100); });
+    }
+    BOOST_CHECK_EQUAL(pool.tagStats("MemoryTrackingParallel").allocationCount, 64);
+    BOOST_CHECK_EQUAL(pool.tagStats("MemoryTrackingParallel").currentBytes, 0);
+}
+
+BOOST_AUTO_TEST_CASE(InterpreterOutputOutlivesScratch)
+{
+    // values are computed from scratch memory, except the output columns, that must come from the tracked pool
+    std::vector<int64_t> ints(10000);
+    std::iota(ints.begin(), ints.end(), 0);
+    const auto table = tableFromVectors(ints);
+    const auto doubled = R"({"operation": "times", "arguments": [{"column": "col0"}, 2]})"s;
+    const auto doubledPlusOne = R"({"operation": "plus", "arguments": [)" + doubled + R"(, 1]})";
+
+    auto &pool = TrackingMemoryPool::instance();
+    MemoryTrackingScope scope{"InterpreterOutputTest"};
+    const auto column = each(table, doubledPlusOne.c_str());
+    BOOST_CHECK_GE(pool.tagStats("InterpreterOutputTest").currentBytes, 80000);
+    BOOST_CHECK_LT(pool.tagStats("InterpreterOutputTest").currentBytes, 160000);
+
+    // second value was already computed as intermediate part of the first one
+    const auto values = R"([{"name": "y", "value": )" + doubledPlusOne + R"(}, {"name": "x", "value": )" + doubled + "}]";
+    const auto result = eachMany(table, values.c_str());
+    BOOST_CHECK_GE(pool.tagStats("InterpreterOutputTest").currentBytes, 240000);
+    BOOST_CHECK_EQUAL(toVector<int64_t>(*getColumn(*result, "x")).at(3), 6);
+    BOOST_CHECK_EQUAL(toVector<int64_t>(*getColumn(*result, "y")).at(3), 7);
+}
+
+BOOST_AUTO_TEST_CASE(ScratchArenaReuse)
+{
+    auto &arena = ScratchArena::local();
+    arena.trim(0);
+
+    const auto size = 3 * ScratchArena::MinCachedSize + 5;
+    auto block = arena.acquire(size);
+    BOOST_CHECK_EQUAL(reinterpret_cast<uintptr_t>(block) % 64, 0);
+    arena.release(block, size);
+    BOOST_CHECK_GE(arena.cachedBytes(), size);
+
+    // block of the same size class is given back
+    auto block2 = arena.acquire(size + 1);
+    BOOST_CHECK_EQUAL(block2, block);
+    BOOST_CHECK_EQUAL(arena.cachedBytes(), 0);
+    arena.release(block2, size + 1);
+
+    auto hugeBlock = arena.acquire(ScratchArena::HugePageSize + 1);
+    BOOST_CHECK_EQUAL(reinterpret_cast<uintptr_t>(hugeBlock) % ScratchArena::HugePageSize, 0);
+    arena.release(hugeBlock, ScratchArena::HugePageSize + 1);
+
+    // going above the high watermark trims the cache
+    const auto previousWatermark = ScratchArena::highWatermark();
+    ScratchArena::setHighWatermark(ScratchArena::HugePageSize);
+    auto another = arena.acquire(size);
+    arena.release(another, size);
+    BOOST_CHECK_LE(arena.cachedBytes(), ScratchArena::HugePageSize / 2);
+
+    // the watermark is shared by all threads, including pool workers
+    parallelForEach(64, [&] (int64_t) { ScratchVector<uint8_t> temporary(size); });
+    BOOST_CHECK_LE(ScratchArena::totalCachedBytes(), ScratchArena::HugePageSize);
+    ScratchArena::setHighWatermark(previousWatermark);
+
+    ScratchVector<int64_t> v(100'000);
+    std::iota(v.begin(), v.end(), 0);
+    BOOST_CHECK_EQUAL(v.back(), 99'999);
+
+    arena.trim(0);
+    BOOST_CHECK_EQUAL(arena.cachedBytes(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(ParallelFor)
+{
+    const auto previousThreadCount = ExecutionContext::global().threadCount;
+    ExecutionContext::setGlobalThreadCount(4);
+
+    const int64_t N = 1'000'003;
+    std::vector<int> visited(N);
+    std::atomic<int64_t> largestMorsel{0}; // Boost checks can't be used on worker threads
+    parallelFor(0, N, 1000, [&] (int64_t from, int64_t to)
+    {
+        auto largest = largestMorsel.load();
+        while(to - from > largest && !largestMorsel.compare_exchange_weak(largest, to - from));
+        for(auto i = from; i < to; i++)
+            visited[i]++;
+    });
+    BOOST_CHECK_LE(largestMorsel.load(), 1000);
+    BOOST_CHECK(std::all_of(visited.begin(), visited.end(), [] (int v) { return v == 1; }));
+
+    // nested calls must not deadlock
+    std::atomic<int64_t> count{0};
+    parallelForEach(16, [&] (int64_t)
+    {
+        parallelFor(0, 10'000, 100, [&] (int64_t from, int64_t to) { count += to - from; });
+    });
+    BOOST_CHECK_EQUAL(count.load(), 160'000);
+
+    BOOST_CHECK_THROW(parallelFor(0, 100, 1, [] (int64_t from, int64_t)
+    {
+        if(from == 50)
+            throw std::runtime_error("failure");
+    }), std::runtime_error);
+
+    {
+        ExecutionContextScope scope{ExecutionContext{1, 10}};
+        BOOST_CHECK_EQUAL(ExecutionContext::current().morselSize, 10);
+        const auto caller = std::this_thread::get_id();
+        parallelFor(0, 100, [&] (int64_t from, int64_t to)
+        {
+            BOOST_CHECK(std::this_thread::get_id() == caller);
+            BOOST_CHECK_EQUAL(to - from, 10);
+        });
+    }
+    BOOST_CHECK(ExecutionContextScope::active() == nullptr);
+
+    // filtering processes columns in parallel
+    std::vector<int64_t> ints{ 1, 2, 3, 4 };
+    std::vector<double> doubles{ 1.0, 2.0, 3.0, 4.0 };
+    std::vector<bool> mask{ true, false, false, true };
+    const auto table = tableFromVectors(ints, doubles);
+    const auto filtered = filter(table, *toColumn(mask));
+    const auto [filteredInts, filteredDoubles] = toVectors<int64_t, double>(*filtered);
+    BOOST_CHECK_EQUAL(filteredInts, (std::vector<int64_t>{ 1, 4 }));
+    BOOST_CHECK_EQUAL(filteredDoubles, (std::vector<double>{ 1.0, 4.0 }));
+
+    ExecutionContext::setGlobalThreadCount(previousThreadCount);
+}
+
+BOOST_AUTO_TEST_CASE(CancellationAndProgress)
+{
+    const auto token = std::make_shared<CancellationToken>();
+    std::vector<std::string> phases;
+    token->setProgressCallback([] (void *userData, double fraction, const char *phase)
+    {
+        BOOST_CHECK(fraction >= 0 && fraction <= 1);
+        static_cast<std::vector<std::string> *>(userData)->push_back(phase);
+    }, &phases);
+
+    std::vector<int64_t> ints{ 3, 1, 2 };
+    const auto table = tableFromVectors(ints);
+    {
+        CancellationScope scope{token};
+        const auto csvTable = FormatCSV{}.readString("a,b\n1,2\n3,4\n", CsvReadOptions{});
+        BOOST_CHECK_EQUAL(csvTable->num_rows(), 2);
+        BOOST_CHECK(std::find(phases.begin(), phases.end(), "parsing") != phases.end());
+        BOOST_CHECK(std::find(phases.begin(), phases.end(), "building columns") != phases.end());
+
+        const auto sorted = sortTable(table, { table->column(0) });
+        BOOST_CHECK_EQUAL(toVector<int64_t>(*sorted->column(0)), (std::vector<int64_t>{ 1, 2, 3 }));
+
+        token->cancel();
+        BOOST_CHECK_THROW(sortTable(table, { table->column(0) }), OperationCancelled);
+        BOOST_CHECK_THROW(parallelFor(0, 10, 1, [] (int64_t, int64_t) {}), OperationCancelled);
+    }
+
+    // token is not bound anymore
+    BOOST_CHECK(CancellationScope::current() == nullptr);
+    BOOST_CHECK_NO_THROW(sortTable(table, { table->column(0) }));
+
+    // callback is not called under the lock, so it can replace itself
+    const auto reentrant = std::make_shared<CancellationToken>();
+    reentrant->setProgressCallback([] (void *userData, double, const char *)
+    {
+        const auto token = static_cast<CancellationToken *>(userData);
+        token->reportProgress(1, "nested"); // dropped, the callback is already running
+        token->setProgressCallback(nullptr, nullptr);
+    }, reentrant.get());
+    reentrant->reportProgress(0.5, "first");
+    BOOST_CHECK_NO_THROW(reentrant->reportProgress(1, "second"));
+}
+
+BOOST_AUTO_TEST_CASE(TracingSpans)
+{
+    std::vector<int64_t> ints{ 3, 1, 2 };
+    const auto table = tableFromVectors(ints);
+
+    Tracing::clear();
+    sortTable(table, { table->column(0) });
+    BOOST_CHECK(Tracing::toJson().find("sort by key") == std::string::npos); // disabled by default
+
+    Tracing::setEnabled(true);
+    sortTable(table, { table->column(0) });
+    FormatCSV{}.readString("a,b\n1,2\n", CsvReadOptions{});
+    Tracing::setEnabled(false);
+
+    const auto json = Tracing::toJson();
+    BOOST_CHECK(json.find("\"traceEvents\"") != std::string::npos);
+    BOOST_CHECK(json.find("\"sort by key\"") != std::string::npos);
+    BOOST_CHECK(json.find("\"permute column\"") != std::string::npos);
+    BOOST_CHECK(json.find("\"cat\":\"csv\"") != std::string::npos);
+
+    Tracing::clear();
+    BOOST_CHECK(Tracing::toJson().find("\"sort by key\"") == std::string::npos);
+
+    // calls as short as element accessors are not traced, spans of exited threads stay until cleared
+    const auto threadCount = [] (const std::string &json)
+    {
+        int ret = 0;
+        for(auto position = json.find("thread_name"); position != std::string::npos; position = json.find("thread_name", position + 1))
+            ret++;
+        return ret;
+    };
+    const char *error = nullptr;
+    Tracing::setEnabled(true);
+    ExceptionHelper{ "shortApiCall", &error } << [] { return 1; };
+    std::thread([] { TRACE_SPAN("test", "worker span"); }).join();
+    Tracing::setEnabled(false);
+
+    const auto withWorker = Tracing::toJson();
+    BOOST_CHECK(withWorker.find("shortApiCall") == std::string::npos);
+    BOOST_CHECK(withWorker.find("\"worker span\"") != std::string::npos);
+    Tracing::clear();
+    BOOST_CHECK_EQUAL(threadCount(Tracing::toJson()), threadCount(withWorker) - 1);
+}
+
+BOOST_AUTO_TEST_CASE(GeneratedDataIsReproducible)
+{
+    GeneratedTableSpec spec;
+    spec.rowCount = 1000;
+    spec.cardinality = 10;
+    spec.stringLength = 8;
+
+    const auto table1 = DataGenerator{ 7 }.generateTable(spec);
+    const auto table2 = DataGenerator{ 7 }.generateTable(spec);
+    BOOST_CHECK(table1->Equals(*table2));
+    BOOST_CHECK(!table1->Equals(*DataGenerator{ 8 }.generateTable(spec)));
+
+    BOOST_CHECK_EQUAL(table1->num_columns(), 6);
+    BOOST_CHECK_EQUAL(table1->column(0)->name(), "int0");
+    BOOST_CHECK_EQUAL(table1->column(0)->null_count(), 0);
+    BOOST_CHECK(table1->column(1)->null_count() > 0);
+    BOOST_CHECK_EQUAL(countValues(*table1->column(0))->num_rows(), 10);
+
+    const auto strings = toVector<std::optional<std::string>>(*table1->column(4));
+    for(auto &s : strings)
+        if(s)
+            BOOST_CHECK_EQUAL(s->size(), 8);
+
+    const auto timestamps = toVector<Timestamp>(*table1->column(5));
+    BOOST_CHECK(std::is_sorted(timestamps.begin(), timestamps.end()));
+}
+
+BOOST_AUTO_TEST_CASE(MeasureSeriesStatistics)
+{
+    MeasureSeries series{"test"};
+    for(auto ms : { 5, 1, 3, 2, 4, 100 })
+        series.add(std::chrono::milliseconds{ms});
+    series.itemsPerIteration = 1000;
+
+    BOOST_CHECK(series.bestTime() == 1ms);
+    BOOST_CHECK(series.medianTime() == 3500us); // mean of the two middle times
+    BOOST_CHECK(series.percentileTime(0.5) == 3ms);
+    BOOST_CHECK(series.percentileTime(0.95) == 100ms);
+    BOOST_CHECK(series.medianAbsoluteDeviation() == 1500us);
+    BOOST_CHECK_CLOSE(series.itemsPerSecond(), 1000 / 0.0035, 1e-9);
+    BOOST_CHECK_EQUAL(series.bytesPerSecond(), 0);
+
+    MicroBenchmarkOptions options;
+    options.warmupIterations = 2;
+    options.iterations = 3;
+    options.minTime = 0ms;
+    int calls = 0;
+    const auto measured = microBenchmark("calls", options, [&] { return ++calls; });
+    BOOST_CHECK_EQUAL(calls, 5);
+    BOOST_CHECK_EQUAL(measured.times.size(), 3);
+    BOOST_CHECK(measured.counters.empty() || measured.counters.size() == 3);
+
+    const auto grid = sweepGrid({ 10, 100 }, { 0.0, 0.5 }, { 1, 2, 4 });
+    BOOST_CHECK_EQUAL(grid.size(), 12);
+    BOOST_CHECK_EQUAL(grid.back().label(), "[size=100 nulls=0.5 chunks=4]");
+}
+
+BOOST_AUTO_TEST_CASE(ArrowCDataRoundTrip)
+{
+    std::vector<std::optional<double>> doubles{ 1.5, std::nullopt, 3.0, -4.25, std::nullopt };
+    auto array = toArray(doubles)->Slice(1);
+    std::weak_ptr<arrow::ArrayData> observer = array->data();
+
+    ArrowSchema schema;
+    ArrowArray exported;
+    exportField(*arrow::field("doubles", array->type()), &schema);
+    exportArray(array, &exported);
+    const auto valuesAddress = rawValues<double>(*array);
+    array.reset();
+    BOOST_CHECK(!observer.expired()); // kept alive by the exported structure
+
+    const auto field = importField(&schema);
+    BOOST_CHECK(!schema.release);
+    BOOST_CHECK_EQUAL(field->name(), "doubles");
+    auto imported = importArray(&exported, field->type());
+    BOOST_CHECK(!exported.release);
+    BOOST_CHECK_EQUAL(rawValues<double>(*imported), valuesAddress); // no copy was made
+    const auto importedValues = toVector<std::optional<double>>(*imported);
+    const auto expectedValues = std::vector<std::optional<double>>(doubles.begin() + 1, doubles.end());
+    BOOST_CHECK_EQUAL_RANGES(importedValues, expectedValues);
+    imported.reset();
+    BOOST_CHECK(observer.expired());
+
+    // columns chunked differently are streamed in aligned batches
+    auto ints = toColumn(std::vector<int64_t>{ 1, 2, 3, 4, 5, 6 }, "ints");
+    auto strings = toColumn(std::vector<std::optional<std::string>>{ "a"s, std::nullopt, "ccc"s, "dd"s, ""s, "f"s }, "strings");
+    const auto stringChunks = strings->data()->chunk(0);
+    strings = toColumn(std::make_shared<arrow::ChunkedArray>(arrow::ArrayVector{ stringChunks->Slice(0, 4), stringChunks->Slice(4) }), "strings");
+    const auto table = tableFromColumns({ ints, strings });
+
+    ArrowArrayStream stream;
+    exportTable(table, &stream);
+    const auto tableBack = importTable(&stream);
+    BOOST_CHECK(!stream.release);
+    BOOST_CHECK(tableBack->schema()->Equals(*table->schema()));
+    BOOST_CHECK_EQUAL(tableBack->column(0)->data()->num_chunks(), 2);
+    auto [intsBack, stringsBack] = toVectors<int64_t, std::optional<std::string>>(*tableBack);
+    auto [intsExpected, stringsExpected] = toVectors<int64_t, std::optional<std::string>>(*table);
+    BOOST_CHECK_EQUAL_RANGES(intsBack, intsExpected);
+    BOOST_CHECK_EQUAL_RANGES(stringsBack, stringsExpected);
+
+    exportColumn(strings, &stream);
+    const auto columnBack = importColumn(&stream);
+    BOOST_CHECK(columnBack->field()->Equals(*strings->field()));
+    const auto columnValues = toVector<std::optional<std::string>>(*columnBack);
+    BOOST_CHECK_EQUAL_RANGES(columnValues, stringsExpected);
+}
+
+BOOST_AUTO_TEST_CASE(QueryPlanMatchesEagerEvaluation)
+{
+    std::vector<int64_t> ints;
+    std::vector<double> doubles;
+    std::vector<std::string> strings;
+    for(int64_t i = 0; i < 1000; i++)
+    {
+        ints.push_back(i);
+        doubles.push_back((i * 7919) % 1000 / 10.0);
+        strings.push_back(std::to_string(i % 13));
+    }
+    const auto table = tableFromVectors(ints, doubles, strings);
+
+    const auto predicate = R"({"predicate": "gt", "arguments": [ {"column": "col0"}, 100 ] })";
+    const auto rarePredicate = R"({"predicate": "lt", "arguments": [ {"column": "col1"}, 5.0 ] })";
+    const auto values = R"([
+        {"name": "x", "value": {"operation": "times", "arguments": [{"column": "col0"}, 2]}},
+        {"name": "unused", "value": {"operation": "negate", "arguments": [{"column": "col1"}]}}
+        ])";
+    const auto sortKey = plan::SortKey{ "col1", SortOrder::Descending };
+
+    // filter, map, sort, limit, select
+    auto eager = filter(filter(table, predicate), rarePredicate);
+    eager = eachMany(eager, values, true);
+    eager = sortTable(eager, { SortBy{ getColumn(*eager, "col1"), SortOrder::Descending } });
+    eager = slice(eager, 0, 10);
+
+    auto lazy = planScan(table);
+    lazy = planFilter(lazy, predicate);
+    lazy = planFilter(lazy, rarePredicate);
+    lazy = planMap(lazy, values);
+    lazy = planSort(lazy, { sortKey });
+    lazy = planLimit(lazy, 20);
+    lazy = planLimit(lazy, 10);
+    lazy = planSelect(lazy, { "x", "col1" });
+
+    const auto result = executePlan(*lazy);
+    BOOST_REQUIRE_EQUAL(result->num_columns(), 2);
+    BOOST_CHECK_EQUAL(result->column(0)->name(), "x");
+    BOOST_CHECK_EQUAL_RANGES(toVector<int64_t>(*result->column(0)), toVector<int64_t>(*getColumn(*eager, "x")));
+    BOOST_CHECK_EQUAL_RANGES(toVector<double>(*result->column(1)), toVector<double>(*getColumn(*eager, "col1")));
+
+    // limits are merged into top-K sort, unused value and string column are never materialized
+    const auto explanation = explainPlan(*lazy);
+    BOOST_CHECK(explanation.find("top 10 by col1 desc") != std::string::npos);
+    BOOST_CHECK(explanation.find("limit") == std::string::npos);
+    BOOST_CHECK(explanation.find("scan 1000 rows -> columns: col0, col1\n") != std::string::npos);
+
+    // limit moves before map
+    auto limited = planLimit(planMap(planScan(table), values), 5);
+    const auto limitedResult = executePlan(*limited);
+    BOOST_CHECK(explainPlan(*limited).find("scan 1000 rows -> columns: all\nlimit 5") == 0);
+    BOOST_CHECK_EQUAL(limitedResult->num_rows(), 5);
+    BOOST_CHECK_EQUAL(limitedResult->num_columns(), table->num_columns() + 2);
+
+    // limit over pending filter keeps only passing rows
+    const auto filteredLimited = executePlan(*planLimit(planFilter(planScan(table), predicate), 3));
+    BOOST_CHECK_EQUAL_RANGES(toVector<int64_t>(*filteredLimited->column(0)), std::vector<int64_t>({ 101, 102, 103 }));
+
+    // filter dividing by a column is not evaluated for rows an earlier filter dropped
+    // (almost all rows pass the first one, so they are not compacted otherwise)
+    const auto positive = R"({"predicate": "gt", "arguments": [ {"column": "col0"}, 0 ] })";
+    const auto divides = R"({"predicate": "gt", "arguments": [ {"operation": "divide", "arguments": [1000, {"column": "col0"}]}, 5 ] })";
+    const auto eagerDivided = filter(filter(table, positive), divides);
+    const auto lazyDivided = executePlan(*planFilter(planFilter(planScan(table), positive), divides));
+    BOOST_CHECK_EQUAL(lazyDivided->num_rows(), 166); // 1000 / x > 5 for x in [1, 166]
+    BOOST_CHECK_EQUAL_RANGES(toVector<int64_t>(*lazyDivided->column(0)), toVector<int64_t>(*eagerDivided->column(0)));
+
+    BOOST_CHECK_THROW(planLimit(planScan(table), -1), std::exception);
+}
+
+BOOST_AUTO_TEST_CASE(SortTableTopMatchesSort)
+{
+    std::vector<int64_t> ints;
+    std::vector<std::optional<double>> doubles;
+    std::vector<std::string> strings;
+    for(int64_t i = 0; i < 1000; i++)
+    {
+        ints.push_back(i);
+        doubles.push_back(i % 11 ? std::optional<double>((i * 7919) % 100 / 10.0) : std::nullopt);
+        strings.push_back(std::to_string(i % 13));
+    }
+    const auto table = tableFromVectors(ints, doubles, strings);
+
+    const std::vector<std::vector<SortBy>> keySets = {
+        { SortBy{ table->column(1), SortOrder::Descending, NullPosition::Before } },
+        { SortBy{ table->column(1), SortOrder::Ascending, NullPosition::After } },
+        { SortBy{ table->column(2), SortOrder::Ascending }, SortBy{ table->column(1), SortOrder::Descending, NullPosition::After } },
+        { SortBy{ table->column(2), SortOrder::Descending } }, // only ties of the leading key, broken by row index
+    };
+    for(auto &keys : keySets)
+    {
+        const auto expected = sortTable(table, keys);
+        for(int64_t count : { 0, 1, 25, 999 })
+        {
+            BOOST_TEST_CONTEXT("key count " << keys.size() << ", top " << count)
+            {
+                const auto top = sortTableTop(table, keys, count);
+                BOOST_REQUIRE_EQUAL(top->num_rows(), count);
+                BOOST_CHECK_EQUAL_RANGES(toVector<int64_t>(*top->column(0)), toVector<int64_t>(*slice(expected, 0, count)->column(0)));
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TrainTestSplitIndices)
+{
+    const auto isPermutation = [] (const Permutation &permutation, int64_t length)
+    {
+        std::vector<int64_t> sorted(permutation.begin(), permutation.end());
+        std::sort(sorted.begin(), sorted.end());
+        std::vector<int64_t> expected(length);
+        std::iota(expected.begin(), expected.end(), 0);
+        return sorted == expected;
+    };
+
+    // long enough to be shuffled in parallel blocks
+    const int64_t length = 300'000;
+    const auto permutation = randomPermutation(length, 7);
+    BOOST_CHECK(isPermutation(permutation, length));
+    BOOST_CHECK(permutation == randomPermutation(length, 7));
+    BOOST_CHECK(permutation != randomPermutation(length, 8));
+    BOOST_CHECK(isPermutation(randomPermutation(1000, 7), 1000));
+
+    const auto split = trainTestSplit(1000, 0.25, 3);
+    BOOST_CHECK_EQUAL(split.test.size(), 250);
+    BOOST_CHECK_EQUAL(split.train.size(), 750);
+    BOOST_CHECK(std::is_sorted(split.test.begin(), split.test.end()));
+    Permutation both(split.train.begin(), split.train.end());
+    both.insert(both.end(), split.test.begin(), split.test.end());
+    BOOST_CHECK(isPermutation(both, 1000));
+    BOOST_CHECK_THROW(trainTestSplit(1000, 1.5, 3), std::exception);
+
+    // 900 "a" and 100 "b" labels keep their shares in both parts
+    std::vector<std::string> labels;
+    for(int i = 0; i < 1000; i++)
+        labels.push_back(i % 10 ? "a" : "b");
+    const auto labelColumn = toColumn(labels);
+    const auto stratified = stratifiedTrainTestSplit(*labelColumn, 0.2, 3);
+    BOOST_CHECK_EQUAL(stratified.test.size(), 200);
+    const auto testBs = std::count_if(stratified.test.begin(), stratified.test.end(), [] (int64_t i) { return i % 10 == 0; });
+    BOOST_CHECK_EQUAL(testBs, 20);
+
+    // test parts of all folds cover every row once
+    std::vector<int64_t> covered;
+    for(int32_t fold = 0; fold < 3; fold++)
+    {
+        const auto foldSplit = kFoldSplit(10, 3, fold, true, 5);
+        BOOST_CHECK_EQUAL(foldSplit.test.size(), fold == 0 ? 4 : 3);
+        BOOST_CHECK_EQUAL(foldSplit.train.size() + foldSplit.test.size(), 10);
+        covered.insert(covered.end(), foldSplit.test.begin(), foldSplit.test.end());
+    }
+    BOOST_CHECK(isPermutation(Permutation(covered.begin(), covered.end()), 10));
+    const auto contiguous = kFoldSplit(10, 3, 1, false, 5);
+    BOOST_CHECK_EQUAL_RANGES(contiguous.test, std::vector<int64_t>({ 4, 5, 6 }));
+    BOOST_CHECK_THROW(kFoldSplit(10, 3, 3, false, 5), std::exception);
+
+    // rows are gathered through index columns, a leading prefix is not mistaken for the whole table
+    const auto table = tableFromVectors(std::vector<int64_t>{ 10, 11, 12, 13, 14 });
+    const auto taken = permute(table, indicesFromColumn(*indicesToColumn(Permutation{ 0, 1, 2 }), table->num_rows()));
+    BOOST_CHECK_EQUAL_RANGES(toVector<int64_t>(*taken->column(0)), std::vector<int64_t>({ 10, 11, 12 }));
+    BOOST_CHECK_THROW(indicesFromColumn(*indicesToColumn(Permutation{ 5 }), table->num_rows()), std::exception);
+}
+
+BOOST_AUTO_TEST_CASE(BulkTransferRoundTrip)
+{
+    std::vector<std::optional<int64_t>> numbers;
+    std::vector<std::optional<std::string>> strings;
+    for(int64_t i = 0; i < 300; i++)
+    {
+        numbers.push_back(i % 3 ? std::optional<int64_t>{i} : std::nullopt);
+        strings.push_back(i % 5 ? std::optional<std::string>{std::to_string(i)} : std::nullopt);
+    }
+
+    // slicing makes arrays start at non-zero offset
+    const int64_t sliceStart = 5, from = 10, to = 150;
+    const auto numbersArray = toArray(numbers)->Slice(sliceStart);
+    const auto stringsArray = std::static_pointer_cast<arrow::StringArray>(toArray(strings)->Slice(sliceStart));
+    const auto expectedNumbers = std::vector<std::optional<int64_t>>(numbers.begin() + sliceStart + from, numbers.begin() + sliceStart + to);
+    const auto expectedStrings = std::vector<std::optional<std::string>>(strings.begin() + sliceStart + from, strings.begin() + sliceStart + to);
+    const auto count = to - from;
+
+    std::vector<int64_t> values(count);
+    copyValues(*numbersArray, from, to, values.data());
+    std::vector<uint8_t> validity(arrow::BitUtil::BytesForBits(count));
+    const auto nullCount = copyValidity(*numbersArray, from, to, validity.data());
+    BOOST_CHECK_EQUAL(nullCount, std::count(expectedNumbers.begin(), expectedNumbers.end(), std::nullopt));
+    for(int64_t i = 0; i < count; i++)
+    {
+        BOOST_CHECK_EQUAL(arrow::BitUtil::GetBit(validity.data(), i), expectedNumbers[i].has_value());
+        if(expectedNumbers[i])
+            BOOST_CHECK_EQUAL(values[i], *expectedNumbers[i]);
+    }
+
+    arrow::Int64Builder numberBuilder;
+    appendValues(numberBuilder, values.data(), count, validity.data());
+    const auto numbersBack = toVector<std::optional<int64_t>>(*finish(numberBuilder));
+    BOOST_CHECK_EQUAL_RANGES(numbersBack, expectedNumbers);
+
+    std::vector<int32_t> offsets(count + 1);
+    const auto dataLength = copyStringOffsets(*stringsArray, from, to, offsets.data());
+    BOOST_CHECK_EQUAL(offsets.front(), 0);
+    BOOST_CHECK_EQUAL(dataLength, stringDataLength(*stringsArray, from, to));
+    std::string data(dataLength, '\0');
+    copyStringData(*stringsArray, from, to, data.data());
+    copyValidity(*stringsArray, from, to, validity.data());
+
+    arrow::StringBuilder stringBuilder;
+    appendStrings(stringBuilder, offsets.data(), data.data(), count, validity.data());
+    const auto stringsBack = toVector<std::optional<std::string>>(*finish(stringBuilder));
+    BOOST_CHECK_EQUAL_RANGES(stringsBack, expectedStrings);
+
+    BOOST_CHECK_THROW(copyValues(*numbersArray, 0, numbersArray->length() + 1, values.data()), std::exception);
+    BOOST_CHECK_THROW(copyValidity(*numbersArray, 10, 5, validity.data()), std::exception);
+}
+
+BOOST_AUTO_TEST_CASE(LifetimeManagerHandles)
+{
+    LifetimeManager manager;
+    auto value = std::make_shared<int>(5);
+    std::weak_ptr<int> observer = value;
+
+    const auto handle = manager.addOwnership(value);
+    BOOST_CHECK_EQUAL(manager.addOwnership(value), handle);
+    BOOST_CHECK_EQUAL(manager.registeredCount(), 1);
+    value.reset();
+
+    manager.releaseOwnership(handle);
+    BOOST_CHECK_EQUAL(*manager.accessOwned(handle), 5);
+    BOOST_CHECK_THROW(manager.accessOwned<double>(static_cast<const void *>(handle)), std::exception);
+    manager.releaseOwnership(handle);
+    BOOST_CHECK(observer.expired());
+    BOOST_CHECK_THROW(manager.accessOwned(handle), std::exception);
+    BOOST_CHECK_THROW(manager.releaseOwnership(handle), std::exception);
+
+    std::vector<std::shared_ptr<int>> values;
+    for(int i = 0; i < 1000; i++)
+        values.push_back(std::make_shared<int>(i));
+    const auto handles = manager.addOwnership(values);
+    BOOST_CHECK_EQUAL(manager.registeredCount(), 1000);
+    for(int i = 0; i < 1000; i++)
+        BOOST_CHECK_EQUAL(*manager.accessOwned(handles[i]), i);
+
+    // unknown handle is reported, yet all the others are released
+    std::vector<const void *> toRelease(handles.begin(), handles.end());
+    toRelease.push_back(&observer);
+    BOOST_CHECK_THROW(manager.releaseOwnership(toRelease.data(), toRelease.size()), std::exception);
+    BOOST_CHECK_EQUAL(manager.registeredCount(), 0);
+
+    // failures are collected, as Boost checks (and exceptions) can't be used on other threads
+    std::vector<std::thread> threads;
+    std::atomic<int> failures{0};
+    for(int t = 0; t < 8; t++)
+    {
+        threads.emplace_back([&, t]
+        {
+            for(int i = 0; i < 1000; i++)
+            {
+                try
+                {
+                    const auto h = manager.addOwnership(std::make_shared<int>(t * 1000 + i));
+                    if(*manager.accessOwned(h) != t * 1000 + i)
+                        ++failures;
+                    manager.releaseOwnership(h);
+                }
+                catch(std::exception &)
+                {
+                    ++failures;
+                }
+            }
+        });
+    }
+    for(auto &thread : threads)
+        thread.join();
+    BOOST_CHECK_EQUAL(failures.load(), 0);
+    BOOST_CHECK_EQUAL(manager.registeredCount(), 0);
+}
+
 BOOST_AUTO_TEST_CASE(Rolling, *boost::unit_test_framework::disabled())
 {
     const date::sys_days day = 2013_y / jan / 01;
@@ -1219,6 +2023,173 @@ BOOST_AUTO_TEST_CASE(RelaxedAggregationRules)
     }
 }
 
+BOOST_AUTO_TEST_CASE(NarrowNumericTypes)
+{
+    const std::vector<std::optional<int32_t>> keys{ 3, 1, std::nullopt, 1, 2 };
+    const std::vector<uint8_t> bytes{ 200, 100, 255, 50, 0 };
+    const std::vector<std::optional<float>> floats{ 0.5f, std::nullopt, 2.0f, 1.5f, -1.0f };
+    const auto table = tableFromColumns({ toColumn(keys, "keys"), toColumn(bytes, "bytes"), toColumn(floats, "floats") });
+    BOOST_CHECK_EQUAL(table->column(0)->type()->id(), arrow::Type::INT32);
+    BOOST_CHECK_EQUAL(table->column(1)->type()->id(), arrow::Type::UINT8);
+    BOOST_CHECK_EQUAL(table->column(2)->type()->id(), arrow::Type::FLOAT);
+
+    // LQuery promotes narrow values to int64, so the sum does not wrap around
+    {
+        const auto jsonQuery = R"(
+            {
+                "predicate": "gt",
+                "arguments": [ {"operation": "plus", "arguments": [ {"column": "bytes"}, 100 ] }, 255 ]
+            })";
+        const auto filtered = filter(table, jsonQuery);
+        const auto [keys2, bytes2, floats2] = toVectors<std::optional<int32_t>, uint8_t, std::optional<float>>(*filtered);
+        const std::vector<uint8_t> expectedBytes{ 200, 255 };
+        const std::vector<std::optional<float>> expectedFloats{ 0.5f, 2.0f };
+        BOOST_CHECK_EQUAL_RANGES(bytes2, expectedBytes);
+        BOOST_CHECK_EQUAL_RANGES(floats2, expectedFloats);
+    }
+
+    // sort and permute keep the column types
+    {
+        const auto sorted = sortTable(table, { { table->column(0), SortOrder::Ascending, NullPosition::Before } });
+        BOOST_CHECK(sorted->schema()->Equals(*table->schema()));
+        const auto [keys2, bytes2, floats2] = toVectors<std::optional<int32_t>, uint8_t, std::optional<float>>(*sorted);
+        const std::vector<uint8_t> expectedBytes{ 255, 100, 50, 0, 200 };
+        BOOST_CHECK_EQUAL_RANGES(bytes2, expectedBytes);
+    }
+
+    // statistics are accumulated using wide types
+    BOOST_CHECK_EQUAL(toVector<int64_t>(*calculateSum(*table->column(1))), std::vector<int64_t>{ 605 });
+    BOOST_CHECK_EQUAL(toVector<double>(*calculateMean(*table->column(2))), std::vector<double>{ 0.75 });
+
+    {
+        const auto aggregated = abominableGroupAggregate(table->column(0), { { table->column(2), { AggregateFunction::Sum } } });
+        const auto [groupKeys, sums] = toVectors<std::optional<int32_t>, double>(*aggregated);
+        const std::vector<std::optional<int32_t>> expectedKeys{ std::nullopt, 3, 1, 2 };
+        const std::vector<double> expectedSums{ 2.0, 0.5, 1.5, -1.0 };
+        BOOST_CHECK_EQUAL_RANGES(groupKeys, expectedKeys);
+        BOOST_CHECK_EQUAL_RANGES(sums, expectedSums);
+    }
+
+    {
+        const auto fillValue = adjustTypeForFilling(int64_t(7), *table->column(0)->type());
+        const auto filled = fillNA(table->column(0), fillValue);
+        BOOST_CHECK_EQUAL(filled->type()->id(), arrow::Type::INT32);
+        BOOST_CHECK_EQUAL(toVector<int32_t>(*filled), (std::vector<int32_t>{ 3, 1, 7, 1, 2 }));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(CsvNarrowDeducedTypes)
+{
+    const auto csv = "a,b,c,d,e\n1,2.5,1000,0.1,x\n-3,0.25,70000,2,y\n"s;
+
+    CsvReadOptions opts;
+    opts.narrowDeducedTypes = true;
+    const auto table = FormatCSV{}.readString(csv, opts);
+    BOOST_REQUIRE_EQUAL(table->num_columns(), 5);
+    BOOST_CHECK_EQUAL(table->column(0)->type()->id(), arrow::Type::INT8);
+    BOOST_CHECK_EQUAL(table->column(1)->type()->id(), arrow::Type::FLOAT);
+    BOOST_CHECK_EQUAL(table->column(2)->type()->id(), arrow::Type::INT32);
+    BOOST_CHECK_EQUAL(table->column(3)->type()->id(), arrow::Type::DOUBLE); // 0.1 is not exact as float
+    BOOST_CHECK_EQUAL(table->column(4)->type()->id(), arrow::Type::STRING);
+
+    const auto [a, b, c] = toVectors<int8_t, float, int32_t>(*table);
+    BOOST_CHECK_EQUAL(a, (std::vector<int8_t>{ 1, -3 }));
+    BOOST_CHECK_EQUAL(b, (std::vector<float>{ 2.5f, 0.25f }));
+    BOOST_CHECK_EQUAL(c, (std::vector<int32_t>{ 1000, 70000 }));
+
+    // narrow columns are written like the wide ones
+    const auto written = FormatCSV{}.writeToString(*table, CsvWriteOptions{});
+    const auto reread = FormatCSV{}.readString(written, CsvReadOptions{});
+    const auto [a2, b2, c2] = toVectors<int64_t, double, int64_t>(*reread);
+    BOOST_CHECK_EQUAL(a2, (std::vector<int64_t>{ 1, -3 }));
+    BOOST_CHECK_EQUAL(b2, (std::vector<double>{ 2.5, 0.25 }));
+    BOOST_CHECK_EQUAL(c2, (std::vector<int64_t>{ 1000, 70000 }));
+}
+
+BOOST_AUTO_TEST_CASE(BooleanColumns)
+{
+    const std::vector<std::optional<bool>> flags{ true, false, std::nullopt, true, false, true };
+    const std::vector<int64_t> values{ 1, 2, 3, 4, 5, 6 };
+    const auto table = tableFromColumns({ toColumn(flags, "flags"), toColumn(values, "values") });
+    BOOST_CHECK_EQUAL(table->column(0)->type()->id(), arrow::Type::BOOL);
+
+    // boolean column used directly as a mask, null is treated as false
+    {
+        const auto filtered = filter(table, *table->column(0));
+        BOOST_CHECK_EQUAL(toVector<int64_t>(*filtered->column(1)), (std::vector<int64_t>{ 1, 4, 6 }));
+        BOOST_CHECK_EQUAL(toVector<bool>(*filtered->column(0)), (std::vector<bool>{ true, true, true }));
+    }
+
+    // boolean column used as LQuery predicate
+    {
+        const auto jsonQuery = R"({"boolean": "not", "arguments": [ {"column": "flags"} ]})";
+        const auto filtered = filter(table, jsonQuery);
+        BOOST_CHECK_EQUAL(toVector<int64_t>(*filtered->column(1)), (std::vector<int64_t>{ 2, 5 }));
+    }
+
+    // predicate evaluated by each yields boolean column
+    {
+        const auto jsonQuery = R"({"predicate": "gt", "arguments": [ {"column": "values"}, 3 ]})";
+        const auto mapped = each(table, jsonQuery);
+        BOOST_CHECK_EQUAL(mapped->type()->id(), arrow::Type::BOOL);
+        BOOST_CHECK_EQUAL(toVector<bool>(*mapped), (std::vector<bool>{ false, false, false, true, true, true }));
+    }
+
+    // in value context booleans are 0/1 integers
+    {
+        const auto jsonQuery = R"({"operation": "plus", "arguments": [ {"column": "flags"}, 1 ]})";
+        const auto mapped = each(table, jsonQuery);
+        BOOST_CHECK_EQUAL(toVector<std::optional<int64_t>>(*mapped), (std::vector<std::optional<int64_t>>{ 2, 1, std::nullopt, 2, 1, 2 }));
+    }
+
+    BOOST_CHECK_EQUAL(toVector<int64_t>(*calculateSum(*table->column(0))), std::vector<int64_t>{ 3 });
+    BOOST_CHECK_EQUAL(toVector<double>(*calculateMean(*table->column(0))), std::vector<double>{ 0.6 });
+
+    {
+        const auto aggregated = abominableGroupAggregate(table->column(0), { { table->column(1), { AggregateFunction::Sum } } });
+        const auto [groupKeys, sums] = toVectors<std::optional<bool>, double>(*aggregated);
+        const std::vector<std::optional<bool>> expectedKeys{ std::nullopt, true, false };
+        const std::vector<double> expectedSums{ 3, 11, 7 };
+        BOOST_CHECK_EQUAL_RANGES(groupKeys, expectedKeys);
+        BOOST_CHECK_EQUAL_RANGES(sums, expectedSums);
+    }
+
+    {
+        const auto sorted = sortTable(table, { { table->column(0), SortOrder::Ascending, NullPosition::After } });
+        BOOST_CHECK_EQUAL(toVector<int64_t>(*sorted->column(1)), (std::vector<int64_t>{ 2, 5, 1, 4, 6, 3 }));
+    }
+
+    {
+        const auto fillValue = adjustTypeForFilling("true"s, *table->column(0)->type());
+        const auto filled = fillNA(table->column(0), fillValue);
+        BOOST_CHECK_EQUAL(filled->type()->id(), arrow::Type::BOOL);
+        BOOST_CHECK_EQUAL(toVector<bool>(*filled), (std::vector<bool>{ true, false, true, true, false, true }));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(CsvBooleanColumns)
+{
+    BOOST_CHECK_EQUAL(deduceType("true"), arrow::Type::BOOL);
+    BOOST_CHECK_EQUAL(deduceType("FALSE"), arrow::Type::BOOL);
+    BOOST_CHECK_EQUAL(deduceType("1"), arrow::Type::INT64);
+
+    const auto csv = "a,b,c\ntrue,False,true\nfalse,,5\n"s;
+    const auto table = FormatCSV{}.readString(csv, CsvReadOptions{});
+    BOOST_REQUIRE_EQUAL(table->num_columns(), 3);
+    BOOST_CHECK_EQUAL(table->column(0)->type()->id(), arrow::Type::BOOL);
+    BOOST_CHECK_EQUAL(table->column(1)->type()->id(), arrow::Type::BOOL);
+    BOOST_CHECK_EQUAL(table->column(2)->type()->id(), arrow::Type::STRING); // mixed with number
+
+    const auto [a, b] = toVectors<bool, std::optional<bool>>(*table);
+    BOOST_CHECK_EQUAL(a, (std::vector<bool>{ true, false }));
+    BOOST_CHECK_EQUAL(b, (std::vector<std::optional<bool>>{ false, std::nullopt }));
+
+    const auto written = FormatCSV{}.writeToString(*table, CsvWriteOptions{});
+    const auto reread = FormatCSV{}.readString(written, CsvReadOptions{});
+    BOOST_CHECK_EQUAL(reread->column(0)->type()->id(), arrow::Type::BOOL);
+    BOOST_CHECK_EQUAL(toVector<bool>(*reread->column(0)), a);
+}
+
 BOOST_AUTO_TEST_CASE(UngroupSimple)
 {
     const auto table = readTableFromFile("data/samples/ungroupable.csv");